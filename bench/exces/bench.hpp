@@ -0,0 +1,260 @@
+/**
+ *  .file bench/exces/bench.hpp
+ *  .brief Minimal benchmark harness with JSON output
+ *
+ *  .author Matus Chochlik
+ *
+ *  Copyright 2012-2014 Matus Chochlik. Distributed under the Boost
+ *  Software License, Version 1.0. (See accompanying file
+ *  LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef EXCES_BENCH_1405181012_HPP
+#define EXCES_BENCH_1405181012_HPP
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <ostream>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <cstdlib>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+namespace bench {
+
+// the result of a single benchmark run
+struct result
+{
+	std::string name;
+	std::size_t entities;
+	std::size_t components;
+	std::size_t threads;
+	std::uint64_t iterations;
+	std::uint64_t operations;
+	std::uint64_t total_ns;
+
+	double ns_per_op(void) const
+	{
+		return operations?double(total_ns)/double(operations):0.0;
+	}
+};
+
+// accumulating stopwatch, the benchmark body starts and stops it
+// around the measured code, leaving setup and cleanup untimed
+class timer
+{
+private:
+	typedef std::chrono::steady_clock _clock;
+	_clock::time_point _start;
+	std::uint64_t _elapsed;
+public:
+	timer(void)
+	 : _elapsed(0)
+	{ }
+
+	void start(void)
+	{
+		_start = _clock::now();
+	}
+
+	void stop(void)
+	{
+		_elapsed += std::uint64_t(
+			std::chrono::duration_cast<std::chrono::nanoseconds>(
+				_clock::now() - _start
+			).count()
+		);
+	}
+
+	std::uint64_t elapsed_ns(void) const
+	{
+		return _elapsed;
+	}
+};
+
+// command-line options
+struct options
+{
+	std::size_t min_entities;
+	std::size_t max_entities;
+	std::uint64_t min_time_ns;
+	std::string output;
+	std::string filter;
+
+	options(void)
+	 : min_entities(1000)
+	 , max_entities(10000000)
+	 , min_time_ns(200000000)
+	{ }
+
+	static void usage(std::ostream& out, const char* self)
+	{
+		out	<< "usage: " << self << " [options]" << std::endl
+			<< "  --min-entities N  smallest entity count (1000)"
+			<< std::endl
+			<< "  --max-entities N  largest entity count (10000000)"
+			<< std::endl
+			<< "  --min-time-ms T   minimal measured time per run (200)"
+			<< std::endl
+			<< "  --filter S        run only benchmarks containing S"
+			<< std::endl
+			<< "  --output FILE     write the JSON report into FILE"
+			<< std::endl;
+	}
+
+	bool parse(int argc, const char** argv)
+	{
+		for(int a=1; a<argc; ++a)
+		{
+			const char* arg = argv[a];
+			const char* val = (a+1<argc)?argv[a+1]:nullptr;
+
+			if(std::strcmp(arg, "--help") == 0)
+			{
+				return false;
+			}
+			if(val == nullptr) return false;
+
+			if(std::strcmp(arg, "--min-entities") == 0)
+				min_entities = std::strtoull(val, nullptr, 10);
+			else if(std::strcmp(arg, "--max-entities") == 0)
+				max_entities = std::strtoull(val, nullptr, 10);
+			else if(std::strcmp(arg, "--min-time-ms") == 0)
+				min_time_ns = std::strtoull(val, nullptr, 10)*1000000;
+			else if(std::strcmp(arg, "--filter") == 0)
+				filter = val;
+			else if(std::strcmp(arg, "--output") == 0)
+				output = val;
+			else return false;
+			++a;
+		}
+		return (min_entities > 0) && (min_entities <= max_entities);
+	}
+};
+
+// runs the benchmarks and collects their results
+class suite
+{
+private:
+	options _opts;
+	std::vector<result> _results;
+
+	static std::string _escape(const std::string& str)
+	{
+		std::string res;
+		for(char c : str)
+		{
+			if((c == '"') || (c == '\\')) res.push_back('\\');
+			res.push_back(c);
+		}
+		return res;
+	}
+public:
+	suite(const options& opts)
+	 : _opts(opts)
+	{ }
+
+	const options& opts(void) const
+	{
+		return _opts;
+	}
+
+	// the tested entity counts (powers of ten)
+	std::vector<std::size_t> entity_counts(void) const
+	{
+		std::vector<std::size_t> result;
+		for(std::size_t n=_opts.min_entities; n<=_opts.max_entities; n*=10)
+		{
+			result.push_back(n);
+		}
+		return result;
+	}
+
+	bool enabled(const std::string& name) const
+	{
+		return name.find(_opts.filter) != std::string::npos;
+	}
+
+	void add(const result& r)
+	{
+		std::cerr
+			<< std::left << std::setw(36) << r.name
+			<< " n=" << std::setw(9) << r.entities
+			<< " c=" << r.components
+			<< " t=" << r.threads
+			<< std::right << std::setw(12) << std::fixed
+			<< std::setprecision(2) << r.ns_per_op() << " ns/op"
+			<< std::endl;
+		_results.push_back(r);
+	}
+
+	// calls body(timer&) until the accumulated time reaches min_time;
+	// each call performs ops operations
+	template <typename Body>
+	void run(
+		const std::string& name,
+		std::size_t entities,
+		std::size_t components,
+		std::uint64_t ops,
+		Body body
+	)
+	{
+		if(!enabled(name)) return;
+
+		timer t;
+		std::uint64_t iterations = 0;
+		do
+		{
+			body(t);
+			++iterations;
+		}
+		while(t.elapsed_ns() < _opts.min_time_ns);
+
+		result r;
+		r.name = name;
+		r.entities = entities;
+		r.components = components;
+		r.threads = 1;
+		r.iterations = iterations;
+		r.operations = iterations*ops;
+		r.total_ns = t.elapsed_ns();
+		add(r);
+	}
+
+	void write_json(std::ostream& out) const
+	{
+		out	<< "{" << std::endl
+			<< "  \"suite\": \"exces-bench\"," << std::endl
+			<< "  \"min_time_ns\": " << _opts.min_time_ns << ","
+			<< std::endl
+			<< "  \"results\": [" << std::endl;
+		for(std::size_t i=0; i!=_results.size(); ++i)
+		{
+			const result& r = _results[i];
+			std::ostringstream ns_per_op;
+			ns_per_op << std::fixed << std::setprecision(3) << r.ns_per_op();
+
+			out	<< "    {"
+				<< "\"name\": \"" << _escape(r.name) << "\", "
+				<< "\"entities\": " << r.entities << ", "
+				<< "\"components\": " << r.components << ", "
+				<< "\"threads\": " << r.threads << ", "
+				<< "\"iterations\": " << r.iterations << ", "
+				<< "\"operations\": " << r.operations << ", "
+				<< "\"total_ns\": " << r.total_ns << ", "
+				<< "\"ns_per_op\": " << ns_per_op.str()
+				<< "}" << ((i+1 != _results.size())?",":"")
+				<< std::endl;
+		}
+		out	<< "  ]" << std::endl
+			<< "}" << std::endl;
+	}
+};
+
+} // namespace bench
+
+#endif //include guard
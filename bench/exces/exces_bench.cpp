@@ -0,0 +1,1066 @@
+/**
+ *  .file bench/exces/exces_bench.cpp
+ *  .brief Benchmarks of the core manager operations
+ *
+ *  .author Matus Chochlik
+ *
+ *  Copyright 2012-2014 Matus Chochlik. Distributed under the Boost
+ *  Software License, Version 1.0. (See accompanying file
+ *  LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+#include "bench.hpp"
+
+#include <exces/group.hpp>
+#include <exces/threads.hpp>
+
+#include <string>
+#include <cstdint>
+
+EXCES_REG_GROUP(bench_std)
+EXCES_REG_GROUP(bench_read_mostly)
+
+namespace exces {
+
+template <>
+struct group_locking<EXCES_GROUP_SEL(bench_std)>
+ : std_component_locking
+{ };
+
+template <>
+struct group_locking<EXCES_GROUP_SEL(bench_read_mostly)>
+ : read_mostly_component_locking
+{ };
+
+} // namespace exces
+
+namespace bench {
+
+struct position { double x, y; };
+struct velocity { double dx, dy; };
+struct mass { double m; };
+struct tag { int kind; };
+
+struct material
+{
+	std::string name;
+
+	material(const std::string& n)
+	 : name(n)
+	{ }
+
+	friend bool operator == (const material& a, const material& b)
+	{
+		return a.name == b.name;
+	}
+
+	friend bool operator < (const material& a, const material& b)
+	{
+		return a.name < b.name;
+	}
+};
+
+struct clock
+{
+	double time, pace;
+
+	clock(void)
+	 : time(0)
+	 , pace(1)
+	{ }
+};
+
+struct counter { std::uint64_t value; };
+
+struct mapped_position { double x, y; };
+
+} // namespace bench
+
+EXCES_REG_COMPONENT(bench::position)
+EXCES_REG_COMPONENT(bench::velocity)
+EXCES_REG_COMPONENT(bench::mass)
+EXCES_REG_COMPONENT(bench::tag)
+EXCES_REG_FLYWEIGHT_COMPONENT(bench::material)
+EXCES_REG_BACKBUF_COMPONENT(bench::clock)
+EXCES_REG_MAPPED_COMPONENT(bench::mapped_position)
+EXCES_REG_COMPONENT_IN_GROUP(bench::counter, bench_std)
+EXCES_REG_COMPONENT_IN_GROUP(bench::counter, bench_read_mostly)
+
+#include <exces/exces.hpp>
+#include <exces/func_adaptors.hpp>
+#include <exces/entity/boost_uuid.hpp>
+#include <exces/implement.hpp>
+
+#include <atomic>
+#include <bitset>
+#include <random>
+#include <thread>
+#include <fstream>
+#include <functional>
+
+namespace bench {
+
+typedef exces::manager<> manager;
+typedef manager::entity_key entity_key;
+typedef exces::entity<>::type entity;
+
+using exces::iter_info;
+using exces::adapt_func;
+
+// prevents the compiler from optimizing the measured loops away
+static volatile double sink = 0;
+
+// visits the indices 0..n-1 in a cache-unfriendly order
+static inline std::size_t scatter(std::size_t i, std::size_t n)
+{
+	return (i*7919) % n;
+}
+
+static void add_components(manager& m, const entity& e, std::size_t k)
+{
+	switch(k)
+	{
+		case 1: m.add(e, position()); break;
+		case 2: m.add(e, position(), velocity()); break;
+		default: m.add(e, position(), velocity(), mass(), tag());
+	}
+}
+
+static void bench_create(suite& s, std::size_t n)
+{
+	std::vector<entity> e(n);
+
+	for(std::size_t k : {1, 2, 4})
+	{
+		s.run("create", n, k, n,
+			[&e, n, k](timer& t)
+			{
+				manager m;
+				t.start();
+				for(std::size_t i=0; i!=n; ++i)
+				{
+					add_components(m, e[i], k);
+				}
+				t.stop();
+			}
+		);
+	}
+}
+
+// the world has position and velocity on all entities,
+// mass on every other and tag on every fourth entity
+static void make_world(manager& m, std::vector<entity>& e)
+{
+	for(std::size_t i=0; i!=e.size(); ++i)
+	{
+		position p = { double(i), 0 };
+		velocity v = { 1, 1 };
+		m.add(e[i], p, v);
+		if(i % 2 == 0)
+		{
+			mass ms = { 1 };
+			m.add(e[i], ms);
+		}
+		if(i % 4 == 0)
+		{
+			tag tg = { int(i % 16) };
+			m.add(e[i], tg);
+		}
+	}
+}
+
+// counts the entities having mass but not tag, with a predicate
+// evaluated per entity and with the precomputed masks of a query
+static void bench_query(
+	suite& s,
+	manager& m,
+	const std::vector<entity>& e
+)
+{
+	const std::size_t n = e.size();
+
+	s.run("query/predicate", n, 2, n,
+		[&m](timer& t)
+		{
+			std::size_t k = 0;
+			t.start();
+			m.for_each(
+				[&k](const iter_info&, manager& mm, entity_key ek)
+				-> bool
+				{
+					if(	mm.has<mass>(ek) &&
+						!mm.has<tag>(ek)
+					) ++k;
+					return true;
+				}
+			);
+			t.stop();
+			sink = double(k);
+		}
+	);
+
+	typedef exces::query<
+		exces::with<mass>,
+		exces::without<tag>
+	> mass_no_tag;
+
+	s.run("query/masks", n, 2, n,
+		[&m](timer& t)
+		{
+			std::size_t k = 0;
+			t.start();
+			m.for_each(
+				mass_no_tag(),
+				[&k](manager&, entity_key) -> bool
+				{
+					++k;
+					return true;
+				}
+			);
+			t.stop();
+			sink = double(k);
+		}
+	);
+}
+
+static void bench_churn(
+	suite& s,
+	manager& m,
+	const std::vector<entity>& e
+)
+{
+	const std::size_t n = e.size();
+	s.run("churn", n, 1, n,
+		[&m, &e, n](timer& t)
+		{
+			t.start();
+			for(std::size_t i=0; i!=n; ++i)
+			{
+				const entity& x = e[scatter(i, n)];
+				m.remove<velocity>(x);
+				m.add(x, velocity());
+			}
+			t.stop();
+		}
+	);
+}
+
+static void bench_raw_access(
+	suite& s,
+	manager& m,
+	const std::vector<entity>& e
+)
+{
+	const std::size_t n = e.size();
+	std::vector<entity_key> keys = m.get_keys(e.begin(), e.end());
+
+	s.run("raw_access", n, 1, n,
+		[&m, &keys](timer& t)
+		{
+			double sum = 0;
+			t.start();
+			for(entity_key k : keys)
+			{
+				sum += m.raw_access<position>(k).x;
+			}
+			t.stop();
+			sink = sum;
+		}
+	);
+	s.run("raw_access/scattered", n, 1, n,
+		[&m, &keys, n](timer& t)
+		{
+			double sum = 0;
+			t.start();
+			for(std::size_t i=0; i!=n; ++i)
+			{
+				sum += m.raw_access<position>(keys[scatter(i, n)]).x;
+			}
+			t.stop();
+			sink = sum;
+		}
+	);
+}
+
+static void bench_for_each(
+	suite& s,
+	manager& m,
+	const std::vector<entity>& e
+)
+{
+	const std::size_t n = e.size();
+	double sum = 0;
+
+	auto measure = [&s, &m, &sum, n](
+		const char* name,
+		std::size_t components,
+		const std::function<bool (const iter_info&, manager&, entity_key)>&
+			func
+	)
+	{
+		s.run(name, n, components, n,
+			[&m, &sum, &func](timer& t)
+			{
+				sum = 0;
+				t.start();
+				m.for_each(func);
+				t.stop();
+				sink = sum;
+			}
+		);
+	};
+
+	std::function<bool (const position&)>
+	c = [&sum](const position& p) -> bool
+	{
+		sum += p.x;
+		return true;
+	};
+	measure("for_each/c", 1, adapt_func(c));
+
+	std::function<bool (const position&, const velocity&)>
+	c2 = [&sum](const position& p, const velocity& v) -> bool
+	{
+		sum += p.x*v.dx;
+		return true;
+	};
+	measure("for_each/c", 2, adapt_func(c2));
+
+	std::function<bool (position&, const velocity&)>
+	c2rw = [](position& p, const velocity& v) -> bool
+	{
+		p.x += v.dx;
+		return true;
+	};
+	measure("for_each/c_rw", 2, adapt_func(c2rw));
+
+	std::function<bool (const iter_info&, const position&)>
+	ic = [&sum](const iter_info&, const position& p) -> bool
+	{
+		sum += p.x;
+		return true;
+	};
+	measure("for_each/ic", 1, adapt_func(ic));
+
+	std::function<bool (const mass*)>
+	cp = [&sum](const mass* ms) -> bool
+	{
+		if(ms) sum += ms->m;
+		return true;
+	};
+	measure("for_each/cp", 1, adapt_func(cp));
+
+	std::function<bool (const iter_info&, const mass*)>
+	icp = [&sum](const iter_info&, const mass* ms) -> bool
+	{
+		if(ms) sum += ms->m;
+		return true;
+	};
+	measure("for_each/icp", 1, adapt_func(icp));
+
+	measure("for_each/cmv", 1, exces::adapt_func_cmv(
+		&position::x,
+		[&sum](double x) -> bool
+		{
+			sum += x;
+			return true;
+		}
+	));
+
+	std::function<bool (manager&, entity_key, const position&)>
+	mkc = [&sum](manager&, entity_key, const position& p) -> bool
+	{
+		sum += p.x;
+		return true;
+	};
+	measure("for_each/mkc", 1, adapt_func(mkc));
+
+	std::function<bool (
+		manager&,
+		entity_key,
+		const position&,
+		const velocity&
+	)> mkc2 = [&sum](
+		manager&,
+		entity_key,
+		const position& p,
+		const velocity& v
+	) -> bool
+	{
+		sum += p.x*v.dx;
+		return true;
+	};
+	measure("for_each/mkc", 2, adapt_func(mkc2));
+
+	std::function<bool (
+		const iter_info&,
+		manager&,
+		entity_key,
+		const position&
+	)> imkc = [&sum](
+		const iter_info&,
+		manager&,
+		entity_key,
+		const position& p
+	) -> bool
+	{
+		sum += p.x;
+		return true;
+	};
+	measure("for_each/imkc", 1, adapt_func(imkc));
+
+	std::function<bool (manager&, entity_key, const mass*)>
+	mkcp = [&sum](manager&, entity_key, const mass* ms) -> bool
+	{
+		if(ms) sum += ms->m;
+		return true;
+	};
+	measure("for_each/mkcp", 1, adapt_func(mkcp));
+
+	std::function<bool (
+		const iter_info&,
+		manager&,
+		entity_key,
+		const mass*
+	)> imkcp = [&sum](
+		const iter_info&,
+		manager&,
+		entity_key,
+		const mass* ms
+	) -> bool
+	{
+		if(ms) sum += ms->m;
+		return true;
+	};
+	measure("for_each/imkcp", 1, adapt_func(imkcp));
+
+	std::function<bool (manager&, entity_key, entity, const position&)>
+	mkec = [&sum](manager&, entity_key, entity, const position& p) -> bool
+	{
+		sum += p.x;
+		return true;
+	};
+	measure("for_each/mkec", 1, exces::adapt_func_mkec<const position&>(mkec));
+
+	std::function<bool (
+		const iter_info&,
+		manager&,
+		entity_key,
+		entity,
+		const position&
+	)> imkec = [&sum](
+		const iter_info&,
+		manager&,
+		entity_key,
+		entity,
+		const position& p
+	) -> bool
+	{
+		sum += p.x;
+		return true;
+	};
+	measure("for_each/imkec", 1, exces::adapt_func_imkec<const position&>(imkec));
+
+	std::function<bool (position&)>
+	pc = [&sum](position& p) -> bool
+	{
+		sum += p.x;
+		return true;
+	};
+	s.run("for_each<Component>", n, 1, n,
+		[&m, &sum, &pc](timer& t)
+		{
+			sum = 0;
+			t.start();
+			m.for_each<position>(pc);
+			t.stop();
+			sink = sum;
+		}
+	);
+
+	s.run("for_each_batch", n, 1, n,
+		[&m](timer& t)
+		{
+			double total = 0;
+			t.start();
+			m.for_each_batch<position>(
+				[&total](std::size_t count, const position* p) -> bool
+				{
+					for(std::size_t i=0; i!=count; ++i)
+					{
+						total += p[i].x;
+					}
+					return true;
+				}
+			);
+			t.stop();
+			sink = total;
+		}
+	);
+}
+
+static void bench_collections(
+	suite& s,
+	manager& m,
+	const std::vector<entity>& e
+)
+{
+	const std::size_t n = e.size();
+
+	// toggles the tag of each entity, adding it to or removing it
+	// from the collection
+	auto toggle_tags = [&m, &e, n](timer& t)
+	{
+		t.start();
+		for(std::size_t i=0; i!=n; ++i)
+		{
+			const entity& x = e[scatter(i, n)];
+			if(m.has<tag>(x))
+			{
+				m.remove<tag>(x);
+			}
+			else
+			{
+				tag tg = { int(i % 16) };
+				m.add(x, tg);
+			}
+		}
+		t.stop();
+	};
+
+	if(s.enabled("collection_update"))
+	{
+		exces::collection<> tagged(
+			m,
+			[](manager& m, entity_key k) -> bool
+			{
+				return m.has<tag>(k);
+			}
+		);
+		s.run("collection_update", n, 1, n, toggle_tags);
+
+		// restore the original tags of the world
+		for(std::size_t i=0; i!=n; ++i)
+		{
+			if(m.has<tag>(e[i])) m.remove<tag>(e[i]);
+			if(i % 4 == 0)
+			{
+				tag tg = { int(i % 16) };
+				m.add(e[i], tg);
+			}
+		}
+	}
+
+	if(s.enabled("classification_update"))
+	{
+		exces::classification<int> by_kind(m, &tag::kind);
+
+		// moves each tagged entity into the next class
+		s.run("classification_update", n, 1, (n+3)/4,
+			[&m, &e, n](timer& t)
+			{
+				t.start();
+				for(std::size_t i=0; i<n; i += 4)
+				{
+					tag tg = { (m.raw_access<tag>(m.get_key(e[i])).kind+1)%16 };
+					m.replace(e[i], tg);
+				}
+				t.stop();
+			}
+		);
+	}
+}
+
+static void bench_flyweight(
+	suite& s,
+	manager& m,
+	const std::vector<entity>& e
+)
+{
+	if(!s.enabled("flyweight")) return;
+
+	const std::size_t n = e.size();
+	std::vector<material> materials;
+	for(int i=0; i!=16; ++i)
+	{
+		materials.push_back(material("material-"+std::to_string(i)));
+	}
+
+	s.run("flyweight/store", n, 1, n,
+		[&m, &e, &materials, n](timer& t)
+		{
+			t.start();
+			for(std::size_t i=0; i!=n; ++i)
+			{
+				m.add(e[i], material(materials[i % 16]));
+			}
+			t.stop();
+			for(std::size_t i=0; i!=n; ++i)
+			{
+				m.remove<material>(e[i]);
+			}
+		}
+	);
+
+	for(std::size_t i=0; i!=n; ++i)
+	{
+		m.add(e[i], material(materials[i % 16]));
+	}
+	std::size_t round = 0;
+	s.run("flyweight/replace", n, 1, n,
+		[&m, &e, &materials, &round, n](timer& t)
+		{
+			++round;
+			t.start();
+			for(std::size_t i=0; i!=n; ++i)
+			{
+				m.replace(e[i], material(materials[(i+round) % 16]));
+			}
+			t.stop();
+		}
+	);
+	for(std::size_t i=0; i!=n; ++i)
+	{
+		m.remove<material>(e[i]);
+	}
+}
+
+static void bench_backbuf(
+	suite& s,
+	manager& m,
+	const std::vector<entity>& e
+)
+{
+	if(!s.enabled("backbuf")) return;
+
+	const std::size_t n = e.size();
+	auto rl = m.raw_access_lock<clock>();
+	auto wl = m.raw_access_lock<clock&>();
+
+	wl.lock();
+	for(std::size_t i=0; i!=n; ++i)
+	{
+		m.add(e[i], clock());
+	}
+	wl.unlock();
+
+	std::vector<entity_key> keys = m.get_keys(e.begin(), e.end());
+
+	s.run("backbuf/read_lock", n, 1, n,
+		[&m, &rl, &keys](timer& t)
+		{
+			double sum = 0;
+			t.start();
+			for(entity_key k : keys)
+			{
+				rl.lock();
+				sum += m.raw_access<clock>(k).time;
+				rl.unlock();
+			}
+			t.stop();
+			sink = sum;
+		}
+	);
+
+	s.run("backbuf/write_lock", n, 1, n,
+		[&m, &wl, &keys](timer& t)
+		{
+			t.start();
+			for(entity_key k : keys)
+			{
+				wl.lock();
+				clock& c = m.raw_access<clock>(k);
+				c.time += c.pace;
+				wl.unlock();
+			}
+			t.stop();
+		}
+	);
+
+	std::function<bool (clock&)>
+	update = [](clock& c) -> bool
+	{
+		c.time += c.pace;
+		return true;
+	};
+	s.run("backbuf/for_each", n, 1, n,
+		[&m, &wl, &update](timer& t)
+		{
+			t.start();
+			wl.lock();
+			m.for_each<clock>(update);
+			wl.unlock();
+			t.stop();
+		}
+	);
+
+	wl.lock();
+	for(std::size_t i=0; i!=n; ++i)
+	{
+		m.remove<clock>(e[i]);
+	}
+	wl.unlock();
+}
+
+// compares the mapped storage with the normal storage of position
+static void bench_mapped(suite& s, std::size_t n)
+{
+	if(!s.enabled("mapped")) return;
+
+	std::vector<entity> e(n);
+
+	s.run("mapped/create", n, 1, n,
+		[&e, n](timer& t)
+		{
+			manager m;
+			t.start();
+			for(std::size_t i=0; i!=n; ++i)
+			{
+				mapped_position p = { double(i), 0 };
+				m.add(e[i], p);
+			}
+			t.stop();
+		}
+	);
+
+	manager m;
+	for(std::size_t i=0; i!=n; ++i)
+	{
+		mapped_position p = { double(i), 0 };
+		m.add(e[i], p);
+	}
+	std::function<bool (mapped_position&)>
+	func = [](mapped_position& p) -> bool
+	{
+		sink = sink + p.x;
+		return true;
+	};
+	s.run("mapped/for_each<Component>", n, 1, n,
+		[&m, &func](timer& t)
+		{
+			t.start();
+			m.for_each<mapped_position>(func);
+			t.stop();
+		}
+	);
+}
+
+// diffs two worlds differing in 1% of the positions and applies the delta
+static void bench_delta(suite& s, std::size_t n)
+{
+	if(!s.enabled("delta")) return;
+
+	std::vector<entity> e(n);
+	manager a, b;
+	make_world(a, e);
+	make_world(b, e);
+	for(std::size_t i=0; i<n; i += 100)
+	{
+		position p = { -double(i), 0 };
+		b.replace(e[i], p);
+	}
+
+	s.run("delta/diff", n, 4, n,
+		[&a, &b](timer& t)
+		{
+			t.start();
+			exces::manager_delta<> d = exces::diff(a, b);
+			t.stop();
+			sink = sink + double(d.size());
+		}
+	);
+
+	const exces::manager_delta<> forward = exces::diff(a, b);
+	const exces::manager_delta<> backward = exces::diff(b, a);
+	s.run("delta/patch", n, 1, forward.size(),
+		[&a, &forward, &backward](timer& t)
+		{
+			t.start();
+			exces::patch(a, forward);
+			t.stop();
+			exces::patch(a, backward);
+		}
+	);
+}
+
+// default-constructs n entities on each of several threads concurrently
+static void bench_entity_ids(suite& s, std::size_t n)
+{
+	if(!s.enabled("entity_ids")) return;
+
+	for(std::size_t threads : {1, 2, 4})
+	{
+		s.run("entity_ids/"+std::to_string(threads), n, 0, n*threads,
+			[n, threads](timer& t)
+			{
+				std::atomic<std::size_t> nils(0);
+				std::vector<std::thread> ts;
+				t.start();
+				for(std::size_t th=0; th!=threads; ++th)
+				{
+					ts.push_back(std::thread(
+						[&nils, n](void)
+						{
+							std::size_t k = 0;
+							for(std::size_t i=0; i!=n; ++i)
+							{
+								if(entity() == entity::nil()) ++k;
+							}
+							nils += k;
+						}
+					));
+				}
+				for(std::thread& th : ts)
+				{
+					th.join();
+				}
+				t.stop();
+				sink = double(nils.load());
+			}
+		);
+	}
+
+	s.run("entity_ids/uuid", n, 0, n,
+		[n](timer& t)
+		{
+			std::size_t k = 0;
+			t.start();
+			for(std::size_t i=0; i!=n; ++i)
+			{
+				exces::boost_uuid_entity e;
+				if(e == exces::boost_uuid_entity::nil()) ++k;
+			}
+			t.stop();
+			sink = double(k);
+		}
+	);
+}
+
+// tests n bitsets of the size of a big group against a mask
+template <typename Bitset, typename Contains>
+static void bench_bitset(
+	suite& s,
+	std::size_t n,
+	const char* name,
+	Contains contains
+)
+{
+	const std::size_t bits = 200;
+	std::vector<Bitset> sets(n);
+	Bitset mask;
+	std::mt19937 rng(n);
+	for(Bitset& b : sets)
+	{
+		for(std::size_t i=0; i!=bits; ++i)
+		{
+			if(rng() % 2) b.set(i);
+		}
+	}
+	mask.set(3).set(97).set(150);
+
+	s.run(std::string("bitset/")+name, n, 0, n,
+		[&sets, &mask, contains](timer& t)
+		{
+			std::size_t k = 0;
+			t.start();
+			for(const Bitset& b : sets)
+			{
+				if(contains(b, mask)) ++k;
+			}
+			t.stop();
+			sink = double(k);
+		}
+	);
+}
+
+// compares the mask test of std::bitset with the word-wise bitset
+static void bench_bitsets(suite& s, std::size_t n)
+{
+	if(!s.enabled("bitset")) return;
+
+	typedef std::bitset<200> std_bits;
+	bench_bitset<std_bits>(s, n, "std",
+		[](const std_bits& b, const std_bits& m) -> bool
+		{
+			return (b & m) == m;
+		}
+	);
+	typedef exces::detail::fixed_bitset<200> fixed_bits;
+	bench_bitset<fixed_bits>(s, n, "fixed",
+		[](const fixed_bits& b, const fixed_bits& m) -> bool
+		{
+			return b.contains(m);
+		}
+	);
+}
+
+// readers traverse all counters under the read lock, one writer
+// concurrently increments a few counters at a time under the write lock
+template <typename Group>
+static void bench_mt_mix(suite& s, std::size_t n, const char* policy)
+{
+	typedef exces::manager<Group> mt_manager;
+	typedef typename mt_manager::entity_key mt_key;
+	typedef typename exces::entity<Group>::type mt_entity;
+
+	const std::string read_name = std::string("mt_mix/")+policy+"/read";
+	const std::string write_name = std::string("mt_mix/")+policy+"/write";
+	if(!s.enabled(read_name) && !s.enabled(write_name)) return;
+
+	const std::size_t write_batch = 64;
+
+	std::vector<mt_entity> e(n);
+	mt_manager m;
+	for(std::size_t i=0; i!=n; ++i)
+	{
+		counter c = { 0 };
+		m.add(e[i], c);
+	}
+	std::vector<mt_key> keys = m.get_keys(e.begin(), e.end());
+
+	for(std::size_t readers : {1, 2, 4})
+	{
+		std::atomic<bool> stop(false);
+		std::atomic<std::uint64_t> read_ops(0), read_iters(0), read_ns(0);
+		std::atomic<std::uint64_t> write_ops(0), write_iters(0), write_ns(0);
+
+		std::vector<std::thread> threads;
+		for(std::size_t r=0; r!=readers; ++r)
+		{
+			threads.push_back(std::thread(
+				[&m, &stop, &read_ops, &read_iters, &read_ns, n](void)
+				{
+					auto rl = m.template raw_access_lock<counter>();
+					std::uint64_t sum = 0;
+					std::function<bool (counter&)>
+					func = [&sum](counter& c) -> bool
+					{
+						sum += c.value;
+						return true;
+					};
+					timer t;
+					std::uint64_t iters = 0;
+					while(!stop.load())
+					{
+						t.start();
+						rl.lock();
+						m.template for_each<counter>(func);
+						rl.unlock();
+						t.stop();
+						++iters;
+					}
+					sink = double(sum);
+					read_iters += iters;
+					read_ops += iters*n;
+					read_ns += t.elapsed_ns();
+				}
+			));
+		}
+		threads.push_back(std::thread(
+			[&m, &keys, &stop, &write_ops, &write_iters, &write_ns, n](void)
+			{
+				auto wl = m.template raw_access_lock<counter&>();
+				timer t;
+				std::uint64_t iters = 0;
+				std::size_t i = 0;
+				while(!stop.load())
+				{
+					t.start();
+					wl.lock();
+					for(std::size_t b=0; b!=write_batch; ++b)
+					{
+						++m.template raw_access<counter>(
+							keys[scatter(i++, n)]
+						).value;
+					}
+					wl.unlock();
+					t.stop();
+					++iters;
+				}
+				write_iters += iters;
+				write_ops += iters*write_batch;
+				write_ns += t.elapsed_ns();
+			}
+		));
+
+		std::this_thread::sleep_for(
+			std::chrono::nanoseconds(s.opts().min_time_ns)
+		);
+		stop = true;
+		for(std::thread& t : threads)
+		{
+			t.join();
+		}
+
+		result r;
+		r.entities = n;
+		r.components = 1;
+		r.threads = readers+1;
+
+		r.name = read_name;
+		r.iterations = read_iters;
+		r.operations = read_ops;
+		r.total_ns = read_ns;
+		if(s.enabled(read_name)) s.add(r);
+
+		r.name = write_name;
+		r.iterations = write_iters;
+		r.operations = write_ops;
+		r.total_ns = write_ns;
+		if(s.enabled(write_name)) s.add(r);
+	}
+}
+
+} // namespace bench
+
+int main(int argc, const char** argv)
+{
+	bench::options opts;
+	if(!opts.parse(argc, argv))
+	{
+		bench::options::usage(std::cerr, argv[0]);
+		return 1;
+	}
+	bench::suite s(opts);
+
+	for(std::size_t n : s.entity_counts())
+	{
+		bench::bench_create(s, n);
+		{
+			std::vector<bench::entity> e(n);
+			bench::manager m;
+			bench::make_world(m, e);
+
+			bench::bench_raw_access(s, m, e);
+			bench::bench_for_each(s, m, e);
+			bench::bench_query(s, m, e);
+			bench::bench_churn(s, m, e);
+			bench::bench_collections(s, m, e);
+			bench::bench_flyweight(s, m, e);
+			bench::bench_backbuf(s, m, e);
+		}
+		bench::bench_mapped(s, n);
+		bench::bench_delta(s, n);
+		bench::bench_entity_ids(s, n);
+		bench::bench_bitsets(s, n);
+		bench::bench_mt_mix<EXCES_GROUP_SEL(bench_std)>(s, n, "std");
+		bench::bench_mt_mix<EXCES_GROUP_SEL(bench_read_mostly)>(
+			s, n, "read_mostly"
+		);
+	}
+
+	if(opts.output.empty())
+	{
+		s.write_json(std::cout);
+	}
+	else
+	{
+		std::ofstream out(opts.output);
+		if(!out)
+		{
+			std::cerr << "cannot open " << opts.output << std::endl;
+			return 1;
+		}
+		s.write_json(out);
+	}
+	return 0;
+}
@@ -0,0 +1,158 @@
+/**
+ *  @example exces/006_clock_batch.cpp
+ *  @brief Example comparing per-entity and batched component updates
+ *
+ *  Copyright 2012-2014 Matus Chochlik. Distributed under the Boost
+ *  Software License, Version 1.0. (See accompanying file
+ *  LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+#include <exces/simple.hpp>
+#include <exces/func_adaptors/c.hpp>
+
+#include <iostream>
+#include <chrono>
+#include <vector>
+
+namespace test {
+
+struct clock
+{
+	double time, pace;
+
+	clock(void)
+	 : time(0)
+	 , pace(1)
+	{ }
+};
+
+struct scale
+{
+	double factor;
+
+	scale(void)
+	 : factor(1.5)
+	{ }
+};
+
+} // namespace test
+
+EXCES_REG_COMPONENT(test::clock)
+EXCES_REG_COMPONENT(test::scale)
+
+#include <exces/implement.hpp>
+
+template <typename Func>
+static double measure(const char* label, int repeats, Func func)
+{
+	typedef std::chrono::steady_clock clk;
+	auto start = clk::now();
+	for(int r=0; r!=repeats; ++r)
+	{
+		func();
+	}
+	std::chrono::duration<double, std::milli> ms = clk::now() - start;
+	std::cout << label << ": " << ms.count()/repeats << " ms" << std::endl;
+	return ms.count();
+}
+
+int main(void)
+{
+	using exces::simple::manager;
+	using exces::adapt_func;
+
+	const std::size_t n = 100000;
+	const int repeats = 20;
+
+	std::vector<exces::simple::entity> e(n);
+	manager m;
+	for(std::size_t i=0; i!=n; ++i)
+	{
+		m.add(e[i], test::clock());
+		if(i % 2 == 0) m.add(e[i], test::scale());
+	}
+
+	std::function<bool (test::clock&)>
+	update_clock = [](test::clock& c) -> bool
+	{
+		c.time += c.pace;
+		return true;
+	};
+
+	std::cout << n << " clocks, average of " << repeats << " updates" << std::endl;
+
+	double per_entity = measure("per-entity adaptor", repeats,
+		[&m, &update_clock](void)
+		{
+			m.for_each(adapt_func(update_clock));
+		}
+	);
+
+	double per_instance = measure("per-instance for_each", repeats,
+		[&m, &update_clock](void)
+		{
+			m.for_each<test::clock>(update_clock);
+		}
+	);
+
+	double batched = measure("for_each_batch", repeats,
+		[&m](void)
+		{
+			m.for_each_batch<test::clock&>(
+				[](std::size_t count, test::clock* c) -> bool
+				{
+					for(std::size_t i=0; i!=count; ++i)
+					{
+						c[i].time += c[i].pace;
+					}
+					return true;
+				}
+			);
+		}
+	);
+
+	double gathered = measure("for_each_batch (gathered)", repeats,
+		[&m](void)
+		{
+			m.for_each_batch<test::clock&, test::scale>(
+				[](
+					std::size_t count,
+					test::clock* c,
+					const test::scale* s
+				) -> bool
+				{
+					for(std::size_t i=0; i!=count; ++i)
+					{
+						c[i].time += c[i].pace*s[i].factor;
+					}
+					return true;
+				}
+			);
+		}
+	);
+
+	std::cout << "speedup over per-entity adaptor: "
+		<< per_entity/batched << "x (per-instance: "
+		<< per_entity/per_instance << "x, gathered: "
+		<< per_entity/gathered << "x)" << std::endl;
+
+	// every clock was advanced 3*repeats times by pace 1
+	// and even clocks additionally repeats times by 1.5
+	double expected = 3*repeats*double(n)+repeats*1.5*double(n/2);
+	double total = 0;
+	m.for_each_batch<test::clock>(
+		[&total](std::size_t count, const test::clock* c) -> bool
+		{
+			for(std::size_t i=0; i!=count; ++i)
+			{
+				total += c[i].time;
+			}
+			return true;
+		}
+	);
+	if(total != expected)
+	{
+		std::cerr << "unexpected total time " << total << std::endl;
+		return 1;
+	}
+	return 0;
+}
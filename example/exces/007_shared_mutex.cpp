@@ -0,0 +1,148 @@
+/**
+ *  @example exces/007_shared_mutex.cpp
+ *  @brief Example comparing the throughput of shared mutex implementations
+ *
+ *  Copyright 2012-2014 Matus Chochlik. Distributed under the Boost
+ *  Software License, Version 1.0. (See accompanying file
+ *  LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+#include <exces/threads.hpp>
+
+#if __cplusplus >= 201402L
+#include <shared_mutex>
+#endif
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <vector>
+
+// adapts std::shared_(timed_)mutex and exces mutexes to a common interface
+template <typename Mutex>
+struct mutex_traits
+{
+	static void lock_shared(Mutex& m) { m.lock_shared(); }
+	static void unlock_shared(Mutex& m) { m.unlock_shared(); }
+	static void lock(Mutex& m) { m.lock(); }
+	static void unlock(Mutex& m) { m.unlock(); }
+};
+
+// measures the number of shared lock/unlock pairs per microsecond
+// done by the specified number of reader threads, optionally with
+// a writer thread locking the mutex exclusively from time to time
+template <typename Mutex>
+static double measure(unsigned readers, bool with_writer)
+{
+	typedef mutex_traits<Mutex> mt;
+	typedef std::chrono::steady_clock clk;
+
+	const unsigned ops_per_reader = 20000;
+
+	Mutex mutex;
+	long shared_value = 0;
+	std::atomic<bool> done(false);
+	std::atomic<unsigned> ready(0);
+	std::atomic<bool> go(false);
+
+	std::vector<std::thread> threads;
+	for(unsigned r=0; r!=readers; ++r)
+	{
+		threads.push_back(std::thread(
+			[&](void) -> void
+			{
+				++ready;
+				while(!go.load()) std::this_thread::yield();
+				long sum = 0;
+				for(unsigned i=0; i!=ops_per_reader; ++i)
+				{
+					mt::lock_shared(mutex);
+					sum += shared_value;
+					mt::unlock_shared(mutex);
+				}
+				if(sum < 0) std::cerr << sum;
+			}
+		));
+	}
+
+	std::thread writer;
+	if(with_writer)
+	{
+		writer = std::thread(
+			[&](void) -> void
+			{
+				while(!done.load())
+				{
+					mt::lock(mutex);
+					++shared_value;
+					mt::unlock(mutex);
+					std::this_thread::sleep_for(
+						std::chrono::microseconds(100)
+					);
+				}
+			}
+		);
+	}
+
+	while(ready.load() != readers) std::this_thread::yield();
+
+	auto start = clk::now();
+	go.store(true);
+	for(auto& t : threads) t.join();
+	std::chrono::duration<double, std::micro> us = clk::now() - start;
+
+	done.store(true);
+	if(writer.joinable()) writer.join();
+
+	return double(readers)*ops_per_reader/us.count();
+}
+
+template <typename Mutex>
+static void measure_all(const char* name, bool with_writer)
+{
+	std::cout << std::setw(34) << std::left << name;
+	for(unsigned readers=1; readers<=64; readers *= 2)
+	{
+		std::cout << std::setw(8) << std::right
+			<< std::fixed << std::setprecision(1)
+			<< measure<Mutex>(readers, with_writer);
+	}
+	std::cout << std::endl;
+}
+
+static void measure_all(bool with_writer)
+{
+	std::cout << "shared lock/unlock pairs per microsecond";
+	if(with_writer) std::cout << ", with a writer";
+	std::cout << std::endl << std::setw(34) << std::left << "reader threads:";
+	for(unsigned readers=1; readers<=64; readers *= 2)
+	{
+		std::cout << std::setw(8) << std::right << readers;
+	}
+	std::cout << std::endl;
+
+	measure_all<exces::shared_mutex>("exces::shared_mutex", with_writer);
+	measure_all<exces::read_mostly_shared_mutex>(
+		"exces::read_mostly_shared_mutex",
+		with_writer
+	);
+#if __cplusplus >= 201703L
+	measure_all<std::shared_mutex>("std::shared_mutex", with_writer);
+#elif __cplusplus >= 201402L
+	measure_all<std::shared_timed_mutex>(
+		"std::shared_timed_mutex",
+		with_writer
+	);
+#else
+	std::cout << "(std::shared_mutex requires C++14 or later)" << std::endl;
+#endif
+	std::cout << std::endl;
+}
+
+int main(void)
+{
+	measure_all(false);
+	measure_all(true);
+	return 0;
+}
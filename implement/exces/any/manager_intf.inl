@@ -8,7 +8,9 @@
  */
 
 #include <exces/any/manager_intf.hpp>
-#include <unordered_map>
+#include <array>
+#include <vector>
+#include <algorithm>
 
 namespace exces {
 //------------------------------------------------------------------------------
@@ -32,304 +34,352 @@ private:
 		return aek.get<_ek_t>();
 	}
 
-	static std::unordered_map<std::size_t, void*>
-	cids_by_names(const char** cnames, void** ptrs)
+	typedef mp::size<components<Group>> _component_count;
+
+	typedef typename _mgr_t::_component_adder _adder;
+	typedef typename _mgr_t::_component_remover _remover;
+
+	// the type erased operations on a single component type
+	struct _component_ops
+	{
+		void (*reserve)(_mgr_t&, std::size_t);
+		void (*add)(_mgr_t&, _ek_t, void*);
+		void (*remove)(_mgr_t&, _ek_t);
+		void (*copy)(_mgr_t&, _ek_t, _ek_t);
+		any_lock (*lifetime_lock)(_mgr_t&);
+		any_lock (*raw_access_lock)(_mgr_t&);
+		void* (*raw_access)(_mgr_t&, _ek_t);
+		void (*for_each)(_mgr_t&, const void*);
+		void (*add_to)(_adder&, void*, std::size_t);
+		void (*remove_from)(_remover&);
+		void (*raw_access_n)(_mgr_t&, const _ek_t*, std::size_t, void**);
+		void (*column)(_mgr_t&, any_component_column&);
+	};
+
+	template <typename C>
+	struct _ops_of
 	{
-		assert(cnames);
-		std::unordered_map<std::size_t, void*> result;
-		while(*cnames)
+		static void reserve(_mgr_t& mgr, std::size_t n)
 		{
-			void* ptr = nullptr;
-			if(ptrs)
-			{
-				ptr = *ptrs;
-				++ptrs;
-			}
-			result[component_index<Group>::by_name(*cnames)] = ptr;
-			++cnames;
+			mgr.template reserve<C>(n);
 		}
-		return std::move(result);
-	}
-
-	template <typename Func>
-	static Func& for_each_comp(Func& functor)
-	{
-		mp::for_each_ref<typename components<Group>::type>(functor);
-		return functor;
-	}
-public:
-	any_manager_impl(_mgr_t& mgr)
-	 : _rmgr(mgr)
-	{ }
-
-	bool has_key(_entity_t e)
-	{
-		return _rmgr.has_key(e);
-	}
 
-	any_entity_key get_key(_entity_t e)
-	{
-		return any_entity_key(_rmgr.get_key(e));
-	}
+		static void add(_mgr_t& mgr, _ek_t ek, void* ptr)
+		{
+			C& ref = *(static_cast<C*>(ptr));
+			mgr.template add<C>(ek, std::move(ref));
+		}
 
-	_entity_t get_entity(aekp aek)
-	{
-		return _rmgr.get_entity(_get(aek));
-	}
+		static void remove(_mgr_t& mgr, _ek_t ek)
+		{
+			mgr.template remove<C>(ek);
+		}
 
-	template <typename Derived>
-	struct _onec_hlp
-	{
-		_mgr_t& _rmgr;
-		std::size_t _cid;
+		static void copy(_mgr_t& mgr, _ek_t ekf, _ek_t ekt)
+		{
+			mgr.template copy<C>(ekf, ekt);
+		}
 
-		Derived& derived(void)
+		static any_lock lifetime_lock(_mgr_t& mgr)
 		{
-			return *(static_cast<Derived*>(this));
+			return any_lock(mgr.template lifetime_lock<C>());
 		}
 
-		_onec_hlp(_mgr_t& mgr, const char* cname)
-		 : _rmgr(mgr)
-		 , _cid(component_index<Group>::by_name(cname))
-		{ }
+		static any_lock raw_access_lock(_mgr_t& mgr)
+		{
+			return any_lock(mgr.template raw_access_lock<C>());
+		}
 
-		template <typename C>
-		void operator ()(mp::identity<C> ic)
+		static void* raw_access(_mgr_t& mgr, _ek_t ek)
 		{
-			if(_cid == component_id<C, Group>())
-			{
-				derived().operate(ic);
-			}
+			C& ref = mgr.template raw_access<C>(ek);
+			return &ref;
 		}
-	};
 
-	template <typename Derived>
-	struct _allc_hlp
-	{
-		_mgr_t& _rmgr;
-		std::unordered_map<std::size_t, void*> _cids;
+		static void for_each(_mgr_t& mgr, const void* pstd_fn)
+		{
+			assert(pstd_fn);
+			typedef std::function<bool (C&)> Fn;
+			const Fn& func = *(static_cast<const Fn*>(pstd_fn));
+			mgr.template for_each<C>(func);
+		}
 
-		Derived& derived(void)
+		// adds the i-th instance of C in an array, moving from it
+		static void add_to(_adder& adder, void* array, std::size_t i)
 		{
-			return *(static_cast<Derived*>(this));
+			adder(static_cast<C*>(array)[i]);
 		}
 
-		_allc_hlp(_mgr_t& mgr, const char** cnames)
-		 : _rmgr(mgr)
-		 , _cids(cids_by_names(cnames, nullptr))
-		{ }
+		static void remove_from(_remover& remover)
+		{
+			remover(mp::identity<C>());
+		}
 
-		_allc_hlp(_mgr_t& mgr, const char** cnames, void** ptrs)
-		 : _rmgr(mgr)
-		 , _cids(cids_by_names(cnames, ptrs))
-		{ }
+		static void raw_access_n(
+			_mgr_t& mgr,
+			const _ek_t* keys,
+			std::size_t n,
+			void** out
+		)
+		{
+			mgr.template raw_access<C>(keys, n, out);
+		}
 
-		template <typename C>
-		void operator ()(mp::identity<C> ic)
+		struct _column_appender
 		{
-			auto p = _cids.find(component_id<C, Group>());
-			if(p != _cids.end())
+			any_component_column& _column;
+
+			void operator()(_ek_t ek, C* ptr) const
 			{
-				derived().operate(ic, p->second);
+				_column._append(any_entity_key(ek), ptr, sizeof(C));
 			}
+		};
+
+		static void column(_mgr_t& mgr, any_component_column& col)
+		{
+			_column_appender appender = { col };
+			mgr.template raw_for_each<C>(appender);
+			col._finish();
 		}
 	};
 
-	template <typename E>
-	struct _has_hlp : _onec_hlp<_has_hlp<E>>
-	{
-		E _e;
-		bool _res;
+	typedef std::array<_component_ops, _component_count::value> _ops_table;
 
-		_has_hlp(_mgr_t& mgr, const char* cname, E e)
-		 : _onec_hlp<_has_hlp<E>>(mgr, cname)
-		 , _e(e)
-		 , _res(false)
-		{ }
+	struct _ops_maker
+	{
+		_ops_table& _table;
 
 		template <typename C>
-		void operate(mp::identity<C>)
+		void operator ()(mp::identity<C>) const
 		{
-			_res = this->_rmgr.template has<C>(_e);
+			_component_ops ops = {
+				&_ops_of<C>::reserve,
+				&_ops_of<C>::add,
+				&_ops_of<C>::remove,
+				&_ops_of<C>::copy,
+				&_ops_of<C>::lifetime_lock,
+				&_ops_of<C>::raw_access_lock,
+				&_ops_of<C>::raw_access,
+				&_ops_of<C>::for_each,
+				&_ops_of<C>::add_to,
+				&_ops_of<C>::remove_from,
+				&_ops_of<C>::raw_access_n,
+				&_ops_of<C>::column
+			};
+			_table[exces::component_id<C, Group>::value] = ops;
 		}
 	};
 
-	bool has(aekp aek, const char* cname)
+	static _ops_table _make_ops(void)
 	{
-		_has_hlp<_ek_t> hlp(_rmgr, cname, _get(aek));
-		return for_each_comp(hlp)._res;
+		_ops_table result;
+		_ops_maker maker = { result };
+		mp::for_each<typename components<Group>::type>(maker);
+		return result;
 	}
 
-	bool has(_entity_t e, const char* cname)
+	// returns the operations on the component with the specified id
+	// or nullptr if the id is not valid in the Group
+	static const _component_ops* _ops(any_component_id cid)
 	{
-		_has_hlp<_entity_t> hlp(_rmgr, cname, e);
-		return for_each_comp(hlp)._res;
+		static const _ops_table table = _make_ops();
+		if(cid.value() < table.size())
+		{
+			return &table[cid.value()];
+		}
+		return nullptr;
 	}
 
-	struct _has_as_hlp : _allc_hlp<_has_as_hlp>
+	static any_component_id _find(const char* cname)
 	{
-		detail::component_bitset<Group> _bits;
+		assert(cname);
+		return any_component_id(component_index<Group>::by_name(cname));
+	}
 
-		_has_as_hlp(_mgr_t& mgr, const char** cnames)
-		 : _allc_hlp<_has_as_hlp>(mgr, cnames)
-		{ }
+	static detail::component_bitset<Group> _bits(any_component_id cid)
+	{
+		detail::component_bitset<Group> result;
+		if(cid.value() < result.size()) result.set(cid.value());
+		return result;
+	}
 
-		template <typename C>
-		void operate(mp::identity<C>, void*)
+	static detail::component_bitset<Group> _bits(
+		const any_component_id* cids,
+		std::size_t count
+	)
+	{
+		detail::component_bitset<Group> result;
+		for(std::size_t c=0; c!=count; ++c)
 		{
-			_bits.set(component_id<C, Group>());
+			if(cids[c].value() < result.size()) result.set(cids[c].value());
 		}
-	};
+		return result;
+	}
 
-	bool has_all(aekp aek, const char** cnames)
+	static std::vector<_ek_t> _keys(const any_entity_key* keys, std::size_t n)
 	{
-		_has_as_hlp hlp(_rmgr, cnames);
-		for_each_comp(hlp);
-		return _rmgr.has_all_bits(_get(aek), hlp._bits);
+		std::vector<_ek_t> result;
+		result.reserve(n);
+		for(std::size_t i=0; i!=n; ++i)
+		{
+			result.push_back(keys[i].get<_ek_t>());
+		}
+		return result;
 	}
 
-	bool has_some(aekp aek, const char** cnames)
+	static detail::component_bitset<Group> _bits(const char** cnames)
 	{
-		_has_as_hlp hlp(_rmgr, cnames);
-		for_each_comp(hlp);
-		return _rmgr.has_some_bits(_get(aek), hlp._bits);
+		assert(cnames);
+		detail::component_bitset<Group> result;
+		while(*cnames)
+		{
+			const any_component_id cid = _find(*cnames);
+			if(cid.value() < result.size()) result.set(cid.value());
+			++cnames;
+		}
+		return result;
 	}
+public:
+	any_manager_impl(_mgr_t& mgr)
+	 : _rmgr(mgr)
+	{ }
 
-	struct _rsrv_hlp : _allc_hlp<_rsrv_hlp>
+	bool has_key(_entity_t e)
 	{
-		std::size_t _n;
+		return _rmgr.has_key(e);
+	}
 
-		_rsrv_hlp(_mgr_t& mgr, const char** cnames, std::size_t n)
-		 : _allc_hlp<_rsrv_hlp>(mgr, cnames)
-		 , _n(n)
-		{ }
+	any_entity_key get_key(_entity_t e)
+	{
+		return any_entity_key(_rmgr.get_key(e));
+	}
 
-		template <typename C>
-		void operate(mp::identity<C>, void*)
-		{
-			this->_rmgr.template reserve<C>(_n);
-		}
-	};
+	_entity_t get_entity(aekp aek)
+	{
+		return _rmgr.get_entity(_get(aek));
+	}
 
-	void reserve(std::size_t n, const char** cnames)
+	any_component_id component_id(const char* cname)
 	{
-		_rsrv_hlp hlp(_rmgr, cnames, n);
-		for_each_comp(hlp);
+		return _find(cname);
 	}
 
-	struct _add_hlp : _allc_hlp<_add_hlp>
+	bool has(aekp aek, any_component_id cid)
 	{
-		_ek_t _ek;
+		return _ops(cid) && _rmgr.has_all_bits(_get(aek), _bits(cid));
+	}
 
-		_add_hlp(_mgr_t& mgr, const char** cnames, void** ptrs, _ek_t ek)
-		 : _allc_hlp<_add_hlp>(mgr, cnames, ptrs)
-		 , _ek(ek)
-		{ }
+	bool has(_entity_t e, any_component_id cid)
+	{
+		return _ops(cid) && _rmgr.has_all_bits(e, _bits(cid));
+	}
 
-		template <typename C>
-		void operate(mp::identity<C>, void* ptr)
-		{
-			C& ref = *(static_cast<C*>(ptr));
-			this->_rmgr.template add<C>(_ek, std::move(ref));
-		}
-	};
+	bool has(aekp aek, const char* cname)
+	{
+		return has(aek, _find(cname));
+	}
 
-	void add(aekp aek, const char** cnames, void** refs)
+	bool has(_entity_t e, const char* cname)
 	{
-		_add_hlp hlp(_rmgr, cnames, refs, _get(aek));
-		for_each_comp(hlp);
+		return has(e, _find(cname));
 	}
 
-	struct _rmv_hlp : _allc_hlp<_rmv_hlp>
+	bool has_all(aekp aek, const char** cnames)
 	{
-		_ek_t _ek;
+		return _rmgr.has_all_bits(_get(aek), _bits(cnames));
+	}
 
-		_rmv_hlp(_mgr_t& mgr, const char** cnames, _ek_t ek)
-		 : _allc_hlp<_rmv_hlp>(mgr, cnames)
-		 , _ek(ek)
-		{ }
+	bool has_some(aekp aek, const char** cnames)
+	{
+		return _rmgr.has_some_bits(_get(aek), _bits(cnames));
+	}
 
-		template <typename C>
-		void operate(mp::identity<C>, void*)
+	void reserve(std::size_t n, const char** cnames)
+	{
+		assert(cnames);
+		for(; *cnames; ++cnames)
 		{
-			this->_rmgr.template remove<C>(_ek);
+			if(const _component_ops* ops = _ops(_find(*cnames)))
+			{
+				ops->reserve(_rmgr, n);
+			}
 		}
-	};
+	}
 
-	void remove(aekp aek, const char** cnames)
+	void add(aekp aek, any_component_id cid, void* ptr)
 	{
-		_rmv_hlp hlp(_rmgr, cnames, _get(aek));
-		for_each_comp(hlp);
+		if(const _component_ops* ops = _ops(cid))
+		{
+			assert(ptr);
+			ops->add(_rmgr, _get(aek), ptr);
+		}
 	}
 
-	struct _cpy_hlp : _allc_hlp<_cpy_hlp>
+	void add(aekp aek, const char** cnames, void** ptrs)
 	{
-		_ek_t _ekf;
-		_ek_t _ekt;
+		assert(cnames);
+		assert(ptrs);
+		for(; *cnames; ++cnames, ++ptrs)
+		{
+			add(aek, _find(*cnames), *ptrs);
+		}
+	}
 
-		_cpy_hlp(_mgr_t& mgr, const char** cnames, _ek_t ekf, _ek_t ekt)
-		 : _allc_hlp<_cpy_hlp>(mgr, cnames)
-		 , _ekf(ekf)
-		 , _ekt(ekt)
-		{ }
+	void remove(aekp aek, any_component_id cid)
+	{
+		if(const _component_ops* ops = _ops(cid))
+		{
+			ops->remove(_rmgr, _get(aek));
+		}
+	}
 
-		template <typename C>
-		void operate(mp::identity<C>, void*)
+	void remove(aekp aek, const char** cnames)
+	{
+		assert(cnames);
+		for(; *cnames; ++cnames)
 		{
-			this->_rmgr.template copy<C>(_ekf, _ekt);
+			remove(aek, _find(*cnames));
 		}
-	};
+	}
 
 	void copy(aekp aek_from, aekp aek_to, const char** cnames)
 	{
-		_cpy_hlp hlp(_rmgr, cnames, _get(aek_from), _get(aek_to));
-		for_each_comp(hlp);
+		assert(cnames);
+		for(; *cnames; ++cnames)
+		{
+			if(const _component_ops* ops = _ops(_find(*cnames)))
+			{
+				ops->copy(_rmgr, _get(aek_from), _get(aek_to));
+			}
+		}
 	}
 
-	struct _ltlk_hlp : _onec_hlp<_ltlk_hlp>
+	any_lock lifetime_lock(any_component_id cid)
 	{
-		any_lock _res;
-
-		_ltlk_hlp(_mgr_t& mgr, const char* cname)
-		 : _onec_hlp<_ltlk_hlp>(mgr, cname)
-		{ }
-
-		template <typename C>
-		void operate(mp::identity<C>)
+		if(const _component_ops* ops = _ops(cid))
 		{
-			_res = any_lock(
-				this->_rmgr.template lifetime_lock<C>()
-			);
+			return ops->lifetime_lock(_rmgr);
 		}
-	};
+		return any_lock();
+	}
 
 	any_lock lifetime_lock(const char* cname)
 	{
-		_ltlk_hlp hlp(_rmgr, cname);
-		return std::move(for_each_comp(hlp)._res);
+		return lifetime_lock(_find(cname));
 	}
 
-	struct _ralk_hlp : _onec_hlp<_ralk_hlp>
+	any_lock raw_access_lock(any_component_id cid)
 	{
-		any_lock _res;
-
-		_ralk_hlp(_mgr_t& mgr, const char* cname)
-		 : _onec_hlp<_ralk_hlp>(mgr, cname)
-		{ }
-
-		template <typename C>
-		void operate(mp::identity<C>)
+		if(const _component_ops* ops = _ops(cid))
 		{
-			_res = any_lock(
-				this->_rmgr.template raw_access_lock<C>()
-			);
+			return ops->raw_access_lock(_rmgr);
 		}
-	};
+		return any_lock();
+	}
 
 	any_lock raw_access_lock(const char* cname)
 	{
-		_ralk_hlp hlp(_rmgr, cname);
-		return std::move(for_each_comp(hlp)._res);
+		return raw_access_lock(_find(cname));
 	}
 
 	typedef std::vector<std::size_t> entity_update_op;
@@ -344,29 +394,116 @@ public:
 		_rmgr.finish_update(_get(aek), update_op);
 	}
 
-	struct _ra_hlp : _onec_hlp<_ra_hlp>
+	void* raw_access(aekp aek, any_component_id cid)
 	{
-		_ek_t _ek;
-		void* _res;
+		if(const _component_ops* ops = _ops(cid))
+		{
+			return ops->raw_access(_rmgr, _get(aek));
+		}
+		return nullptr;
+	}
 
-		_ra_hlp(_mgr_t& mgr, const char* cname, _ek_t ek)
-		 : _onec_hlp<_ra_hlp>(mgr, cname)
-		 , _ek(ek)
-		 , _res(nullptr)
-		{ }
+	void* raw_access(aekp aek, const char* cname)
+	{
+		return raw_access(aek, _find(cname));
+	}
 
-		template <typename C>
-		void operate(mp::identity<C>)
+	void has_all_n(
+		const any_entity_key* keys,
+		std::size_t n,
+		const any_component_id* cids,
+		std::size_t count,
+		bool* out
+	)
+	{
+		_rmgr.has_all_bits(_keys(keys, n).data(), n, _bits(cids, count), out);
+	}
+
+	void add_n(
+		const any_entity_key* keys,
+		std::size_t n,
+		const any_component_id* cids,
+		std::size_t count,
+		void* const* arrays
+	)
+	{
+		std::vector<const _component_ops*> ops(count);
+		for(std::size_t c=0; c!=count; ++c)
 		{
-			C& ref = this->_rmgr.template raw_access<C>(_ek);
-			_res = &ref;
+			ops[c] = _ops(cids[c]);
 		}
-	};
+		const detail::component_bitset<Group> bits = _bits(cids, count);
 
-	void* raw_access(aekp aek, const char* cname)
+		// all components are added to an entity in a single operation
+		for(std::size_t i=0; i!=n; ++i)
+		{
+			_rmgr._do_add_seq(
+				_get(keys[i]),
+				bits,
+				[&ops, arrays, count, i](_adder& adder)
+				{
+					for(std::size_t c=0; c!=count; ++c)
+					{
+						if(ops[c])
+						{
+							ops[c]->add_to(adder, arrays[c], i);
+						}
+					}
+				}
+			);
+		}
+	}
+
+	void remove_n(
+		const any_entity_key* keys,
+		std::size_t n,
+		const any_component_id* cids,
+		std::size_t count
+	)
 	{
-		_ra_hlp hlp(_rmgr, cname, _get(aek));
-		return for_each_comp(hlp)._res;
+		std::vector<const _component_ops*> ops(count);
+		for(std::size_t c=0; c!=count; ++c)
+		{
+			ops[c] = _ops(cids[c]);
+		}
+		const detail::component_bitset<Group> bits = _bits(cids, count);
+
+		for(std::size_t i=0; i!=n; ++i)
+		{
+			_rmgr._do_rem_seq(
+				_get(keys[i]),
+				bits,
+				[&ops, count](_remover& remover)
+				{
+					for(std::size_t c=0; c!=count; ++c)
+					{
+						if(ops[c]) ops[c]->remove_from(remover);
+					}
+				}
+			);
+		}
+	}
+
+	void raw_access_n(
+		const any_entity_key* keys,
+		std::size_t n,
+		any_component_id cid,
+		void** out
+	)
+	{
+		if(const _component_ops* ops = _ops(cid))
+		{
+			ops->raw_access_n(_rmgr, _keys(keys, n).data(), n, out);
+		}
+		else std::fill(out, out+n, nullptr);
+	}
+
+	void column(any_component_id cid, any_component_column& col)
+	{
+		if(const _component_ops* ops = _ops(cid))
+		{
+			ops->column(_rmgr, col);
+		}
 	}
 
 	void for_each_imk(
@@ -410,31 +547,12 @@ public:
 		this->_rmgr.for_each(func_wrap);
 	}
 
-	struct _fec_hlp : _onec_hlp<_fec_hlp>
+	void for_each_c(const void* pstd_fn, const char* cname)
 	{
-		const void* _pstd_fn;
-
-		_fec_hlp(_mgr_t& mgr, const char* cname, const void* pstd_fn)
-		 : _onec_hlp<_fec_hlp>(mgr, cname)
-		 , _pstd_fn(pstd_fn)
-		{
-			assert(_pstd_fn);
-		}
-
-		template <typename C>
-		void operate(mp::identity<C>)
+		if(const _component_ops* ops = _ops(_find(cname)))
 		{
-			assert(_pstd_fn);
-			typedef std::function<bool (C&)> Fn;
-			const Fn& func = *(static_cast<const Fn*>(_pstd_fn));
-			this->_rmgr.template for_each<C>(func);
+			ops->for_each(_rmgr, pstd_fn);
 		}
-	};
-
-	void for_each_c(const void* pstd_fn, const char* cname)
-	{
-		_fec_hlp hlp(_rmgr, cname, pstd_fn);
-		for_each_comp(hlp);
 	}
 };
 //------------------------------------------------------------------------------
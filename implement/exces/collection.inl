@@ -23,9 +23,11 @@ _register(void)
 template <typename Group>
 collection_intf<Group>::
 collection_intf(collection_intf&& tmp)
- : _pmanager(tmp.pmanager)
+ : _pmanager(tmp._pmanager)
  , _cur_uk(tmp._cur_uk)
+ , _name(std::move(tmp._name))
 {
+	_update_stats_ids();
 	if(_pmanager)
 	{
 		_pmanager->move_collection(&tmp, this);
@@ -63,43 +65,102 @@ _manager(void) const
 	return *_pmanager;
 }
 //------------------------------------------------------------------------------
+template <typename Group>
+template <typename KeySet>
+void
+collection_intf<Group>::
+_for_each(
+	const KeySet& keys,
+	entity_cursor<Group>& cursor,
+	const iter_budget& budget,
+	const std::function<bool(
+		const iter_info&,
+		manager<Group>&,
+		typename manager<Group>::entity_key
+	)>& function
+) const
+{
+	if(cursor.done()) return;
+
+	EXCES_MANAGER_STATS_SCOPE_ID(this->_stats_id(2))
+
+	typename KeySet::const_iterator
+		i = keys.resume_point(cursor),
+		e = keys.end();
+
+	iter_info ii(
+		cursor.visited(),
+		cursor.visited()+std::size_t(e-i)
+	);
+	iter_budget::tracker tracker(budget);
+
+	while(i != e)
+	{
+		if(!tracker.affordable())
+		{
+			return;
+		}
+		tracker.spend();
+		auto k = *i;
+		cursor._advance(k->first);
+
+		if(!function(ii, this->_manager(), k))
+			break;
+		++i;
+		ii.step();
+	}
+	cursor._finish();
+}
+//------------------------------------------------------------------------------
 // collection
 //------------------------------------------------------------------------------
-template <typename Group>
+template <typename Group, typename KeySet>
+bool
+collection<Group, KeySet>::
+_matches(entity_key key)
+{
+	if(_filter_masks)
+	{
+		return this->_manager().matches_masks(key, *_filter_masks);
+	}
+	return !_filter_entity || _filter_entity(this->_manager(), key);
+}
+//------------------------------------------------------------------------------
+template <typename Group, typename KeySet>
 void
-collection<Group>::
+collection<Group, KeySet>::
 insert(entity_key key)
 {
-	if(!_filter_entity || _filter_entity(this->_manager(), key))
+	if(_matches(key))
 	{
 		assert(!_entities.contains(key));
 		_entities.insert(key);
 	}
 }
 //------------------------------------------------------------------------------
-template <typename Group>
+template <typename Group, typename KeySet>
 void
-collection<Group>::
+collection<Group, KeySet>::
 remove(entity_key key)
 {
 	assert(_entities.contains(key));
 	_entities.erase(key);
 }
 //------------------------------------------------------------------------------
-template <typename Group>
-typename collection<Group>::update_key
-collection<Group>::
+template <typename Group, typename KeySet>
+typename collection<Group, KeySet>::update_key
+collection<Group, KeySet>::
 begin_update(entity_key)
 {
 	return 0;
 }
 //------------------------------------------------------------------------------
-template <typename Group>
+template <typename Group, typename KeySet>
 void
-collection<Group>::
+collection<Group, KeySet>::
 finish_update(entity_key ekey, update_key)
 {
-	if(!_filter_entity || _filter_entity(this->_manager(), ekey))
+	if(_matches(ekey))
 	{
 		_entities.insert(ekey);
 	}
@@ -109,9 +170,9 @@ finish_update(entity_key ekey, update_key)
 	}
 }
 //------------------------------------------------------------------------------
-template <typename Group>
+template <typename Group, typename KeySet>
 void
-collection<Group>::
+collection<Group, KeySet>::
 for_each(
 	const std::function<bool(
 		const iter_info&,
@@ -120,6 +181,8 @@ for_each(
 	)>& function
 ) const
 {
+	EXCES_MANAGER_STATS_SCOPE_ID(this->_stats_id(2))
+
 	typename _entity_key_set::const_iterator
 		i = _entities.begin(),
 		e = _entities.end();
@@ -136,10 +199,31 @@ for_each(
 	}
 }
 //------------------------------------------------------------------------------
-template <typename Group>
+template <typename Group, typename KeySet>
+collection_memory_stats
+collection<Group, KeySet>::
+memory_stats(void) const
+{
+	collection_memory_stats result;
+	result.name = this->name();
+	result.key_count = _entities.size();
+	result.class_count = 1;
+	result.bytes = _entities.memory_bytes();
+	return result;
+}
+//------------------------------------------------------------------------------
+template <typename Group, typename KeySet>
+std::size_t
+collection<Group, KeySet>::
+shrink_to_fit(void)
+{
+	return _entities.shrink_to_fit();
+}
+//------------------------------------------------------------------------------
+template <typename Group, typename KeySet>
 inline
 void
-collection<Group>::
+collection<Group, KeySet>::
 _instantiate(void)
 {
 	manager<Group> m;
@@ -147,14 +231,14 @@ _instantiate(void)
 		manager<Group>&,
 		typename manager<Group>::entity_key
 	)> fi;
-	collection<Group> c(m, fi);
+	collection<Group, KeySet> c(m, fi);
 }
 //------------------------------------------------------------------------------
 // classification
 //------------------------------------------------------------------------------
-template <typename Class, typename Group>
+template <typename Class, typename Group, typename KeySet>
 void
-classification<Class, Group>::
+classification<Class, Group, KeySet>::
 insert(entity_key key, Class entity_class)
 {
 	typename _class_map::iterator p =
@@ -175,9 +259,9 @@ insert(entity_key key, Class entity_class)
 	}
 }
 //------------------------------------------------------------------------------
-template <typename Class, typename Group>
+template <typename Class, typename Group, typename KeySet>
 void
-classification<Class, Group>::
+classification<Class, Group, KeySet>::
 insert(entity_key key)
 {
 	if(!_filter_entity || _filter_entity(this->_manager(), key))
@@ -190,9 +274,9 @@ insert(entity_key key)
 	}
 }
 //------------------------------------------------------------------------------
-template <typename Class, typename Group>
+template <typename Class, typename Group, typename KeySet>
 void
-classification<Class, Group>::
+classification<Class, Group, KeySet>::
 remove(entity_key key, Class entity_class)
 {
 	// find its class
@@ -203,9 +287,9 @@ remove(entity_key key, Class entity_class)
 	cp->second.erase(key);
 }
 //------------------------------------------------------------------------------
-template <typename Class, typename Group>
+template <typename Class, typename Group, typename KeySet>
 void
-classification<Class, Group>::
+classification<Class, Group, KeySet>::
 remove(entity_key key)
 {
 	if(!_filter_entity || _filter_entity(this->_manager(), key))
@@ -218,9 +302,9 @@ remove(entity_key key)
 	}
 }
 //------------------------------------------------------------------------------
-template <typename Class, typename Group>
-typename classification<Class, Group>::update_key
-classification<Class, Group>::
+template <typename Class, typename Group, typename KeySet>
+typename classification<Class, Group, KeySet>::update_key
+classification<Class, Group, KeySet>::
 begin_update(entity_key key)
 {
 	update_key result = 0;
@@ -243,26 +327,33 @@ begin_update(entity_key key)
 	return result;
 }
 //------------------------------------------------------------------------------
-template <typename Class, typename Group>
+template <typename Class, typename Group, typename KeySet>
 void
-classification<Class, Group>::
+classification<Class, Group, KeySet>::
 finish_update(entity_key ekey, update_key ukey)
 {
+	typename _class_map::iterator old_class = _classes.end();
+
 	typename _update_map::iterator u = _updates.find(ukey);
+	if(u != _updates.end())
+	{
+		old_class = u->second;
+		_updates.erase(u);
+	}
 
 	if(!_filter_entity || _filter_entity(this->_manager(), ekey))
 	{
 		Class new_class = _classify(this->_manager(), ekey);
 
 		// if the entity was previously classified
-		if(u != _updates.end())
+		if(old_class != _classes.end())
 		{
 			// and it was classified differently
-			if(u->second->first != new_class)
+			if(old_class->first != new_class)
 			{
 				// erase it from the vector
 				// in the old class
-				u->second->second.erase(ekey);
+				old_class->second.erase(ekey);
 			}
 			// if its previous class was the same
 			// no need to reclassify
@@ -278,26 +369,79 @@ finish_update(entity_key ekey, update_key ukey)
 	else
 	{
 		// if the entity was previously classified
-		if(u != _updates.end())
+		if(old_class != _classes.end())
 		{
 			// erase it from the vector
 			// in the old class
-			u->second->second.erase(ekey);
+			old_class->second.erase(ekey);
 		}
 	}
 }
 //------------------------------------------------------------------------------
-template <typename Class, typename Group>
+template <typename Class, typename Group, typename KeySet>
 std::size_t
-classification<Class, Group>::
+classification<Class, Group, KeySet>::
 class_count(void) const
 {
 	return _classes.size();
 }
 //------------------------------------------------------------------------------
-template <typename Class, typename Group>
+template <typename Class, typename Group, typename KeySet>
+collection_memory_stats
+classification<Class, Group, KeySet>::
+memory_stats(void) const
+{
+	collection_memory_stats result;
+	result.name = this->name();
+	result.key_count = 0;
+	result.class_count = _classes.size();
+	result.bytes = _classes.size()*detail::map_node_bytes<_class_map>();
+	for(const auto& cls : _classes)
+	{
+		result.key_count += cls.second.size();
+		result.bytes += cls.second.memory_bytes();
+	}
+	return result;
+}
+//------------------------------------------------------------------------------
+template <typename Class, typename Group, typename KeySet>
 std::size_t
-classification<Class, Group>::
+classification<Class, Group, KeySet>::
+shrink_to_fit(void)
+{
+	std::size_t result = 0;
+	typename _class_map::iterator i = _classes.begin();
+	while(i != _classes.end())
+	{
+		// the classes of unfinished updates must be kept
+		bool pending = false;
+		for(const auto& u : _updates)
+		{
+			if(u.second == i)
+			{
+				pending = true;
+				break;
+			}
+		}
+
+		if((i->second.size() == 0) && !pending)
+		{
+			result += i->second.memory_bytes();
+			result += detail::map_node_bytes<_class_map>();
+			i = _classes.erase(i);
+		}
+		else
+		{
+			result += i->second.shrink_to_fit();
+			++i;
+		}
+	}
+	return result;
+}
+//------------------------------------------------------------------------------
+template <typename Class, typename Group, typename KeySet>
+std::size_t
+classification<Class, Group, KeySet>::
 cardinality(const Class& entity_class) const
 {
 	auto p = _classes.find(entity_class);
@@ -305,9 +449,9 @@ cardinality(const Class& entity_class) const
 	return p->second.size();
 }
 //------------------------------------------------------------------------------
-template <typename Class, typename Group>
+template <typename Class, typename Group, typename KeySet>
 void
-classification<Class, Group>::
+classification<Class, Group, KeySet>::
 for_each(
 	const Class& entity_class,
 	const std::function<bool(
@@ -321,6 +465,8 @@ for_each(
 		_classes.find(entity_class);
 	if(p != _classes.end())
 	{
+		EXCES_MANAGER_STATS_SCOPE_ID(this->_stats_id(2))
+
 		typename _entity_key_set::const_iterator
 			i = p->second.begin(),
 			e = p->second.end();
@@ -338,11 +484,34 @@ for_each(
 	}
 }
 //------------------------------------------------------------------------------
+template <typename Class, typename Group, typename KeySet>
+void
+classification<Class, Group, KeySet>::
+for_each(
+	const Class& entity_class,
+	entity_cursor<Group>& cursor,
+	const iter_budget& budget,
+	const std::function<bool(
+		const iter_info&,
+		manager<Group>&,
+		typename manager<Group>::entity_key
+	)>& function
+) const
+{
+	typename _class_map::const_iterator p =
+		_classes.find(entity_class);
+	if(p != _classes.end())
+	{
+		this->_for_each(p->second, cursor, budget, function);
+	}
+	else cursor._finish();
+}
+//------------------------------------------------------------------------------
 // forced instantiation
 //------------------------------------------------------------------------------
-template <typename Class, typename Group>
+template <typename Class, typename Group, typename KeySet>
 void
-classification<Class, Group>::
+classification<Class, Group, KeySet>::
 _instantiate(void)
 {
 	manager<Group> m;
@@ -359,7 +528,7 @@ _instantiate(void)
 		manager<Group>&,
 		typename manager<Group>::entity_key
 	)> fe;
-	classification<Class, Group> c(m, fi, cl);
+	classification<Class, Group, KeySet> c(m, fi, cl);
 	c.cardinality(Class());
 	c.for_each(Class(), fe);
 }
@@ -41,11 +41,13 @@ get(const component_bitset<Group>& bits)
 	// if a new element was inserted
 	if(r.second)
 	{
+		// the index of a component is the rank of its bit
+		index_vector& indices = r.first->second;
 		_component_index_t i = 0;
-		for(std::size_t j=0; j!=_component_count(); ++j)
+		bits.for_each_set([&indices, &i](std::size_t j)
 		{
-			if(bits[j]) r.first->second[j] = i++;
-		}
+			indices[j] = i++;
+		});
 	}
 	return r.first->second;
 }
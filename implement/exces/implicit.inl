@@ -7,7 +7,7 @@
  *  LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
  */
 
-#include <stack>
+#include <atomic>
 #include <utility>
 
 namespace exces {
@@ -15,30 +15,61 @@ namespace exces {
 //------------------------------------------------------------------------------
 // implicit_manager
 //------------------------------------------------------------------------------
+// the top of the calling thread's stack of implicit managers, the rest
+// of the stack is linked through the _prev members of implicit_manager
 template <typename Group>
 static inline
-std::stack<manager<Group>*>&
-implicit_manager_stack(void)
+manager<Group>*&
+implicit_manager_top(void)
 {
-	static std::stack<manager<Group>*> _ms;
-	return _ms;
+	static thread_local manager<Group>* _top = nullptr;
+	return _top;
+}
+//------------------------------------------------------------------------------
+// the top of the process-wide stack of implicit managers used by threads
+// which did not install any implicit manager
+template <typename Group>
+static inline
+std::atomic<manager<Group>*>&
+implicit_manager_global(void)
+{
+	static std::atomic<manager<Group>*> _global(nullptr);
+	return _global;
 }
 //------------------------------------------------------------------------------
 template <typename Group>
 implicit_manager<Group>::
 implicit_manager(manager<Group>& m)
  : _m(m)
+ , _prev(implicit_manager_top<Group>())
+ , _global(false)
 {
-	implicit_manager_stack<Group>().push(&_m);
+	implicit_manager_top<Group>() = &_m;
 }
 //------------------------------------------------------------------------------
 template <typename Group>
 implicit_manager<Group>::
+implicit_manager(manager<Group>& m, implicit_global)
+ : _m(m)
+ , _prev(implicit_manager_global<Group>().exchange(&_m))
+ , _global(true)
+{ }
+//------------------------------------------------------------------------------
+template <typename Group>
+implicit_manager<Group>::
 ~implicit_manager(void)
 {
-	assert(!implicit_manager_stack<Group>().empty());
-	assert(implicit_manager_stack<Group>().top() == &_m);
-	implicit_manager_stack<Group>().pop();
+	if(_global)
+	{
+		manager<Group>* top = implicit_manager_global<Group>().exchange(_prev);
+		assert(top == &_m);
+		(void)top;
+	}
+	else
+	{
+		assert(implicit_manager_top<Group>() == &_m);
+		implicit_manager_top<Group>() = _prev;
+	}
 }
 //------------------------------------------------------------------------------
 template <typename Group>
@@ -46,9 +77,10 @@ manager<Group>&
 implicit_manager<Group>::
 get(void)
 {
-	assert(!implicit_manager_stack<Group>().empty());
-	assert(implicit_manager_stack<Group>().top() != nullptr);
-	return *(implicit_manager_stack<Group>().top());
+	manager<Group>* top = implicit_manager_top<Group>();
+	if(!top) top = implicit_manager_global<Group>().load();
+	assert(top != nullptr);
+	return *top;
 }
 //------------------------------------------------------------------------------
 // forced instantiation
@@ -61,6 +93,8 @@ _instantiate(void)
 	manager<Group> m;
 	bool check = (&implicit_manager<Group>(m).get() == &m);
 	assert(check);
+	check = (&implicit_manager<Group>(m, implicit_global()).get() == &m);
+	assert(check);
 }
 //------------------------------------------------------------------------------
 
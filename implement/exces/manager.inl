@@ -125,6 +125,7 @@ _begin_collection_update(
 	{
 		collection_intf<Group>* pc = *i;
 		assert(pc != nullptr);
+		EXCES_MANAGER_STATS_SCOPE_ID(pc->_stats_id(0))
 		result[j] = pc->begin_update(key);
 		++i;
 		++j;
@@ -154,6 +155,7 @@ _finish_collection_update(
 	{
 		collection_intf<Group>* pc = *i;
 		assert(pc != nullptr);
+		EXCES_MANAGER_STATS_SCOPE_ID(pc->_stats_id(1))
 		pc->finish_update(key, *u);
 		++i;
 		++u;
@@ -171,6 +173,8 @@ _do_add_seq(
 	>& for_each_seq
 )
 {
+	EXCES_MANAGER_STATS_SCOPE("manager::add")
+
 	_unique_lock ulci(_component_index_mutex);
 	_unique_lock ulei(_entity_info_mutex);
 
@@ -184,7 +188,12 @@ _do_add_seq(
 
 	const std::size_t cc = _component_count();
 	_component_key_vector tmp_keys(cc);
-	_component_adder adder = { _storage, tmp_keys };
+	_component_adder adder = {
+		_storage,
+		tmp_keys,
+		_change_log,
+		ek->first
+	};
 	{
 		_unique_lock uls(_storage_mutex);
 		for_each_seq(adder);
@@ -198,25 +207,19 @@ _do_add_seq(
 		&old_map = _component_indices.get(old_bits),
 		&new_map = _component_indices.get(new_bits);
 
-	for(std::size_t i=0; i!=cc; ++i)
+	assert(new_bits.contains(old_bits));
+	new_bits.for_each_set([&](std::size_t i)
 	{
-		if(new_bits.test(i))
+		if(old_bits.test(i))
 		{
-			if(old_bits.test(i))
-			{
-				new_keys[new_map[i]] =
-					old_keys[old_map[i]];
-			}
-			else
-			{
-				new_keys[new_map[i]] = tmp_keys[i];
-			}
+			new_keys[new_map[i]] =
+				old_keys[old_map[i]];
 		}
 		else
 		{
-			assert(!old_bits.test(i));
+			new_keys[new_map[i]] = tmp_keys[i];
 		}
-	}
+	});
 	swap(new_keys, old_keys);
 
 	_finish_collection_update(ek, updates);
@@ -233,12 +236,14 @@ _do_rem_seq(
 	>& for_each_seq
 )
 {
+	EXCES_MANAGER_STATS_SCOPE("manager::remove")
+
 	_unique_lock ulci(_component_index_mutex);
 	_unique_lock ulei(_entity_info_mutex);
 
 	auto updates = _begin_collection_update(ek);
 
-	if((ek->second._component_bits & rem_bits) != rem_bits)
+	if(!ek->second._component_bits.contains(rem_bits))
 	{
 		throw ::std::invalid_argument(
 			"exces::entity manager: "
@@ -249,7 +254,7 @@ _do_rem_seq(
 
 	_component_bitset  old_bits = ek->second._component_bits;
 
-	ek->second._component_bits &= ~rem_bits;
+	ek->second._component_bits.and_not(rem_bits);
 
 	_component_bitset& new_bits = ek->second._component_bits;
 	
@@ -263,27 +268,26 @@ _do_rem_seq(
 
 	const std::size_t cc = _component_count();
 	_component_key_vector tmp_keys(cc);
-	for(std::size_t i=0; i!=cc; ++i)
+	assert(old_bits.contains(new_bits));
+	old_bits.for_each_set([&](std::size_t i)
 	{
 		if(new_bits.test(i))
 		{
-			if(old_bits.test(i))
-			{
-				new_keys[new_map[i]] =
-					old_keys[old_map[i]];
-			}
-			else assert(!"Logic error!");
+			new_keys[new_map[i]] =
+				old_keys[old_map[i]];
 		}
 		else
 		{
-			if(old_bits.test(i))
-			{
-				tmp_keys[i] = old_keys[old_map[i]];
-			}
+			tmp_keys[i] = old_keys[old_map[i]];
 		}
-	}
+	});
 
-	_component_remover remover = { _storage, tmp_keys };
+	_component_remover remover = {
+		_storage,
+		tmp_keys,
+		_change_log,
+		ek->first
+	};
 	{
 		_unique_lock uls(_storage_mutex);
 		for_each_seq(remover);
@@ -305,12 +309,14 @@ _do_rep_seq(
 	>& for_each_seq
 )
 {
+	EXCES_MANAGER_STATS_SCOPE("manager::replace")
+
 	_unique_lock ulci(_component_index_mutex);
 	_unique_lock ulei(_entity_info_mutex);
 
 	auto updates = _begin_collection_update(ek);
 
-	if((ek->second._component_bits & rep_bits) != rep_bits)
+	if(!ek->second._component_bits.contains(rep_bits))
 	{
 		throw ::std::invalid_argument(
 			"exces::entity manager: "
@@ -329,27 +335,26 @@ _do_rep_seq(
 	const std::size_t cc = _component_count();
 	_component_key_vector tmp_keys(cc);
 
-	for(std::size_t i=0; i!=cc; ++i)
+	new_bits.for_each_set([&](std::size_t i)
 	{
-		if(new_bits.test(i))
-		{
-			tmp_keys[i] = new_keys[new_map[i]];
-		}
-	}
+		tmp_keys[i] = new_keys[new_map[i]];
+	});
 
-	_component_replacer replacer = { _storage, tmp_keys };
+	_component_replacer replacer = {
+		_storage,
+		tmp_keys,
+		_change_log,
+		ek->first
+	};
 	{
 		_unique_lock uls(_storage_mutex);
 		for_each_seq(replacer);
 	}
 
-	for(std::size_t i=0; i!=cc; ++i)
+	new_bits.for_each_set([&](std::size_t i)
 	{
-		if(new_bits.test(i))
-		{
-			new_keys[new_map[i]] = tmp_keys[i];
-		}
-	}
+		new_keys[new_map[i]] = tmp_keys[i];
+	});
 
 	_finish_collection_update(ek, updates);
 }
@@ -366,6 +371,8 @@ _do_cpy_seq(
 	>& for_each_seq
 )
 {
+	EXCES_MANAGER_STATS_SCOPE("manager::copy")
+
 	_unique_lock ulci(_component_index_mutex);
 	_unique_lock ulei(_entity_info_mutex);
 
@@ -387,7 +394,9 @@ _do_cpy_seq(
 		fei._component_keys,
 		tei._component_keys,
 		src_map,
-		dst_map
+		dst_map,
+		_change_log,
+		t->first
 	};
 	{
 		_unique_lock uls(_storage_mutex);
@@ -398,6 +407,543 @@ _do_cpy_seq(
 }
 //------------------------------------------------------------------------------
 template <typename Group>
+manager_memory_stats
+manager<Group>::
+memory_stats(void)
+{
+	manager_memory_stats result;
+	{
+		_shared_lock slem(_entity_map_mutex);
+		_shared_lock slei(_entity_info_mutex);
+
+		result.entity_count = _entities.size();
+		result.entity_bytes =
+			_entities.size()*
+			detail::map_node_bytes<_entity_info_map>();
+		result.component_key_count = 0;
+		result.component_key_bytes = 0;
+		for(const auto& ei : _entities)
+		{
+			const _component_key_vector& keys =
+				ei.second._component_keys;
+			result.component_key_count += keys.size();
+			result.component_key_bytes +=
+				keys.capacity()*
+				sizeof(typename _component_key_vector::value_type);
+		}
+	}
+	{
+		_shared_lock slci(_component_index_mutex);
+		result.component_index_entries = _component_indices.size();
+		result.component_index_bytes = _component_indices.memory_bytes();
+	}
+	{
+		_shared_lock slst(_storage_mutex);
+		result.components = _storage.memory_stats();
+	}
+	{
+		_shared_lock slcm(_collection_mutex);
+		result.collections.reserve(_collections.size());
+		for(collection_intf<Group>* pc : _collections)
+		{
+			assert(pc != nullptr);
+			result.collections.push_back(pc->memory_stats());
+		}
+	}
+	return result;
+}
+//------------------------------------------------------------------------------
+template <typename Group>
+std::size_t
+manager<Group>::
+shrink_to_fit(void)
+{
+	std::size_t result = 0;
+	{
+		_unique_lock ulst(_storage_mutex);
+		result += _storage.shrink_to_fit();
+	}
+	{
+		_unique_lock ulcm(_collection_mutex);
+		for(collection_intf<Group>* pc : _collections)
+		{
+			assert(pc != nullptr);
+			result += pc->shrink_to_fit();
+		}
+	}
+	return result;
+}
+//------------------------------------------------------------------------------
+template <typename Group>
+void
+manager<Group>::
+save_snapshot(std::ostream& output)
+{
+	EXCES_MANAGER_STATS_SCOPE("manager::save_snapshot")
+
+	_shared_lock slem(_entity_map_mutex);
+	_shared_lock slei(_entity_info_mutex);
+	_shared_lock slst(_storage_mutex);
+
+	detail::snapshot_writer w(output);
+	w.write_header();
+
+	// the component names and storages ordered by the component ids
+	const std::vector<std::string> names = _storage.names();
+	w.write_size(names.size());
+	for(const std::string& name : names)
+	{
+		w.write_string(name);
+	}
+	for(std::size_t id=0; id!=names.size(); ++id)
+	{
+		_storage.save(id, w);
+	}
+
+	// the entities
+	w.write_size(_entities.size());
+	w.begin_values<entity_type>(_entities.size());
+	for(const _entity_info_entry& ei : _entities)
+	{
+		w.write_value(ei.first);
+	}
+	w.finish_values<entity_type>();
+
+	// the component bitsets of the entities, packed into bytes
+	std::vector<unsigned char> bytes((names.size()+7)/8);
+	std::size_t key_count = 0;
+	for(const _entity_info_entry& ei : _entities)
+	{
+		const _component_bitset& bits = ei.second._component_bits;
+		std::fill(bytes.begin(), bytes.end(), 0);
+		for(std::size_t c=0; c!=names.size(); ++c)
+		{
+			if(bits[c]) bytes[c/8] |= (1 << (c%8));
+		}
+		w.write_bytes(bytes.data(), bytes.size());
+		key_count += ei.second._component_keys.size();
+	}
+	w.align();
+
+	// the offsets of the first component key of each entity
+	w.write_size(key_count);
+	w.align();
+	std::uint64_t key_offset = 0;
+	for(const _entity_info_entry& ei : _entities)
+	{
+		w.write(key_offset);
+		key_offset += ei.second._component_keys.size();
+	}
+	w.align();
+
+	// the component keys of the entities, ordered by the component ids
+	std::vector<std::uint64_t> keys;
+	for(const _entity_info_entry& ei : _entities)
+	{
+		const _component_key_vector& ckv = ei.second._component_keys;
+		keys.assign(ckv.begin(), ckv.end());
+		w.write_bytes(keys.data(), keys.size()*sizeof(std::uint64_t));
+	}
+	w.align();
+}
+//------------------------------------------------------------------------------
+template <typename Group>
+void
+manager<Group>::
+load_snapshot(std::istream& input)
+{
+	EXCES_MANAGER_STATS_SCOPE("manager::load_snapshot")
+
+	_unique_lock ulci(_component_index_mutex);
+	_unique_lock ulem(_entity_map_mutex);
+	_unique_lock ulei(_entity_info_mutex);
+	_unique_lock ulst(_storage_mutex);
+	_unique_lock ulcm(_collection_mutex);
+
+	if(!_entities.empty())
+	{
+		throw std::invalid_argument(
+			"exces::load_snapshot: the manager is not empty"
+		);
+	}
+
+	std::vector<typename _entity_info_map::iterator> eks;
+	try { _load_snapshot(input, eks); }
+	catch(...)
+	{
+		// the entities must not refer to partially loaded
+		// or invalid slots, the manager is left empty
+		_entities.clear();
+		_storage.clear();
+		throw;
+	}
+
+	for(collection_intf<Group>* pc : _collections)
+	{
+		assert(pc != nullptr);
+		for(auto ek : eks)
+		{
+			pc->insert(ek);
+		}
+	}
+}
+//------------------------------------------------------------------------------
+template <typename Group>
+void
+manager<Group>::
+_load_snapshot(
+	std::istream& input,
+	std::vector<typename manager<Group>::_entity_info_map::iterator>& eks
+)
+{
+	detail::snapshot_reader r(input);
+	r.read_header();
+
+	// map the saved components to the ids of the components
+	// in the Group with the same names (or to the component
+	// count if the Group does not contain the component)
+	const std::vector<std::string> names = _storage.names();
+	const std::size_t saved_count = r.read_size();
+	std::vector<std::string> saved_names(saved_count);
+	std::vector<std::size_t> ids(saved_count, _component_count::value);
+	std::vector<bool> loaded(_component_count::value, false);
+	for(std::size_t i=0; i!=saved_count; ++i)
+	{
+		saved_names[i] = r.read_string();
+		auto p = std::find(names.begin(), names.end(), saved_names[i]);
+		if(p != names.end())
+		{
+			ids[i] = std::size_t(p-names.begin());
+			if(loaded[ids[i]])
+			{
+				throw std::invalid_argument(
+					"exces::load_snapshot: duplicate "
+					"component '"+saved_names[i]+"'"
+				);
+			}
+			loaded[ids[i]] = true;
+		}
+	}
+	for(std::size_t i=0; i!=saved_count; ++i)
+	{
+		if(ids[i] != _component_count::value)
+		{
+			_storage.load(ids[i], r);
+		}
+		else skip_component_entries(r);
+	}
+
+	// the entities are saved in the order of the entity map,
+	// so they are inserted at its end
+	const std::size_t entity_count = r.read_size();
+	eks.reserve(entity_count);
+	r.begin_values<entity_type>(entity_count);
+	for(std::size_t e=0; e!=entity_count; ++e)
+	{
+		const std::size_t prev_size = _entities.size();
+		eks.push_back(_entities.insert(
+			_entities.end(),
+			_entity_info_entry(
+				r.read_value<entity_type>(),
+				_entity_info()
+			)
+		));
+		if(_entities.size() == prev_size)
+		{
+			throw std::invalid_argument(
+				"exces::load_snapshot: duplicate entity"
+			);
+		}
+	}
+
+	r.finish_values();
+
+	// the saved component bitsets
+	const std::size_t bit_bytes = (saved_count+7)/8;
+	std::vector<unsigned char> saved_bits(entity_count*bit_bytes);
+	r.read_bytes(saved_bits.data(), saved_bits.size());
+	r.align();
+
+	std::size_t saved_key_count = 0;
+	for(unsigned char byte : saved_bits)
+	{
+		for(; byte; byte &= byte-1) ++saved_key_count;
+	}
+	if(r.read_size() != saved_key_count)
+	{
+		throw std::invalid_argument(
+			"exces::load_snapshot: component key count mismatch"
+		);
+	}
+	// the key offsets are used only by the snapshot_view
+	r.align();
+	r.skip(entity_count*sizeof(std::uint64_t));
+	r.align();
+
+	// the component keys, the keys of skipped components are dropped
+	typedef typename _component_index_map::index_vector index_vector;
+	_component_bitset prev_bits;
+	const index_vector* index = &_component_indices.get(prev_bits);
+	std::vector<std::uint64_t> keys;
+	// the loaded keys of each component, checked against its storage
+	std::vector<std::vector<typename _component_storage::component_key>>
+		loaded_keys(_component_count::value);
+
+	for(std::size_t e=0; e!=entity_count; ++e)
+	{
+		const unsigned char* bytes = saved_bits.data()+e*bit_bytes;
+		_component_bitset bits;
+		keys.clear();
+		for(std::size_t i=0; i!=saved_count; ++i)
+		{
+			if(bytes[i/8] & (1 << (i%8)))
+			{
+				keys.push_back(0);
+				if(ids[i] != _component_count::value)
+				{
+					bits.set(ids[i]);
+				}
+			}
+		}
+		r.read_bytes(keys.data(), keys.size()*sizeof(std::uint64_t));
+
+		if(bits != prev_bits)
+		{
+			index = &_component_indices.get(bits);
+			prev_bits = bits;
+		}
+		_entity_info& info = eks[e]->second;
+		info._component_bits = bits;
+		info._component_keys = _component_key_vector(bits.count());
+
+		for(std::size_t i=0, k=0; i!=saved_count; ++i)
+		{
+			if(bytes[i/8] & (1 << (i%8)))
+			{
+				if(ids[i] != _component_count::value)
+				{
+					const typename _component_storage::
+						component_key key(keys[k]);
+					info._component_keys[(*index)[ids[i]]] = key;
+					loaded_keys[ids[i]].push_back(key);
+				}
+				++k;
+			}
+		}
+	}
+
+	for(std::size_t c=0; c!=_component_count::value; ++c)
+	{
+		if(!_storage.check_keys(c, loaded_keys[c]))
+		{
+			throw std::invalid_argument(
+				"exces::load_snapshot: invalid keys "
+				"of component '"+names[c]+"'"
+			);
+		}
+	}
+}
+//------------------------------------------------------------------------------
+template <typename Group>
+void
+manager<Group>::
+_diff_entity(
+	manager_delta<Group>& delta,
+	const typename entity<Group>::type& e,
+	const typename manager<Group>::_entity_info* from,
+	const typename manager<Group>::_entity_info* to
+)
+{
+	const _component_bitset none;
+	const _component_bitset& from_bits = from?from->_component_bits:none;
+	const _component_bitset& to_bits = to?to->_component_bits:none;
+
+	typename manager_delta<Group>::_entry entry;
+	entry.entity = e;
+
+	// the components present only in one of the entities
+	_component_bitset differ = from_bits;
+	differ ^= to_bits;
+	entry.removed = differ;
+	entry.removed &= from_bits;
+	entry.added = differ;
+	entry.added &= to_bits;
+
+	// the keys are ordered by the component ids
+	const std::size_t cc = _component_count();
+	for(std::size_t i=0, fk=0, tk=0; i!=cc; ++i)
+	{
+		if(to_bits.test(i))
+		{
+			if(from_bits.test(i))
+			{
+				if(delta._columns[i]->append_changed(
+					from->_component_keys[fk],
+					to->_component_keys[tk]
+				)) entry.changed.set(i);
+			}
+			else
+			{
+				delta._columns[i]->append(
+					to->_component_keys[tk]
+				);
+			}
+			++tk;
+		}
+		if(from_bits.test(i)) ++fk;
+	}
+
+	if(differ.any() || entry.changed.any())
+	{
+		if(from_bits.none()) delta._created.push_back(e);
+		if(to_bits.none()) delta._destroyed.push_back(e);
+		delta._entries.push_back(entry);
+	}
+}
+//------------------------------------------------------------------------------
+template <typename Group>
+manager_delta<Group>
+manager<Group>::
+diff(manager<Group>& other)
+{
+	EXCES_MANAGER_STATS_SCOPE("manager::diff")
+
+	manager_delta<Group> result;
+	if(&other == this) return result;
+
+	// the managers are locked in the order of their addresses,
+	// so that concurrent a.diff(b) and b.diff(a) do not deadlock
+	const bool this_first = std::less<const manager*>()(this, &other);
+	manager& first  = this_first?*this:other;
+	manager& second = this_first?other:*this;
+
+	_shared_lock fslem(first._entity_map_mutex);
+	_shared_lock fslei(first._entity_info_mutex);
+	_shared_lock fslst(first._storage_mutex);
+	_shared_lock sslem(second._entity_map_mutex);
+	_shared_lock sslei(second._entity_info_mutex);
+	_shared_lock sslst(second._storage_mutex);
+
+	for(const auto& column : result._columns)
+	{
+		column->begin_diff(_storage, other._storage);
+	}
+
+	// both entity maps are ordered, so they are merged in a single pass
+	typename _entity_info_map::const_iterator
+		i = _entities.begin(),
+		ie= _entities.end(),
+		j = other._entities.begin(),
+		je= other._entities.end();
+
+	const typename _entity_info_map::key_compare less =
+		_entities.key_comp();
+
+	while((i != ie) || (j != je))
+	{
+		if((j == je) || ((i != ie) && less(i->first, j->first)))
+		{
+			_diff_entity(result, i->first, &i->second, nullptr);
+			++i;
+		}
+		else if((i == ie) || less(j->first, i->first))
+		{
+			_diff_entity(result, j->first, nullptr, &j->second);
+			++j;
+		}
+		else
+		{
+			// skip entities with equal bitsets and no components
+			if(	i->second._component_bits.any() ||
+				j->second._component_bits.any()
+			)
+			{
+				_diff_entity(
+					result,
+					i->first,
+					&i->second,
+					&j->second
+				);
+			}
+			++i;
+			++j;
+		}
+	}
+	return result;
+}
+//------------------------------------------------------------------------------
+template <typename Group>
+manager<Group>&
+manager<Group>::
+patch(const manager_delta<Group>& delta)
+{
+	EXCES_MANAGER_STATS_SCOPE("manager::patch")
+
+	typedef typename components<Group>::type all_components;
+	std::vector<std::size_t> positions(_component_count(), 0);
+
+	for(const auto& entry : delta._entries)
+	{
+		entity_key ek = get_key(entry.entity);
+
+		if(entry.removed.any())
+		{
+			_do_rem_seq(
+				ek,
+				entry.removed,
+				[&entry](_component_remover& remover)
+				{
+					_delta_remover dr = {
+						remover,
+						entry.removed
+					};
+					mp::for_each<all_components>(dr);
+				}
+			);
+		}
+		if(entry.added.any())
+		{
+			_do_add_seq(
+				ek,
+				entry.added,
+				[&entry, &delta, &positions](
+					_component_adder& adder
+				)
+				{
+					_delta_applier<_component_adder> da = {
+						adder,
+						entry.added,
+						delta,
+						positions
+					};
+					mp::for_each<all_components>(da);
+				}
+			);
+		}
+		if(entry.changed.any())
+		{
+			_do_rep_seq(
+				ek,
+				entry.changed,
+				[&entry, &delta, &positions](
+					_component_replacer& replacer
+				)
+				{
+					_delta_applier<_component_replacer> da = {
+						replacer,
+						entry.changed,
+						delta,
+						positions
+					};
+					mp::for_each<all_components>(da);
+				}
+			);
+		}
+	}
+	return *this;
+}
+//------------------------------------------------------------------------------
+template <typename Group>
 manager<Group>&
 manager<Group>::
 for_each(
@@ -408,6 +954,8 @@ for_each(
 	)>& function
 )
 {
+	EXCES_MANAGER_STATS_SCOPE("manager::for_each")
+
 	_shared_lock slem(_entity_map_mutex);
 
 	typename _entity_info_map::iterator
@@ -429,6 +977,58 @@ for_each(
 	return *this;
 }
 //------------------------------------------------------------------------------
+template <typename Group>
+manager<Group>&
+manager<Group>::
+for_each(
+	entity_cursor<Group>& cursor,
+	const iter_budget& budget,
+	const std::function<bool (
+		const iter_info&,
+		manager<Group>&,
+		typename manager<Group>::entity_key
+	)>& function
+)
+{
+	if(cursor.done()) return *this;
+
+	EXCES_MANAGER_STATS_SCOPE("manager::for_each")
+
+	_shared_lock slem(_entity_map_mutex);
+
+	typename _entity_info_map::iterator
+		i = cursor.at_start()?
+			_entities.begin():
+			_entities.upper_bound(cursor.last()),
+		e = _entities.end();
+
+	iter_info ii(
+		cursor.visited(),
+		std::max(_entities.size(), cursor.visited())
+	);
+	iter_budget::tracker tracker(budget);
+
+	while(i != e)
+	{
+		if(!tracker.affordable())
+		{
+			return *this;
+		}
+		tracker.spend();
+		cursor._advance(i->first);
+
+		if(!function(ii, *this, i))
+		{
+			break;
+		}
+		++i;
+		ii.step();
+	}
+	cursor._finish();
+
+	return *this;
+}
+//------------------------------------------------------------------------------
 // forced instantiation
 //------------------------------------------------------------------------------
 template <typename Group>
@@ -8,82 +8,180 @@
  */
 
 #include <exces/detail/metaprog.hpp>
+#include <exces/detail/mapped_vector.hpp>
 #include <thread>
 #include <vector>
+#include <limits>
 #include <array>
 #include <map>
+#include <string>
+#include <stdexcept>
+#include <algorithm>
+#include <type_traits>
+#include <cstdint>
 
 namespace exces {
 
-//------------------------------------------------------------------------------
-// component_storage_entry
-//------------------------------------------------------------------------------
-template <typename Component>
-struct component_storage_entry
-{
-	// negative reference count (if < 0)
-	// or the next free component entry
-	// in the vector
-	int _neg_rc_or_nf;
-	Component _component;
-
-	component_storage_entry(Component&& component)
-	 : _neg_rc_or_nf(0)
-	 , _component(std::move(component))
-	{ }
-};
 //------------------------------------------------------------------------------
 // entry_vector
 //------------------------------------------------------------------------------
-template <typename Component>
+template <typename Component, typename VectorSel = detail::std_vector_sel>
 class component_entry_vector
 {
 private:
 	typedef std::size_t component_key;
 
-	std::vector<component_storage_entry<Component> > _ents;
+	// the component instances are stored contiguously
+	typename VectorSel::template apply<Component>::type _components;
+	// negative reference count (if < 0)
+	// or the next free component entry
+	// in the vector (_free_end if there is none)
+	typename VectorSel::template apply<int>::type _neg_rc_or_nf;
 	std::vector<component_key> _gc_keys;
 	int _next_free;
 	int _vector_refs;
 
+	static constexpr int _free_end = std::numeric_limits<int>::max();
+
+	std::size_t _reserved_bytes(void) const
+	{
+		return	_components.capacity()*sizeof(Component)+
+			_neg_rc_or_nf.capacity()*sizeof(int)+
+			_gc_keys.capacity()*sizeof(component_key);
+	}
+
+	// reads n slots from a snapshot into the empty vectors
+	void _load_slots(detail::snapshot_reader& input, std::size_t n)
+	{
+		typedef detail::snapshot_raw<Component> raw;
+		reserve(n);
+
+		// the blocks are read in chunks of this many slots
+		const std::size_t chunk = 4096;
+		std::size_t live = 0;
+		input.align();
+		{
+			std::vector<int> buffer(std::min(n, chunk));
+			for(std::size_t i=0; i!=n; )
+			{
+				const std::size_t k = std::min(n-i, chunk);
+				input.read_bytes(buffer.data(), k*sizeof(int));
+				for(std::size_t j=0; j!=k; ++j)
+				{
+					if(buffer[j] < 0) ++live;
+					_neg_rc_or_nf.push_back(buffer[j]);
+				}
+				i += k;
+			}
+		}
+		input.align();
+
+		if(raw::value)
+		{
+			typedef typename std::aligned_storage<
+				sizeof(Component),
+				alignof(Component)
+			>::type raw_slot;
+
+			std::vector<raw_slot> buffer(std::min(n, chunk));
+			for(std::size_t i=0; i!=n; )
+			{
+				const std::size_t k = std::min(n-i, chunk);
+				input.read_bytes(buffer.data(), k*sizeof(Component));
+				for(std::size_t j=0; j!=k; ++j)
+				{
+					_components.push_back(
+						*reinterpret_cast<const Component*>(
+							&buffer[j]
+						)
+					);
+				}
+				i += k;
+			}
+			input.align();
+		}
+		else
+		{
+			input.begin_values<Component>(live);
+			if(n != 0)
+			{
+				if(_neg_rc_or_nf[n-1] >= 0)
+				{
+					throw std::invalid_argument(
+						"exces::load_snapshot: the last saved "
+						"slot must be live"
+					);
+				}
+				// the free slots are filled with copies
+				// of the first live component
+				std::size_t first = 0;
+				while(_neg_rc_or_nf[first] >= 0) ++first;
+
+				Component value = input.read_value<Component>();
+				for(std::size_t i=0; i!=first; ++i)
+				{
+					_components.push_back(value);
+				}
+				_components.push_back(std::move(value));
+				for(std::size_t i=first+1; i!=n; ++i)
+				{
+					if(_neg_rc_or_nf[i] < 0)
+					{
+						_components.push_back(
+							input.read_value<Component>()
+						);
+					}
+					else _components.push_back(_components[first]);
+				}
+			}
+			input.finish_values();
+		}
+	}
 public:
 	component_entry_vector(void)
-	 : _next_free(-1)
+	 : _next_free(_free_end)
 	 , _vector_refs(0)
 	{ }
 
 	Component& at(component_key key)
 	{
-		return _ents.at(key)._component;
+		return _components.at(key);
 	}
 
 	void reserve(std::size_t size)
 	{
-		_ents.reserve(size);
+		_components.reserve(size);
+		_neg_rc_or_nf.reserve(size);
 	}
 
 	component_key store(Component&& component)
 	{
 		component_key result;
-		if(_next_free >= 0)
+		if(_next_free != _free_end)
 		{
 			result = component_key(_next_free);
-			_ents.at(result)._component = std::move(component);
-			_next_free = _ents.at(result)._neg_rc_or_nf;
-			_ents.at(result)._neg_rc_or_nf = -1;
+			_components.at(result) = std::move(component);
+			_next_free = _neg_rc_or_nf.at(result);
+			_neg_rc_or_nf.at(result) = -1;
 		}
 		else
 		{
-			result = _ents.size();
-			_ents.push_back(std::move(component));
-			_ents.back()._neg_rc_or_nf = -1;
+			result = _components.size();
+			_components.push_back(std::move(component));
+			// both vectors must keep the same size
+			try { _neg_rc_or_nf.push_back(-1); }
+			catch(...)
+			{
+				_components.pop_back();
+				throw;
+			}
 		}
 		return result;
 	}
 
 	component_key replace(component_key key, Component&& component)
 	{
-		_ents.at(key)._component = std::move(component);
+		_components.at(key) = std::move(component);
 		return key;
 	}
 
@@ -94,20 +192,20 @@ public:
 
 	void add_ref(component_key key)
 	{
-		assert(_ents.at(key)._neg_rc_or_nf < 0);
-		--_ents.at(key)._neg_rc_or_nf;
+		assert(_neg_rc_or_nf.at(key) < 0);
+		--_neg_rc_or_nf.at(key);
 	}
 
 	void do_release(component_key key)
 	{
-		_ents.at(key)._neg_rc_or_nf = _next_free;
+		_neg_rc_or_nf.at(key) = _next_free;
 		_next_free = int(key);
 	}
 
 	bool release(component_key key)
 	{
-		assert(_ents.at(key)._neg_rc_or_nf < 0);
-		if(++_ents.at(key)._neg_rc_or_nf == 0)
+		assert(_neg_rc_or_nf.at(key) < 0);
+		if(++_neg_rc_or_nf.at(key) == 0)
 		{
 			if(_vector_refs)
 			{
@@ -121,13 +219,206 @@ public:
 
 	void for_each(const std::function<bool (Component&)>& function)
 	{
-		for(auto& ent : _ents)
+		for(std::size_t i=0, n=_components.size(); i!=n; ++i)
+		{
+			if(_neg_rc_or_nf[i] < 0)
+			{
+				if(!function(_components[i]))
+				{
+					break;
+				}
+			}
+		}
+	}
+
+	component_block<Component> block(void)
+	{
+		component_block<Component> result = {
+			_components.data(),
+			_neg_rc_or_nf.data(),
+			_components.size()
+		};
+		return result;
+	}
+
+	void add_memory_stats(component_memory_stats& stats) const
+	{
+		const std::size_t slot_size = sizeof(Component)+sizeof(int);
+		std::size_t live = 0;
+		for(int nrc : _neg_rc_or_nf)
+		{
+			if(nrc < 0) ++live;
+		}
+		const std::size_t slots = _components.size();
+
+		stats.live_count += live;
+		stats.slot_count += slots;
+		stats.capacity += _components.capacity();
+		stats.free_count += slots-live;
+		stats.bytes_used += live*slot_size;
+		stats.bytes_free += (slots-live)*slot_size;
+		stats.bytes_reserved += _reserved_bytes();
+	}
+
+	// releases the free slots at the end of the vector and the unused
+	// capacity, returns the number of bytes reclaimed
+	std::size_t shrink_to_fit(void)
+	{
+		// the components must not be moved while the vector is locked
+		if(_vector_refs) return 0;
+
+		const std::size_t before = _reserved_bytes();
+
+		std::size_t size = _components.size();
+		while((size != 0) && (_neg_rc_or_nf[size-1] >= 0))
+		{
+			--size;
+		}
+		if(size != _components.size())
+		{
+			_components.erase(_components.begin()+size, _components.end());
+			_neg_rc_or_nf.erase(
+				_neg_rc_or_nf.begin()+size,
+				_neg_rc_or_nf.end()
+			);
+			// rebuild the free list from the remaining holes
+			// so that the lowest free slots are reused first
+			_next_free = _free_end;
+			for(std::size_t i=size; i!=0; --i)
+			{
+				if(_neg_rc_or_nf[i-1] >= 0)
+				{
+					_neg_rc_or_nf[i-1] = _next_free;
+					_next_free = int(i-1);
+				}
+			}
+		}
+		_components.shrink_to_fit();
+		_neg_rc_or_nf.shrink_to_fit();
+		_gc_keys.shrink_to_fit();
+
+		return before-_reserved_bytes();
+	}
+
+	// writes the slots into a snapshot, the components are written
+	// as a block of raw bytes if they are trivially copyable, otherwise
+	// only the live components are written through the serializer
+	void save(detail::snapshot_writer& output) const
+	{
+		typedef detail::snapshot_raw<Component> raw;
+		std::size_t n = _components.size();
+		if(!raw::value)
+		{
+			// the free slots at the end are not saved
+			while((n != 0) && (_neg_rc_or_nf[n-1] >= 0))
+			{
+				--n;
+			}
+		}
+
+		output.write_size(n);
+		output.write(std::uint32_t(raw::value?sizeof(Component):0));
+		output.write(std::uint32_t(0));
+		output.align();
+		output.write_bytes(_neg_rc_or_nf.data(), n*sizeof(int));
+		output.align();
+
+		if(raw::value)
+		{
+			output.write_bytes(_components.data(), n*sizeof(Component));
+			output.align();
+		}
+		else
+		{
+			std::size_t live = 0;
+			for(std::size_t i=0; i!=n; ++i)
+			{
+				if(_neg_rc_or_nf[i] < 0) ++live;
+			}
+			output.begin_values<Component>(live);
+			for(std::size_t i=0; i!=n; ++i)
+			{
+				if(_neg_rc_or_nf[i] < 0)
+				{
+					output.write_value(_components[i]);
+				}
+			}
+			output.finish_values<Component>();
+		}
+	}
+
+	// replaces the slots with the ones read from a snapshot
+	void load(detail::snapshot_reader& input)
+	{
+		typedef detail::snapshot_raw<Component> raw;
+		assert(_vector_refs == 0);
+
+		const std::size_t n = input.read_size();
+		const std::size_t slot_size = input.read<std::uint32_t>();
+		input.read<std::uint32_t>();
+		if(slot_size != (raw::value?sizeof(Component):0))
+		{
+			throw std::invalid_argument(
+				"exces::load_snapshot: the layout of component '"+
+				std::string(component_storage_name<Component>(0))+
+				"' does not match"
+			);
+		}
+
+		// both vectors must keep the same size, if reading
+		// the slots fails they are left empty
+		clear();
+		try { _load_slots(input, n); }
+		catch(...)
+		{
+			clear();
+			throw;
+		}
+
+		// rebuild the free list, this also frees the slots
+		// which were waiting for the garbage collection
+		_next_free = _free_end;
+		for(std::size_t i=n; i!=0; --i)
+		{
+			if(_neg_rc_or_nf[i-1] >= 0)
+			{
+				_neg_rc_or_nf[i-1] = _next_free;
+				_next_free = int(i-1);
+			}
+		}
+	}
+
+	// removes all slots
+	void clear(void)
+	{
+		assert(_vector_refs == 0);
+		_components.clear();
+		_neg_rc_or_nf.clear();
+		_gc_keys.clear();
+		_next_free = _free_end;
+	}
+
+	// checks the keys loaded from a snapshot, returns true if all of them
+	// refer to live slots and none of the slots is referred to by more
+	// keys than its reference count
+	bool check_keys(std::vector<component_key> keys) const
+	{
+		std::sort(keys.begin(), keys.end());
+		for(std::size_t i=0, n=keys.size(); i!=n; )
 		{
-			if(!function(ent._component))
+			const component_key key = keys[i];
+			std::size_t refs = 0;
+			while((i != n) && (keys[i] == key))
 			{
-				break;
+				++refs;
+				++i;
 			}
+			if(key >= _neg_rc_or_nf.size()) return false;
+			const int nrc = _neg_rc_or_nf[key];
+			if(nrc >= 0) return false;
+			if(std::size_t(-std::int64_t(nrc)) < refs) return false;
 		}
+		return true;
 	}
 
 	void gc(void)
@@ -136,6 +427,7 @@ public:
 		{
 			do_release(key);
 		}
+		_gc_keys.clear();
 	}
 
 	void lock(void)
@@ -145,23 +437,45 @@ public:
 
 	void unlock(void)
 	{
-		if(_vector_refs-- == 0)
+		assert(_vector_refs > 0);
+		if(--_vector_refs == 0)
 		{
 			gc();
 		}
 	}
 };
 //------------------------------------------------------------------------------
+// skips the entries of a component unknown to the loading manager
+//------------------------------------------------------------------------------
+inline void skip_component_entries(detail::snapshot_reader& input)
+{
+	const std::size_t n = input.read_size();
+	const std::size_t slot_size = input.read<std::uint32_t>();
+	input.read<std::uint32_t>();
+	input.align();
+	input.skip(n*sizeof(int));
+	input.align();
+	if(slot_size != 0)
+	{
+		input.skip(n*slot_size);
+		input.align();
+	}
+	else input.skip_values();
+}
+//------------------------------------------------------------------------------
 // normal_storage_vector
 //------------------------------------------------------------------------------
-template <typename Group, typename Component>
-class normal_storage_vector
+template <
+	typename Group,
+	typename Component,
+	typename VectorSel = detail::std_vector_sel
+> class normal_storage_vector
  : public component_storage_vector<Group, Component>
 {
 public:
 	typedef std::size_t component_key;
 private:
-	component_entry_vector<Component> _ents;
+	component_entry_vector<Component, VectorSel> _ents;
 
 	typedef component_locking<Group, Component> _locking;
 	typedef typename _locking::shared_lock shared_lock;
@@ -173,6 +487,13 @@ private:
 	_mutex _acc_mutex;
 	_mutex _mod_mutex;
 public:
+	normal_storage_vector(void)
+	{
+		const char* name = component_storage_name<Component>(0);
+		_locking::name_mutex(_acc_mutex, name, "storage_access");
+		_locking::name_mutex(_mod_mutex, name, "storage_modify");
+	}
+
 	shared_lock read_lock(void)
 	{
 		return shared_lock(_acc_mutex, std::defer_lock);
@@ -228,6 +549,49 @@ public:
 		_ents.for_each(function);
 	}
 
+	component_block<Component> block(void)
+	{
+		return _ents.block();
+	}
+
+	component_memory_stats memory_stats(void)
+	{
+		_mutex_guard l(_mod_mutex);
+		component_memory_stats result = component_memory_stats();
+		_ents.add_memory_stats(result);
+		return result;
+	}
+
+	std::size_t shrink_to_fit(void)
+	{
+		_mutex_guard l(_mod_mutex);
+		return _ents.shrink_to_fit();
+	}
+
+	void save(detail::snapshot_writer& output)
+	{
+		_mutex_guard l(_mod_mutex);
+		_ents.save(output);
+	}
+
+	void load(detail::snapshot_reader& input)
+	{
+		_mutex_guard l(_mod_mutex);
+		_ents.load(input);
+	}
+
+	void clear(void)
+	{
+		_mutex_guard l(_mod_mutex);
+		_ents.clear();
+	}
+
+	bool check_keys(const std::vector<component_key>& keys)
+	{
+		_mutex_guard l(_mod_mutex);
+		return _ents.check_keys(keys);
+	}
+
 	void lock(void)
 	{
 		_mutex_guard l(_mod_mutex);
@@ -407,6 +771,9 @@ public:
 	backbuf_storage_vector(void)
 	 : _current(0)
 	{
+		const char* name = component_storage_name<Component>(0);
+		_locking::name_mutex(_rd_mutex, name, "backbuf_read");
+		_locking::name_mutex(_wr_mutex, name, "backbuf_write");
 		_rd_lock._parent = this;
 		_wr_lock._parent = this;
 	}
@@ -461,6 +828,69 @@ public:
 		_curr_ents().for_each(function);
 	}
 
+	component_block<Component> block(void)
+	{
+		return _curr_ents().block();
+	}
+
+	component_memory_stats memory_stats(void)
+	{
+		_mutex_guard l(_rd_mutex);
+		component_memory_stats result = component_memory_stats();
+		_ents[_current].add_memory_stats(result);
+		// the back buffers add only to the reserved memory
+		for(std::size_t b=0; b!=N; ++b)
+		{
+			if(b == _current) continue;
+			component_memory_stats back = component_memory_stats();
+			_ents[b].add_memory_stats(back);
+			result.bytes_reserved += back.bytes_reserved;
+		}
+		return result;
+	}
+
+	std::size_t shrink_to_fit(void)
+	{
+		_mutex_guard l(_rd_mutex);
+		// the buffers cannot be shrunk while some thread uses them
+		if(!_thread_buffs.empty()) return 0;
+
+		std::size_t result = 0;
+		for(component_entry_vector<Component>& ents : _ents)
+		{
+			result += ents.shrink_to_fit();
+		}
+		return result;
+	}
+
+	void save(detail::snapshot_writer& output)
+	{
+		_mutex_guard l(_rd_mutex);
+		_ents[_current].save(output);
+	}
+
+	void load(detail::snapshot_reader& input)
+	{
+		_mutex_guard l(_rd_mutex);
+		assert(_thread_buffs.empty());
+		// the back buffers are copied from the current one
+		// at the beginning of the next write
+		_ents[_current].load(input);
+	}
+
+	void clear(void)
+	{
+		_mutex_guard l(_rd_mutex);
+		assert(_thread_buffs.empty());
+		_ents[_current].clear();
+	}
+
+	bool check_keys(const std::vector<component_key>& keys)
+	{
+		_mutex_guard l(_rd_mutex);
+		return _ents[_current].check_keys(keys);
+	}
+
 	void lock(void)
 	{
 		_curr_ents().lock();
@@ -499,6 +929,15 @@ private:
 
 	_mutex _mod_mutex;
 public:
+	flyweight_storage_vector(void)
+	{
+		_locking::name_mutex(
+			_mod_mutex,
+			component_storage_name<Component>(0),
+			"flyweight_modify"
+		);
+	}
+
 	shared_lock read_lock(void)
 	{
 		return _ents.read_lock();
@@ -572,6 +1011,63 @@ public:
 		_ents.for_each(function);
 	}
 
+	component_block<Component> block(void)
+	{
+		return _ents.block();
+	}
+
+	component_memory_stats memory_stats(void)
+	{
+		component_memory_stats result = _ents.memory_stats();
+		_mutex_guard l(_mod_mutex);
+		result.bytes_reserved +=
+			_index.size()*detail::map_node_bytes<
+				std::map<Component, component_key>
+			>();
+		return result;
+	}
+
+	std::size_t shrink_to_fit(void)
+	{
+		_mutex_guard l(_mod_mutex);
+		return _ents.shrink_to_fit();
+	}
+
+	void save(detail::snapshot_writer& output)
+	{
+		_mutex_guard l(_mod_mutex);
+		_ents.save(output);
+	}
+
+	void load(detail::snapshot_reader& input)
+	{
+		_mutex_guard l(_mod_mutex);
+		_ents.load(input);
+
+		// rebuild the index of the unique values
+		_index.clear();
+		component_block<Component> blk = _ents.block();
+		for(std::size_t k=0; k!=blk.size; ++k)
+		{
+			if(blk.is_live(k))
+			{
+				_index[blk.components[k]] = k;
+			}
+		}
+	}
+
+	void clear(void)
+	{
+		_mutex_guard l(_mod_mutex);
+		_ents.clear();
+		_index.clear();
+	}
+
+	bool check_keys(const std::vector<component_key>& keys)
+	{
+		return _ents.check_keys(keys);
+	}
+
 	void lock(void)
 	{
 		_ents.lock();
@@ -602,6 +1098,13 @@ template <typename Component, typename Group>
 normal_storage_vector<Group, Component>
 storage_vector_type(component_kind_normal);
 //------------------------------------------------------------------------------
+template <typename Component, typename Group>
+normal_storage_vector<
+	Group,
+	Component,
+	detail::mapped_vector_sel<component_mapping<Component, Group>>
+> storage_vector_type(component_kind_mapped);
+//------------------------------------------------------------------------------
 template <typename Group>
 struct component_storage_init
 {
@@ -0,0 +1,138 @@
+/**
+ *  @file exces/any/column.hpp
+ *  @brief Type erased column of the instances of a component
+ *
+ *  Copyright 2012-2014 Matus Chochlik. Distributed under the Boost
+ *  Software License, Version 1.0. (See accompanying file
+ *  LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef EXCES_ANY_COLUMN_1405251310_HPP
+#define EXCES_ANY_COLUMN_1405251310_HPP
+
+#include <exces/any/entity_key.hpp>
+
+#include <vector>
+#include <cstddef>
+
+namespace exces {
+
+/// Contiguous chunk of instances of a component in an any_component_column
+/**
+ *  @see any_component_column
+ */
+struct any_component_chunk
+{
+	/// Pointer to the first instance of the component in the chunk
+	void* base;
+
+	/// The distance between two consecutive instances in bytes
+	std::size_t stride;
+
+	/// The number of instances in the chunk
+	std::size_t count;
+
+	/// The keys of the entities owning the instances (count elements)
+	const any_entity_key* keys;
+
+	/// Returns a pointer to the i-th instance in the chunk
+	void* at(std::size_t i) const
+	{
+		return static_cast<char*>(base)+i*stride;
+	}
+};
+
+/// Zero-copy view of all instances of a component in an any_manager
+/** The column consists of chunks of instances stored contiguously in the
+ *  component storage, together with the keys of the entities owning them.
+ *  The chunks point directly into the storage, so they are valid only
+ *  until the next modification of the component's storage and they should
+ *  be used while holding the raw_access_lock of the component.
+ *
+ *  @see any_manager::column
+ */
+class any_component_column
+{
+private:
+	std::vector<any_component_chunk> _chunks;
+	std::vector<any_entity_key> _keys;
+	std::vector<std::size_t> _firsts;
+public:
+	any_component_column(void) = default;
+
+	// the chunks point into the vector of keys, so that the
+	// column is not copyable, but it is movable
+	any_component_column(const any_component_column&) = delete;
+	any_component_column(any_component_column&&) = default;
+	any_component_column& operator = (any_component_column&&) = default;
+
+	// implementation detail, appends the instance owned by the specified
+	// entity, extending the last chunk if the instance follows it
+	void _append(const any_entity_key& key, void* ptr, std::size_t stride)
+	{
+		if(!_chunks.empty())
+		{
+			any_component_chunk& last = _chunks.back();
+			if(	(last.stride == stride) &&
+				(last.at(last.count) == ptr)
+			)
+			{
+				++last.count;
+				_keys.push_back(key);
+				return;
+			}
+		}
+		any_component_chunk chunk = { ptr, stride, 1, nullptr };
+		_chunks.push_back(chunk);
+		_firsts.push_back(_keys.size());
+		_keys.push_back(key);
+	}
+
+	// implementation detail, finishes the column after the last _append
+	void _finish(void)
+	{
+		for(std::size_t c=0; c!=_chunks.size(); ++c)
+		{
+			_chunks[c].keys = _keys.data()+_firsts[c];
+		}
+	}
+
+	typedef std::vector<any_component_chunk>::const_iterator iterator;
+
+	/// Returns the number of chunks in the column
+	std::size_t size(void) const
+	{
+		return _chunks.size();
+	}
+
+	/// Returns true if the column has no chunks
+	bool empty(void) const
+	{
+		return _chunks.empty();
+	}
+
+	/// Returns the number of instances in all chunks
+	std::size_t count(void) const
+	{
+		return _keys.size();
+	}
+
+	const any_component_chunk& operator [](std::size_t c) const
+	{
+		return _chunks[c];
+	}
+
+	iterator begin(void) const
+	{
+		return _chunks.begin();
+	}
+
+	iterator end(void) const
+	{
+		return _chunks.end();
+	}
+};
+
+} // namespace exces
+
+#endif //include guard
@@ -0,0 +1,65 @@
+/**
+ *  @file exces/any/component_id.hpp
+ *  @brief Type erased handle of a component resolved from its name
+ *
+ *  Copyright 2012-2014 Matus Chochlik. Distributed under the Boost
+ *  Software License, Version 1.0. (See accompanying file
+ *  LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef EXCES_ANY_COMPONENT_ID_1405241120_HPP
+#define EXCES_ANY_COMPONENT_ID_1405241120_HPP
+
+#include <cstddef>
+
+namespace exces {
+
+/// Handle of a component in the group of an any_manager
+/** The handle is resolved once from the name of the component by
+ *  any_manager::component_id and it can then be passed to the operations
+ *  of that any_manager (or other any_managers with the same group) instead
+ *  of the name, avoiding the lookup of the name on every call.
+ *
+ *  @see any_manager
+ */
+class any_component_id
+{
+private:
+	std::size_t _id;
+public:
+	/// Constructs an invalid handle
+	any_component_id(void)
+	 : _id(~std::size_t(0))
+	{ }
+
+	// implementation detail, do not use directly
+	explicit any_component_id(std::size_t id)
+	 : _id(id)
+	{ }
+
+	/// Returns true if the handle refers to a component
+	bool is_valid(void) const
+	{
+		return _id != ~std::size_t(0);
+	}
+
+	/// Returns the id of the component in its group
+	std::size_t value(void) const
+	{
+		return _id;
+	}
+
+	friend bool operator == (any_component_id a, any_component_id b)
+	{
+		return a._id == b._id;
+	}
+
+	friend bool operator != (any_component_id a, any_component_id b)
+	{
+		return a._id != b._id;
+	}
+};
+
+} // namespace exces
+
+#endif //include guard
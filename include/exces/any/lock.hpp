@@ -12,15 +12,32 @@
 
 #include <exces/threads.hpp>
 
+#include <type_traits>
+#include <new>
+
 namespace exces {
 
 /// Type erasure for lockable types
+/** Lockables small enough to fit into the internal buffer of the any_lock
+ *  (for example the locks returned by the lifetime_lock and raw_access_lock
+ *  functions of the manager) are stored in-place without allocating memory
+ *  on the heap. Larger lockables are allocated on the heap.
+ *
+ *  Multiple statically known lockables can be composed into a single
+ *  any_lock, which locks them together with a single virtual call.
+ */
 class any_lock
  : public poly_lock
 {
 private:
+	struct _intf : lock_intf
+	{
+		// move-constructs a copy of this in the specified buffer
+		virtual _intf* _move_to(void* buf) = 0;
+	};
+
 	template <typename Lockable>
-	struct _impl : lock_intf
+	struct _impl : _intf
 	{
 		Lockable _lockable;
 
@@ -31,35 +48,138 @@ private:
 		void lock(void){ _lockable.lock(); }
 		bool try_lock(void){ return _lockable.try_lock(); }
 		void unlock(void){ _lockable.unlock(); }
+
+		_intf* _move_to(void* buf)
+		{
+			return new(buf) _impl(std::move(_lockable));
+		}
 	};
-public:
-	any_lock(void) = default;
+
+	static const std::size_t _buf_size = 8*sizeof(void*);
+	typedef typename std::aligned_storage<_buf_size>::type _buf_t;
+
+	_buf_t _buf;
+	bool _in_buf;
+
+	template <typename Lockable>
+	struct _fits
+	 : std::integral_constant<
+		bool,
+		(sizeof(_impl<Lockable>) <= sizeof(_buf_t)) &&
+		(alignof(_impl<Lockable>) <= alignof(_buf_t)) &&
+		std::is_nothrow_move_constructible<Lockable>::value
+	>
+	{ };
+
+	template <typename Lockable>
+	void _init(Lockable&& lockable, std::true_type)
+	{
+		_pimpl = new(&_buf) _impl<Lockable>(std::move(lockable));
+		_in_buf = true;
+	}
+
+	template <typename Lockable>
+	void _init(Lockable&& lockable, std::false_type)
+	{
+		_pimpl = new _impl<Lockable>(std::move(lockable));
+	}
+
+	void _take(any_lock& tmp)
+	{
+		if(tmp._in_buf)
+		{
+			_intf* that = static_cast<_intf*>(tmp._pimpl);
+			_pimpl = that->_move_to(&_buf);
+			_in_buf = true;
+			that->~_intf();
+			tmp._in_buf = false;
+		}
+		else _pimpl = tmp._pimpl;
+		tmp._pimpl = nullptr;
+	}
+
+	void _reset(void)
+	{
+		if(_in_buf) static_cast<_intf*>(_pimpl)->~_intf();
+		else if(_pimpl) delete _pimpl;
+		_pimpl = nullptr;
+		_in_buf = false;
+	}
 
 	template <typename Lockable>
+	struct _not_any_lock
+	 : std::enable_if<
+		!std::is_same<
+			typename std::decay<Lockable>::type,
+			any_lock
+		>::value
+	>
+	{ };
+public:
+	any_lock(void)
+	 : _in_buf(false)
+	{ }
+
+	template <
+		typename Lockable,
+		typename = typename _not_any_lock<Lockable>::type
+	>
 	any_lock(Lockable&& lockable)
-	 : poly_lock(new _impl<Lockable>(std::move(lockable)))
+	 : _in_buf(false)
 	{
+		typedef typename std::decay<Lockable>::type _lockable_t;
+		_init(_lockable_t(std::move(lockable)), _fits<_lockable_t>());
 		assert(_pimpl);
 	}
 
+	/// Composes multiple lockables into a single any_lock
+	/** The lockables are locked together by a tuple_lock.
+	 */
+	template <typename L1, typename L2, typename ... L>
+	any_lock(L1&& l1, L2&& l2, L&& ... l)
+	 : any_lock(make_tuple_lock(
+		typename std::decay<L1>::type(std::move(l1)),
+		typename std::decay<L2>::type(std::move(l2)),
+		typename std::decay<L>::type(std::move(l))...
+	))
+	{ }
+
 	any_lock(const any_lock&) = delete;
 
 	any_lock(any_lock&& tmp)
-	 : poly_lock(tmp._pimpl)
+	 : _in_buf(false)
 	{
-		tmp._pimpl = nullptr;
+		_take(tmp);
 	}
 
 	~any_lock(void)
 	{
-		if(_pimpl) delete _pimpl;
+		_reset();
 	}
 
 	any_lock& operator = (any_lock&& tmp)
 	{
-		swap(tmp);
+		if(this != &tmp)
+		{
+			_reset();
+			_take(tmp);
+		}
 		return *this;
 	}
+
+	void swap(any_lock& that)
+	{
+		any_lock tmp(std::move(that));
+		that = std::move(*this);
+		*this = std::move(tmp);
+	}
+
+	/// Returns true if the Lockable is stored without heap allocation
+	template <typename Lockable>
+	static constexpr bool is_stored_in_place(void)
+	{
+		return _fits<Lockable>::value;
+	}
 };
 
 } // namespace exces
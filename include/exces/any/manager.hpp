@@ -12,6 +12,7 @@
 
 #include <exces/any/manager_intf.hpp>
 #include <array>
+#include <vector>
 
 namespace exces {
 
@@ -52,6 +53,25 @@ public:
 
 	typedef any_entity_key entity_key;
 
+	/// Returns the handle of the component with the specified name
+	/** The returned handle is invalid if the group of the manager does
+	 *  not contain the component. The handle can be passed to the other
+	 *  member functions instead of the name and to other any_managers
+	 *  wrapping managers with the same group.
+	 */
+	any_component_id component_id(const char* name)
+	{
+		assert(_pimpl);
+		return _pimpl->component_id(name);
+	}
+
+	/// Returns the handle of the specified Component
+	template <typename Component>
+	any_component_id component_id(void)
+	{
+		return component_id(component_name<Component>::c_str());
+	}
+
 	bool has_key(Entity e)
 	{
 		assert(_pimpl);
@@ -84,6 +104,18 @@ public:
 		return _pimpl->has(e, component_name<Component>::c_str());
 	}
 
+	bool has(any_entity_key_param aek, any_component_id cid)
+	{
+		assert(_pimpl);
+		return _pimpl->has(aek, cid);
+	}
+
+	bool has(Entity e, any_component_id cid)
+	{
+		assert(_pimpl);
+		return _pimpl->has(e, cid);
+	}
+
 	template <typename ... Components>
 	bool has_all(any_entity_key_param aek)
 	{
@@ -124,6 +156,25 @@ public:
 		return add(get_key(e), std::move(comp)...);
 	}
 
+	/// Adds the component with the specified handle, moving from *pcomp
+	any_manager& add_raw(
+		any_entity_key_param aek,
+		any_component_id cid,
+		void* pcomp
+	)
+	{
+		assert(_pimpl);
+		_pimpl->add(aek, cid, pcomp);
+		return *this;
+	}
+
+	any_manager& remove(any_entity_key_param aek, any_component_id cid)
+	{
+		assert(_pimpl);
+		_pimpl->remove(aek, cid);
+		return *this;
+	}
+
 	template <typename ... Components>
 	any_manager& remove(any_entity_key_param aek)
 	{
@@ -142,7 +193,7 @@ public:
 	any_manager& copy(any_entity_key_param aekf, any_entity_key_param aekt)
 	{
 		assert(_pimpl);
-		_pimpl->add(aekf, aekt, cnames<Components...>().data());
+		_pimpl->copy(aekf, aekt, cnames<Components...>().data());
 		return *this;
 	}
 
@@ -170,6 +221,18 @@ public:
 		);
 	}
 
+	any_lock lifetime_lock(any_component_id cid)
+	{
+		assert(_pimpl);
+		return _pimpl->lifetime_lock(cid);
+	}
+
+	any_lock raw_access_lock(any_component_id cid)
+	{
+		assert(_pimpl);
+		return _pimpl->raw_access_lock(cid);
+	}
+
 	typedef std::vector<std::size_t> entity_update_op;
 
 	entity_update_op begin_update(any_entity_key_param aek)
@@ -206,6 +269,164 @@ public:
 		return *((Component*)pcomponent);
 	}
 
+	/// Returns a pointer to the component with the specified handle
+	void* raw_access(any_entity_key_param aek, any_component_id cid)
+	{
+		assert(_pimpl);
+		return _pimpl->raw_access(aek, cid);
+	}
+
+	template <typename Component>
+	Component& raw_access(any_entity_key_param aek, any_component_id cid)
+	{
+		void* pcomponent = raw_access(aek, cid);
+		assert(pcomponent);
+		return *((Component*)pcomponent);
+	}
+
+	/// Checks which of the n entities have all the specified components
+	/** Stores true into out[i] if the entity with keys[i] has all
+	 *  the count components with the specified handles. The entity
+	 *  information is locked only once for the whole batch.
+	 */
+	void has_all_n(
+		const entity_key* keys,
+		std::size_t n,
+		const any_component_id* cids,
+		std::size_t count,
+		bool* out
+	)
+	{
+		assert(_pimpl);
+		_pimpl->has_all_n(keys, n, cids, count, out);
+	}
+
+	/// Checks which of the n entities have all the specified Components
+	template <typename ... Components>
+	void has_all_n(const entity_key* keys, std::size_t n, bool* out)
+	{
+		const any_component_id cids[] = {
+			component_id<Components>()...
+		};
+		has_all_n(keys, n, cids, sizeof ... (Components), out);
+	}
+
+	/// Adds count components to each of the n entities
+	/** The arrays[c] points to an array of n instances of the component
+	 *  with the handle cids[c], the i-th instance is moved into the entity
+	 *  with keys[i]. All components are added to an entity in a single
+	 *  operation.
+	 */
+	any_manager& add_n(
+		const entity_key* keys,
+		std::size_t n,
+		const any_component_id* cids,
+		std::size_t count,
+		void* const* arrays
+	)
+	{
+		assert(_pimpl);
+		_pimpl->add_n(keys, n, cids, count, arrays);
+		return *this;
+	}
+
+	/// Adds the Components from the arrays to each of the n entities
+	template <typename ... Components>
+	any_manager& add_n(
+		const entity_key* keys,
+		std::size_t n,
+		Components* ... arrays
+	)
+	{
+		const any_component_id cids[] = {
+			component_id<Components>()...
+		};
+		void* const ptrs[] = { static_cast<void*>(arrays)... };
+		return add_n(keys, n, cids, sizeof ... (Components), ptrs);
+	}
+
+	/// Removes count components from each of the n entities
+	any_manager& remove_n(
+		const entity_key* keys,
+		std::size_t n,
+		const any_component_id* cids,
+		std::size_t count
+	)
+	{
+		assert(_pimpl);
+		_pimpl->remove_n(keys, n, cids, count);
+		return *this;
+	}
+
+	/// Removes the Components from each of the n entities
+	template <typename ... Components>
+	any_manager& remove_n(const entity_key* keys, std::size_t n)
+	{
+		const any_component_id cids[] = {
+			component_id<Components>()...
+		};
+		return remove_n(keys, n, cids, sizeof ... (Components));
+	}
+
+	/// Stores pointers to the component of n entities into out
+	/** The locks are acquired only once for the whole batch.
+	 *  @warning Read the documentation for manager::raw_access before
+	 *  using this function.
+	 */
+	void raw_access_n(
+		const entity_key* keys,
+		std::size_t n,
+		any_component_id cid,
+		void** out
+	)
+	{
+		assert(_pimpl);
+		_pimpl->raw_access_n(keys, n, cid, out);
+	}
+
+	/// Stores pointers to the Component of n entities into out
+	template <typename Component>
+	void raw_access_n(
+		const entity_key* keys,
+		std::size_t n,
+		Component** out
+	)
+	{
+		std::vector<void*> ptrs(n);
+		raw_access_n(keys, n, component_id<Component>(), ptrs.data());
+		for(std::size_t i=0; i!=n; ++i)
+		{
+			out[i] = static_cast<Component*>(ptrs[i]);
+		}
+	}
+
+	/// Returns a zero-copy column of all instances of a component
+	/** The column consists of chunks of instances stored contiguously
+	 *  in the component storage together with the keys of the entities
+	 *  owning them, so that type erased consumers can process them
+	 *  without calling a function per component. The column is empty
+	 *  if the handle is not valid.
+	 *  @warning The chunks point directly into the storage and are valid
+	 *  only until the next change of the component's storage. Read the
+	 *  documentation for manager::raw_access before using this function.
+	 *
+	 *  @see raw_access_lock
+	 */
+	any_component_column column(any_component_id cid)
+	{
+		assert(_pimpl);
+		any_component_column result;
+		_pimpl->column(cid, result);
+		return result;
+	}
+
+	/// Returns a zero-copy column of all instances of the Component
+	template <typename Component>
+	any_component_column column(void)
+	{
+		return column(component_id<Component>());
+	}
+
 	template <typename Component>
 	Component& rw(any_entity_key_param aek)
 	{
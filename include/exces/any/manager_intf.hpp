@@ -12,6 +12,8 @@
 
 #include <exces/any/entity_key.hpp>
 #include <exces/any/lock.hpp>
+#include <exces/any/component_id.hpp>
+#include <exces/any/column.hpp>
 #include <functional>
 #include <memory>
 
@@ -67,6 +69,41 @@ struct any_manager_intf
 		)>&
 	) = 0;
 	virtual void for_each_c(const void*, const char*) = 0;
+
+	virtual any_component_id component_id(const char*) = 0;
+
+	virtual bool has(aekp, any_component_id) = 0;
+	virtual bool has(Entity, any_component_id) = 0;
+
+	virtual void add(aekp, any_component_id, void*) = 0;
+	virtual void remove(aekp, any_component_id) = 0;
+
+	virtual any_lock lifetime_lock(any_component_id) = 0;
+	virtual any_lock raw_access_lock(any_component_id) = 0;
+
+	virtual void* raw_access(aekp, any_component_id) = 0;
+
+	virtual void has_all_n(
+		const any_entity_key*, std::size_t,
+		const any_component_id*, std::size_t,
+		bool*
+	) = 0;
+	virtual void add_n(
+		const any_entity_key*, std::size_t,
+		const any_component_id*, std::size_t,
+		void* const*
+	) = 0;
+	virtual void remove_n(
+		const any_entity_key*, std::size_t,
+		const any_component_id*, std::size_t
+	) = 0;
+	virtual void raw_access_n(
+		const any_entity_key*, std::size_t,
+		any_component_id,
+		void**
+	) = 0;
+
+	virtual void column(any_component_id, any_component_column&) = 0;
 };
 
 template <typename Group>
@@ -0,0 +1,401 @@
+/**
+ *  @file exces/change_log.hpp
+ *  @brief Log of the changes of the components of a manager
+ *
+ *  Copyright 2012-2014 Matus Chochlik. Distributed under the Boost
+ *  Software License, Version 1.0. (See accompanying file
+ *  LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef EXCES_CHANGE_LOG_1405221015_HPP
+#define EXCES_CHANGE_LOG_1405221015_HPP
+
+#include <exces/fwd.hpp>
+#include <exces/group.hpp>
+#include <exces/entity.hpp>
+#include <exces/metaprog.hpp>
+#include <exces/snapshot.hpp>
+#include <exces/detail/byte_ring.hpp>
+
+#include <type_traits>
+#include <atomic>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cassert>
+#include <cstdint>
+#include <cstddef>
+
+namespace exces {
+
+/// The kinds of changes recorded by the change_log
+enum class change_op : std::uint8_t
+{
+	/// A component was added to an entity
+	add = 1,
+	/// A component was removed from an entity
+	remove = 2,
+	/// The value of a component of an entity was replaced
+	replace = 3,
+	/// A component was copied to an entity from another entity
+	copy = 4
+};
+
+/// A change of a component of an entity decoded from the change_log
+/**
+ *  @see change_log
+ */
+template <typename Group = default_group>
+struct change_record
+{
+	/// The kind of the change
+	change_op op;
+
+	/// The id of the changed component in Group
+	std::size_t component_id;
+
+	/// The changed entity
+	typename entity<Group>::type entity;
+
+	/// The serialized new value of the component or nullptr
+	/** The value is not logged for removals, if the logging of values
+	 *  is disabled or if the component cannot be serialized.
+	 *  The value points into the buffer the record was decoded from.
+	 *
+	 *  @see snapshot_serializer
+	 */
+	const char* value;
+
+	/// The size of the serialized value
+	std::size_t value_size;
+};
+
+/// Log of the changes of components, for the replication of a manager
+/** A change log attached to a manager with manager::set_change_log
+ *  records every addition, removal, replacement and copy of a component
+ *  as a compact binary record in a lock-free ring buffer. The manager
+ *  appends the records while it holds its component index lock, so the
+ *  records are appended by one thread at a time and a single consumer
+ *  thread may concurrently pop them, for example to stream them to
+ *  another process with drain. The records can be decoded with decode
+ *  or read_record and applied to a replica manager with apply_change.
+ *
+ *  The entities and the values of the components are written by their
+ *  snapshot_serializer, the values are logged only if the log was created
+ *  with log_values set and only for components that can be serialized.
+ *  If the ring buffer is full, the record is dropped and counted, since
+ *  the manager cannot wait for the consumer. A consumer seeing a growing
+ *  dropped count must resynchronize its replica, e.g. from a snapshot.
+ *
+ *  Each record is prefixed by its 32-bit size and consists of the op,
+ *  the flags, the 16-bit component id, the size-prefixed entity and the
+ *  size-prefixed value if it is logged.
+ *
+ *  @see change_record
+ *  @see apply_change
+ */
+template <typename Group = default_group>
+class change_log
+{
+public:
+	/// The entity type of the logged manager
+	typedef typename entity<Group>::type entity_type;
+private:
+	detail::byte_ring _ring;
+	const bool _log_values;
+	std::atomic<std::size_t> _dropped;
+
+	// the record being written (used only by the producer)
+	std::string _record;
+	std::ostringstream _values;
+
+	static constexpr std::uint8_t _has_value = 0x01;
+
+	void _append_u32(std::uint32_t value)
+	{
+		_record.append(reinterpret_cast<const char*>(&value), 4);
+	}
+
+	template <typename T>
+	void _append_value(const T& value)
+	{
+		if(detail::snapshot_raw<T>::value)
+		{
+			_append_u32(std::uint32_t(sizeof(T)));
+			_record.append(
+				reinterpret_cast<const char*>(&value),
+				sizeof(T)
+			);
+		}
+		else
+		{
+			_values.str(std::string());
+			snapshot_serializer<T>::write(_values, value);
+			const std::string bytes = _values.str();
+			_append_u32(std::uint32_t(bytes.size()));
+			_record.append(bytes);
+		}
+	}
+
+	static std::uint32_t _read_u32(const char*& data, const char* end)
+	{
+		std::uint32_t result;
+		if(std::size_t(end-data) < 4) _malformed();
+		std::memcpy(&result, data, 4);
+		data += 4;
+		return result;
+	}
+
+	static void _malformed(void)
+	{
+		throw std::invalid_argument(
+			"exces::change_log: malformed change record"
+		);
+	}
+public:
+	/// Creates a change log with the specified capacity in bytes
+	change_log(std::size_t capacity, bool log_values = true)
+	 : _ring(capacity)
+	 , _log_values(log_values)
+	 , _dropped(0)
+	{ }
+
+	change_log(const change_log&) = delete;
+
+	/// Returns the capacity of the ring buffer in bytes
+	std::size_t capacity(void) const
+	{
+		return _ring.capacity();
+	}
+
+	/// Returns the number of records dropped because the log was full
+	std::size_t dropped(void) const
+	{
+		return _dropped.load();
+	}
+
+	/// Appends a record of a change of Component (called by the manager)
+	/**
+	 *  @return true if the record was appended, false if it was dropped.
+	 */
+	template <typename Component>
+	bool record(change_op op, const entity_type& e, const Component* value)
+	{
+		typedef typename std::remove_cv<Component>::type C;
+		const bool with_value =
+			_log_values && (value != nullptr) &&
+			detail::snapshot_serializable<C>::value;
+
+		_record.clear();
+		// the size is filled in when the record is complete
+		_append_u32(0);
+		_record.push_back(char(op));
+		_record.push_back(char(with_value?_has_value:0));
+		const std::uint16_t cid = component_id<C, Group>::value;
+		_record.append(reinterpret_cast<const char*>(&cid), 2);
+		_append_value(e);
+		if(with_value) _append_value<C>(*value);
+
+		const std::uint32_t size = std::uint32_t(_record.size()-4);
+		std::memcpy(&_record[0], &size, 4);
+
+		if(!_ring.push(_record.data(), _record.size()))
+		{
+			++_dropped;
+			return false;
+		}
+		return true;
+	}
+
+	/// Pops the next record into the buffer, returns false if there is none
+	/** The buffer can be decoded with decode. This function may be called
+	 *  by a single consumer thread concurrently with the manager.
+	 */
+	bool pop(std::vector<char>& buffer)
+	{
+		if(_ring.size() < 4) return false;
+		std::uint32_t size;
+		_ring.peek(0, reinterpret_cast<char*>(&size), 4);
+		// the records are appended at once, so the whole record
+		// is available if its size is
+		assert(_ring.size() >= 4+std::size_t(size));
+		buffer.resize(size);
+		_ring.peek(4, buffer.data(), size);
+		_ring.pop(4+size);
+		return true;
+	}
+
+	/// Writes all available records into output and removes them
+	/** The records are written with their size prefix and can be read
+	 *  back with read_record.
+	 *
+	 *  @return the number of written records.
+	 */
+	std::size_t drain(std::ostream& output)
+	{
+		std::size_t result = 0;
+		std::vector<char> buffer;
+		while(pop(buffer))
+		{
+			const std::uint32_t size = std::uint32_t(buffer.size());
+			output.write(reinterpret_cast<const char*>(&size), 4);
+			output.write(buffer.data(), std::streamsize(size));
+			++result;
+		}
+		return result;
+	}
+
+	/// Reads a single record written by drain from input
+	/**
+	 *  @return false at the end of input.
+	 */
+	static bool read_record(std::istream& input, std::vector<char>& buffer)
+	{
+		std::uint32_t size;
+		if(!input.read(reinterpret_cast<char*>(&size), 4))
+		{
+			return false;
+		}
+		buffer.resize(size);
+		if(!input.read(buffer.data(), std::streamsize(size)))
+		{
+			_malformed();
+		}
+		return true;
+	}
+
+	/// Decodes a record popped from the log or read by read_record
+	static change_record<Group> decode(const std::vector<char>& buffer)
+	{
+		const char* data = buffer.data();
+		const char* end = data+buffer.size();
+
+		if(buffer.size() < 4) _malformed();
+		const change_op op = change_op(std::uint8_t(data[0]));
+		const std::uint8_t flags = std::uint8_t(data[1]);
+		std::uint16_t cid;
+		std::memcpy(&cid, data+2, 2);
+		data += 4;
+
+		if(	(op < change_op::add) ||
+			(op > change_op::copy) ||
+			(cid >= mp::size<components<Group>>::value)
+		) _malformed();
+
+		const std::size_t entity_size = _read_u32(data, end);
+		if(std::size_t(end-data) < entity_size) _malformed();
+		std::istringstream entity_input(std::string(data, entity_size));
+		data += entity_size;
+
+		const char* value = nullptr;
+		std::size_t value_size = 0;
+		if(flags & _has_value)
+		{
+			value_size = _read_u32(data, end);
+			if(std::size_t(end-data) < value_size) _malformed();
+			value = data;
+		}
+
+		change_record<Group> result = {
+			op,
+			cid,
+			snapshot_serializer<entity_type>::read(entity_input),
+			value,
+			value_size
+		};
+		if(entity_input.fail()) _malformed();
+		return result;
+	}
+};
+
+namespace detail {
+
+// applies a change_record to the component with the matching id
+template <typename Group>
+struct change_applier
+{
+	manager<Group>& target;
+	const change_record<Group>& change;
+
+	template <typename Component>
+	static Component _value(const change_record<Group>& change)
+	{
+		if(change.value == nullptr)
+		{
+			throw std::invalid_argument(
+				"exces::apply_change: "
+				"the value of the component is not logged"
+			);
+		}
+		std::istringstream input(
+			std::string(change.value, change.value_size)
+		);
+		Component result = snapshot_serializer<Component>::read(input);
+		if(input.fail())
+		{
+			throw std::invalid_argument(
+				"exces::apply_change: malformed value"
+			);
+		}
+		return result;
+	}
+
+	template <typename Component>
+	void operator()(mp::identity<Component>) const
+	{
+		if(component_id<Component, Group>::value != change.component_id)
+		{
+			return;
+		}
+		switch(change.op)
+		{
+			case change_op::add:
+				target.add(change.entity, _value<Component>(change));
+				break;
+			case change_op::remove:
+				target.template remove<Component>(change.entity);
+				break;
+			case change_op::replace:
+			case change_op::copy:
+				if(target.template has<Component>(change.entity))
+				{
+					target.replace(
+						change.entity,
+						_value<Component>(change)
+					);
+				}
+				else
+				{
+					target.add(
+						change.entity,
+						_value<Component>(change)
+					);
+				}
+				break;
+		}
+	}
+};
+
+} // namespace detail
+
+/// Applies a change decoded from a change_log to a replica manager
+/**
+ *  @throws std::invalid_argument if the change requires the value of
+ *  the component and the value is not logged.
+ *
+ *  @see change_log
+ */
+template <typename Group>
+inline void apply_change(manager<Group>& replica, const change_record<Group>& change)
+{
+	detail::change_applier<Group> applier = { replica, change };
+	mp::for_each<typename components<Group>::type>(applier);
+}
+
+} // namespace exces
+
+#endif //include guard
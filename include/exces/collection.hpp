@@ -15,8 +15,11 @@
 #include <exces/entity_key_set.hpp>
 #include <exces/entity_filters.hpp>
 #include <exces/iter_info.hpp>
+#include <exces/cursor.hpp>
+#include <exces/manager_stats.hpp>
 
 #include <map>
+#include <string>
 #include <functional>
 
 namespace exces {
@@ -74,11 +77,31 @@ private:
 	typedef typename manager<Group>::entity_key entity_key;
 	typedef std::size_t update_key;
 	update_key _cur_uk;
+
+	std::string _name;
+#if EXCES_MANAGER_STATS
+	std::size_t _stats_ids[3];
+
+	void _update_stats_ids(void)
+	{
+		_stats_ids[0] = manager_stats::_id(_name+"::begin_update");
+		_stats_ids[1] = manager_stats::_id(_name+"::finish_update");
+		_stats_ids[2] = manager_stats::_id(_name+"::for_each");
+	}
+#else
+	void _update_stats_ids(void) { }
+#endif
 	
 	virtual void insert(entity_key key) = 0;
 	virtual void remove(entity_key key) = 0;
 	virtual update_key begin_update(entity_key key) = 0;
 	virtual void finish_update(entity_key ekey, update_key) = 0;
+public:
+	/// Returns the memory statistics of this collection
+	virtual collection_memory_stats memory_stats(void) const = 0;
+
+	/// Releases unused memory, returns the number of bytes reclaimed
+	virtual std::size_t shrink_to_fit(void) = 0;
 protected:
 	update_key _next_update_key(void);
 
@@ -86,16 +109,57 @@ protected:
 
 	void _register(void);
 
-	collection_intf(manager<Group>& parent_manager)
+	template <typename KeySet>
+	void _for_each(
+		const KeySet& keys,
+		entity_cursor<Group>& cursor,
+		const iter_budget& budget,
+		const std::function<bool(
+			const iter_info&,
+			manager<Group>&,
+			entity_key
+		)>& function
+	) const;
+
+	collection_intf(manager<Group>& parent_manager, const char* name)
 	 : _pmanager(&parent_manager)
 	 , _cur_uk(0)
-	{ }
+	 , _name(name)
+	{
+		_update_stats_ids();
+	}
 public:
 	collection_intf(const collection_intf&) = delete;
 
 	collection_intf(collection_intf&& tmp);
 
 	virtual ~collection_intf(void);
+
+	/// Returns the name of this collection
+	const std::string& name(void) const
+	{
+		return _name;
+	}
+
+	/// Sets the name of this collection
+	/** The name is used to identify the collection in the statistics
+	 *  collected by manager_stats.
+	 *
+	 *  @see manager_stats
+	 */
+	void set_name(const std::string& name)
+	{
+		_name = name;
+		_update_stats_ids();
+	}
+
+#if EXCES_MANAGER_STATS
+	// implementation detail, do not use directly
+	std::size_t _stats_id(std::size_t i) const
+	{
+		return _stats_ids[i];
+	}
+#endif
 };
 
 /// Entity collection
@@ -104,8 +168,16 @@ public:
  *  a specified set of components, etc.
  *
  *  @see classification
+ *
+ *  @tparam Group the component group.
+ *  @tparam KeySet the type of set storing the keys of the entities,
+ *  either entity_key_set (ordered, default) or unordered_entity_key_set,
+ *  which does not support traversal with entity_cursor.
  */
-template <typename Group = default_group>
+template <
+	typename Group = default_group,
+	typename KeySet = entity_key_set<Group>
+>
 class collection
  : public collection_intf<Group>
 {
@@ -119,7 +191,12 @@ private:
 		)
 	> _filter_entity;
 
-	typedef entity_key_set<Group> _entity_key_set;
+	// the masks of the query filtering the entities (if any)
+	const detail::query_masks<Group>* _filter_masks;
+
+	bool _matches(typename manager<Group>::entity_key key);
+
+	typedef KeySet _entity_key_set;
 	_entity_key_set _entities;
 
 	typedef typename manager<Group>::entity_key entity_key;
@@ -164,8 +241,9 @@ public:
 		const std::function<
 			bool (manager<Group>&, entity_key)
 		>& entity_filter
-	): _base(parent_manager)
+	): _base(parent_manager, "collection")
 	 , _filter_entity(entity_filter)
+	 , _filter_masks(nullptr)
 	{
 		this->_register();
 	}
@@ -174,8 +252,26 @@ public:
 	collection(
 		manager<Group>& parent_manager,
 		MemFnRV (Component::*mem_fn_ptr)(void) const
-	): _base(parent_manager)
+	): _base(parent_manager, "collection")
 	 , _filter_entity(_call_comp_mem_fn<Component, MemFnRV>(mem_fn_ptr))
+	 , _filter_masks(nullptr)
+	{
+		this->_register();
+	}
+
+	/// Constructs a new collection of entities matching a query
+	/** The entities are filtered by testing the precomputed masks
+	 *  of the query, without calling a predicate function.
+	 *
+	 *  @see query
+	 */
+	template <typename ... Clauses>
+	collection(
+		manager<Group>& parent_manager,
+		query<Clauses...>
+	): _base(parent_manager, "collection")
+	 , _filter_entity()
+	 , _filter_masks(&query<Clauses...>::template masks<Group>())
 	{
 		this->_register();
 	}
@@ -187,9 +283,19 @@ public:
 	collection(collection&& tmp)
 	 : _base(static_cast<_base&&>(tmp))
 	 , _filter_entity(std::move(tmp._filter_entity))
+	 , _filter_masks(tmp._filter_masks)
 	 , _entities(std::move(tmp._entities))
 	{ }
 
+	/// Returns the memory statistics of this collection
+	collection_memory_stats memory_stats(void) const;
+
+	/// Releases the unused capacity of the key set
+	/**
+	 *  @return the number of bytes reclaimed.
+	 */
+	std::size_t shrink_to_fit(void);
+
 	/// Execute a @p function on each entity in the collection.
 	void for_each(
 		const std::function<bool(
@@ -198,6 +304,50 @@ public:
 			typename manager<Group>::entity_key
 		)>& function
 	) const;
+
+	/// Execute a @p function on entities in the collection, resuming at cursor
+	/** Visits the entities following the last entity visited with
+	 *  the specified @p cursor until the @p budget is spent or until
+	 *  the traversal is finished.
+	 *
+	 *  @see entity_cursor
+	 *  @see iter_budget
+	 */
+	void for_each(
+		entity_cursor<Group>& cursor,
+		const iter_budget& budget,
+		const std::function<bool(
+			const iter_info&,
+			manager<Group>&,
+			typename manager<Group>::entity_key
+		)>& function
+	) const
+	{
+		this->_for_each(_entities, cursor, budget, function);
+	}
+
+	/// Reduces the Component of the entities in the collection
+	/** Members of the collection not having the Component are skipped.
+	 *
+	 *  @see manager::reduce_keys
+	 */
+	template <typename Component, typename T, typename Map, typename Combine>
+	T reduce(
+		T init,
+		Map map,
+		Combine combine,
+		std::size_t max_threads = 0
+	) const
+	{
+		return this->_manager().template reduce_keys<Component>(
+			_entities.begin(),
+			_entities.end(),
+			std::move(init),
+			std::move(map),
+			std::move(combine),
+			max_threads
+		);
+	}
 };
 
 /// A template for entity classifications
@@ -220,8 +370,16 @@ public:
  *
  *  @tparam Class the type that is used to classify entities.
  *  @tparam Group the component group.
+ *  @tparam KeySet the type of set storing the keys of the entities
+ *  in each class, either entity_key_set (ordered, default)
+ *  or unordered_entity_key_set, which does not support traversal
+ *  with entity_cursor.
  */
-template <typename Class, typename Group = default_group>
+template <
+	typename Class,
+	typename Group = default_group,
+	typename KeySet = entity_key_set<Group>
+>
 class classification
  : public collection_intf<Group>
 {
@@ -244,7 +402,7 @@ private:
 
 	std::function<bool (Class)> _filter_class;
 
-	typedef entity_key_set<Group> _entity_key_set;
+	typedef KeySet _entity_key_set;
 
 	typedef std::map<Class, _entity_key_set> _class_map;
 	_class_map _classes;
@@ -337,7 +495,7 @@ public:
 		const std::function<
 			Class (manager<Group>&, entity_key)
 		>& classifier
-	): _base(parent_manager)
+	): _base(parent_manager, "classification")
 	 , _filter_entity(entity_filter)
 	 , _classify(classifier)
 	 , _filter_class()
@@ -360,7 +518,7 @@ public:
 			Class (manager<Group>&, entity_key)
 		>& classifier,
 		const std::function<bool (Class)>& class_filter
-	): _base(parent_manager)
+	): _base(parent_manager, "classification")
 	 , _filter_entity(entity_filter)
 	 , _classify(classifier)
 	 , _filter_class(class_filter)
@@ -372,7 +530,7 @@ public:
 	classification(
 		manager<Group>& parent_manager,
 		MemVarType Component::* mem_var_ptr
-	): _base(parent_manager)
+	): _base(parent_manager, "classification")
 	 , _filter_entity(&_has_component<Component>)
 	 , _classify(_get_comp_mem_var<Component, MemVarType>(mem_var_ptr))
 	 , _filter_class()
@@ -385,7 +543,7 @@ public:
 		manager<Group>& parent_manager,
 		MemVarType Component::* mem_var_ptr,
 		const std::function<bool (Class)>& class_filter
-	): _base(parent_manager)
+	): _base(parent_manager, "classification")
 	 , _filter_entity(&_has_component<Component>)
 	 , _classify(_get_comp_mem_var<Component, MemVarType>(mem_var_ptr))
 	 , _filter_class(class_filter)
@@ -397,7 +555,7 @@ public:
 	classification(
 		manager<Group>& parent_manager,
 		MemFnRV (Component::*mem_fn_ptr)(void) const
-	): _base(parent_manager)
+	): _base(parent_manager, "classification")
 	 , _filter_entity(&_has_component<Component>)
 	 , _classify(_call_comp_mem_fn<Component, MemFnRV>(mem_fn_ptr))
 	 , _filter_class()
@@ -410,7 +568,7 @@ public:
 		manager<Group>& parent_manager,
 		MemFnRV (Component::*mem_fn_ptr)(void) const,
 		const std::function<bool (Class)>& class_filter
-	): _base(parent_manager)
+	): _base(parent_manager, "classification")
 	 , _filter_entity(&_has_component<Component>)
 	 , _classify(_call_comp_mem_fn<Component, MemFnRV>(mem_fn_ptr))
 	 , _filter_class(class_filter)
@@ -434,6 +592,17 @@ public:
 	/// Returns the number of different classes
 	std::size_t class_count(void) const;
 
+	/// Returns the memory statistics of this classification
+	collection_memory_stats memory_stats(void) const;
+
+	/// Drops the empty classes and releases the unused capacity
+	/** The classes that are empty are removed, so class_count returns
+	 *  only the number of non-empty classes afterwards.
+	 *
+	 *  @return the number of bytes reclaimed.
+	 */
+	std::size_t shrink_to_fit(void);
+
 	/// Returns the number of entities of the specified class
 	std::size_t cardinality(const Class& entity_class) const;
 
@@ -446,6 +615,51 @@ public:
 			typename manager<Group>::entity_key
 		)>& function
 	) const;
+
+	/// Execute a @p function on entities in the entity_class, resuming at cursor
+	/** Visits the entities of the specified class following the last
+	 *  entity visited with the specified @p cursor until the @p budget
+	 *  is spent or until the traversal is finished.
+	 *
+	 *  @see entity_cursor
+	 *  @see iter_budget
+	 */
+	void for_each(
+		const Class& entity_class,
+		entity_cursor<Group>& cursor,
+		const iter_budget& budget,
+		const std::function<bool(
+			const iter_info&,
+			manager<Group>&,
+			typename manager<Group>::entity_key
+		)>& function
+	) const;
+
+	/// Reduces the Component of the entities in the specified entity_class
+	/** Returns @p init if there are no entities in the entity_class.
+	 *
+	 *  @see manager::reduce_keys
+	 */
+	template <typename Component, typename T, typename Map, typename Combine>
+	T reduce(
+		const Class& entity_class,
+		T init,
+		Map map,
+		Combine combine,
+		std::size_t max_threads = 0
+	) const
+	{
+		auto p = _classes.find(entity_class);
+		if(p == _classes.end()) return init;
+		return this->_manager().template reduce_keys<Component>(
+			p->second.begin(),
+			p->second.end(),
+			std::move(init),
+			std::move(map),
+			std::move(combine),
+			max_threads
+		);
+	}
 };
 
 } // namespace exces
@@ -75,6 +75,21 @@ protected:
 	}
 };
 
+// read-write mapped sh_comp_base
+template <typename Group, typename Component>
+class sh_comp_base<
+	Group,
+	Component,
+	component_kind_mapped,
+	component_access_read_write
+>: public sh_comp_base<
+	Group,
+	Component,
+	component_kind_normal,
+	component_access_read_write
+>
+{ };
+
 // read-write flyweight sh_comp_base
 template <typename Group, typename Component>
 class sh_comp_base<
@@ -18,5 +18,24 @@
 #define EXCES_BOOST_UUID_FOUND 0
 #endif
 
+/// Enables the counting and timing of manager operations
+#ifndef EXCES_MANAGER_STATS
+#define EXCES_MANAGER_STATS 0
+#endif
+
+/// Enables the lock statistics of instrumented_component_locking
+#ifndef EXCES_LOCK_STATS
+#define EXCES_LOCK_STATS 1
+#endif
+
+/// Enables the mmap-based storage of mapped components (Linux only)
+#ifndef EXCES_USE_MMAP
+#if defined(__linux__)
+#define EXCES_USE_MMAP 1
+#else
+#define EXCES_USE_MMAP 0
+#endif
+#endif
+
 #endif //include guard
 
@@ -0,0 +1,235 @@
+/**
+ *  @file exces/cursor.hpp
+ *  @brief Implements resumable entity traversal cursors and budgets
+ *
+ *  Copyright 2012-2014 Matus Chochlik. Distributed under the Boost
+ *  Software License, Version 1.0. (See accompanying file
+ *  LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef EXCES_CURSOR_1405101842_HPP
+#define EXCES_CURSOR_1405101842_HPP
+
+#include <exces/entity.hpp>
+
+#include <chrono>
+#include <limits>
+#include <cassert>
+#include <cstddef>
+
+namespace exces {
+
+/// Limits the amount of work done by a single step of resumable traversal
+/** An iteration budget limits the number of entities visited and/or
+ *  the time spent in a single call to one of the resumable for_each
+ *  functions. The traversal stops when any of the limits is reached.
+ *
+ *  @see entity_cursor
+ */
+class iter_budget
+{
+public:
+	/// The clock used for measuring the time limit
+	typedef std::chrono::steady_clock clock;
+private:
+	std::size_t _max_steps;
+	clock::duration _max_time;
+public:
+	/// Unlimited budget
+	iter_budget(void)
+	 : _max_steps(std::numeric_limits<std::size_t>::max())
+	 , _max_time(clock::duration::max())
+	{ }
+
+	/// Budget limited both by the number of steps and time
+	iter_budget(std::size_t max_steps, clock::duration max_time)
+	 : _max_steps(max_steps)
+	 , _max_time(max_time)
+	{ }
+
+	/// Budget allowing to visit at most @p n entities
+	static iter_budget steps(std::size_t n)
+	{
+		return iter_budget(n, clock::duration::max());
+	}
+
+	/// Budget allowing to run for at most the specified time
+	/** The time is checked every clock_check_interval steps.
+	 */
+	template <typename Rep, typename Period>
+	static iter_budget time(const std::chrono::duration<Rep, Period>& t)
+	{
+		return iter_budget(
+			std::numeric_limits<std::size_t>::max(),
+			std::chrono::duration_cast<clock::duration>(t)
+		);
+	}
+
+	/// Returns the maximum number of steps
+	std::size_t max_steps(void) const
+	{
+		return _max_steps;
+	}
+
+	/// Returns the maximum time
+	clock::duration max_time(void) const
+	{
+		return _max_time;
+	}
+
+	/// The number of steps between two checks of the time limit
+	static constexpr std::size_t clock_check_interval = 64;
+
+	/// Tracks the spending of an iteration budget
+	/** The clock is read only once every clock_check_interval steps,
+	 *  so that reading it does not cost as much as visiting cheap
+	 *  entities. The time limit can therefore be exceeded by the time
+	 *  it takes to visit up to clock_check_interval-1 entities.
+	 */
+	class tracker
+	{
+	private:
+		std::size_t _steps_left;
+		std::size_t _steps_to_check;
+		bool _timed;
+		clock::time_point _deadline;
+	public:
+		tracker(const iter_budget& budget)
+		 : _steps_left(budget._max_steps)
+		 , _steps_to_check(0)
+		 , _timed(budget._max_time != clock::duration::max())
+		{
+			if(_timed)
+			{
+				_deadline = clock::now() + budget._max_time;
+			}
+		}
+
+		/// Returns true if there is budget left for another step
+		bool affordable(void)
+		{
+			if(_steps_left == 0) return false;
+			if(_timed && (_steps_to_check-- == 0))
+			{
+				if(clock::now() >= _deadline)
+				{
+					// the following calls fail without the clock
+					_steps_left = 0;
+					return false;
+				}
+				_steps_to_check = clock_check_interval-1;
+			}
+			return true;
+		}
+
+		/// Spends a single step
+		void spend(void)
+		{
+			assert(_steps_left != 0);
+			--_steps_left;
+		}
+	};
+};
+
+/// Remembers the position of a resumable entity traversal
+/** Entity cursors are used with the resumable variants of the for_each
+ *  member functions of manager, collection and classification. Each such
+ *  call visits entities, starting after the last entity visited by the
+ *  previous call with the same cursor, until the iteration budget is spent
+ *  or until there are no more entities to visit, in which case the cursor
+ *  becomes done.
+ *
+ *  The cursor remembers the last visited entity (not a key or an iterator)
+ *  so it remains valid if entities are inserted or removed between
+ *  the resumptions and no locks are held between the resumptions.
+ *  Traversal of a manager or an ordered collection continues with the first
+ *  entity following the last visited one. Collections using
+ *  unordered_entity_key_set reorder their members on removal and cannot
+ *  be traversed with a cursor.
+ *
+ *  @code
+ *  manager<> m;
+ *  entity_cursor<> cur;
+ *
+ *  // every frame
+ *  if(cur.done()) cur.reset();
+ *  m.for_each(cur, iter_budget::time(std::chrono::microseconds(500)), f);
+ *  @endcode
+ *
+ *  @see iter_budget
+ */
+template <typename Group = default_group>
+class entity_cursor
+{
+public:
+	/// The entity type
+	typedef typename entity<Group>::type entity_type;
+private:
+	entity_type _last;
+	std::size_t _visited;
+	bool _started;
+	bool _done;
+public:
+	/// Constructs a cursor pointing to the start of a traversal
+	entity_cursor(void)
+	 : _last(entity_type::nil())
+	 , _visited(0)
+	 , _started(false)
+	 , _done(false)
+	{ }
+
+	/// Rewinds the cursor to the start of a traversal
+	void reset(void)
+	{
+		_last = entity_type::nil();
+		_visited = 0;
+		_started = false;
+		_done = false;
+	}
+
+	/// Returns true if the traversal has not visited any entities yet
+	bool at_start(void) const
+	{
+		return !_started;
+	}
+
+	/// Returns true if the traversal is finished
+	bool done(void) const
+	{
+		return _done;
+	}
+
+	/// Returns the number of entities visited since the last reset
+	std::size_t visited(void) const
+	{
+		return _visited;
+	}
+
+	/// Returns the last visited entity
+	/**
+	 *  @pre !at_start()
+	 */
+	const entity_type& last(void) const
+	{
+		assert(_started);
+		return _last;
+	}
+
+	// implementation detail, do not use directly
+	void _advance(const entity_type& e)
+	{
+		_last = e;
+		_started = true;
+		++_visited;
+	}
+
+	// implementation detail, do not use directly
+	void _finish(void)
+	{
+		_done = true;
+	}
+};
+
+} // namespace exces
+
+#endif //include guard
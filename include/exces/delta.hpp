@@ -0,0 +1,322 @@
+/**
+ *  @file exces/delta.hpp
+ *  @brief Differences between the states of two managers
+ *
+ *  Copyright 2012-2014 Matus Chochlik. Distributed under the Boost
+ *  Software License, Version 1.0. (See accompanying file
+ *  LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef EXCES_DELTA_1405231040_HPP
+#define EXCES_DELTA_1405231040_HPP
+
+#include <exces/fwd.hpp>
+#include <exces/group.hpp>
+#include <exces/entity.hpp>
+#include <exces/metaprog.hpp>
+#include <exces/storage.hpp>
+#include <exces/detail/component.hpp>
+
+#include <type_traits>
+#include <memory>
+#include <vector>
+#include <cstring>
+#include <cassert>
+#include <cstddef>
+
+namespace exces {
+
+template <typename Group>
+class manager_delta;
+
+namespace detail {
+
+// checks if instances of T can be compared with ==
+template <typename T>
+struct delta_comparable
+{
+	template <typename U>
+	static auto _check(const U* p) -> decltype(
+		bool(*p == *p),
+		std::true_type()
+	);
+
+	static std::false_type _check(...);
+
+	typedef decltype(_check(static_cast<const T*>(nullptr))) type;
+
+	static constexpr bool value = type::value;
+};
+
+template <typename T, typename Raw>
+inline bool delta_equal(const T& a, const T& b, std::true_type, Raw)
+{
+	return a == b;
+}
+
+template <typename T>
+inline bool delta_equal(const T& a, const T& b, std::false_type, std::true_type)
+{
+	return std::memcmp(&a, &b, sizeof(T)) == 0;
+}
+
+// values that cannot be compared are always considered changed
+template <typename T>
+inline bool delta_equal(const T&, const T&, std::false_type, std::false_type)
+{
+	return false;
+}
+
+// compares two component values, with == if available
+// or bytewise if the components are trivially copyable
+template <typename T>
+inline bool delta_equal(const T& a, const T& b)
+{
+	return delta_equal(
+		a, b,
+		typename delta_comparable<T>::type(),
+		std::integral_constant<
+			bool,
+			std::is_trivially_copyable<T>::value
+		>()
+	);
+}
+
+// the new values of a single component type in a manager_delta
+template <typename Group>
+struct delta_column_intf
+{
+	typedef typename component_storage<Group>::component_key
+		component_key;
+
+	virtual ~delta_column_intf(void) { }
+
+	virtual std::size_t size(void) const = 0;
+
+	virtual void clear(void) = 0;
+
+	// starts the comparison of the values in the specified storages,
+	// which must not be modified until the comparison is finished
+	virtual void begin_diff(
+		component_storage<Group>& from,
+		component_storage<Group>& to
+	) = 0;
+
+	// appends the value with the specified key in the second storage
+	virtual void append(component_key) = 0;
+
+	// appends the value in the second storage if it differs
+	// from the value in the first storage, returns true if appended
+	virtual bool append_changed(component_key, component_key) = 0;
+};
+
+template <typename Group, typename Component>
+struct delta_column
+ : delta_column_intf<Group>
+{
+	typedef typename delta_column_intf<Group>::component_key
+		component_key;
+
+	std::vector<Component> values;
+
+	// the compared storages are accessed directly through their blocks
+	component_block<Component> from, to;
+
+	std::size_t size(void) const
+	{
+		return values.size();
+	}
+
+	void clear(void)
+	{
+		values.clear();
+	}
+
+	void begin_diff(
+		component_storage<Group>& fs,
+		component_storage<Group>& ts
+	)
+	{
+		from = fs.template block<Component>();
+		to = ts.template block<Component>();
+	}
+
+	void append(component_key tk)
+	{
+		assert(tk < to.size);
+		values.push_back(to.components[tk]);
+	}
+
+	bool append_changed(component_key fk, component_key tk)
+	{
+		assert(fk < from.size);
+		assert(tk < to.size);
+		if(delta_equal(from.components[fk], to.components[tk]))
+		{
+			return false;
+		}
+		values.push_back(to.components[tk]);
+		return true;
+	}
+};
+
+} // namespace detail
+
+/// The difference between the states of two managers
+/** A delta is created by the diff function from two managers (or two
+ *  states of a manager) and contains the entities whose components
+ *  differ, the components added to and removed from those entities and
+ *  the new values of the added and changed components. Applying it with
+ *  patch to a manager in the first state puts it into the second state.
+ *
+ *  Entities without any components are considered to be non-existent,
+ *  so an entity is created when it gets its first components and it is
+ *  destroyed when it loses all of them.
+ *
+ *  @see diff
+ *  @see patch
+ */
+template <typename Group = default_group>
+class manager_delta
+{
+public:
+	/// The entity type
+	typedef typename entity<Group>::type entity_type;
+private:
+	friend class manager<Group>;
+
+	typedef detail::component_bitset<Group> _component_bitset;
+	typedef mp::size<components<Group>> _component_count;
+
+	// the change of the components of a single entity
+	struct _entry
+	{
+		entity_type entity;
+		_component_bitset removed;
+		_component_bitset added;
+		_component_bitset changed;
+	};
+
+	// the entries ordered by the entity
+	std::vector<_entry> _entries;
+	std::vector<entity_type> _created;
+	std::vector<entity_type> _destroyed;
+
+	// the new values of the added and changed components, ordered
+	// by the component ids and then in the order of the entries
+	typedef detail::delta_column_intf<Group> _column;
+	std::vector<std::unique_ptr<_column>> _columns;
+
+	struct _column_maker
+	{
+		std::vector<std::unique_ptr<_column>>& _columns;
+
+		template <typename Component>
+		void operator()(mp::identity<Component>) const
+		{
+			_columns[component_id<Component, Group>::value].reset(
+				new detail::delta_column<Group, Component>()
+			);
+		}
+	};
+
+	template <typename Component>
+	const std::vector<Component>& _values(void) const
+	{
+		typedef detail::delta_column<Group, Component> column;
+		return static_cast<const column&>(
+			*_columns[component_id<Component, Group>::value]
+		).values;
+	}
+public:
+	/// Constructs an empty delta
+	manager_delta(void)
+	 : _columns(_component_count::value)
+	{
+		_column_maker maker = { _columns };
+		mp::for_each<typename components<Group>::type>(maker);
+	}
+
+	manager_delta(manager_delta&&) = default;
+	manager_delta& operator = (manager_delta&&) = default;
+
+	/// Returns true if the delta contains no changes
+	bool empty(void) const
+	{
+		return _entries.empty();
+	}
+
+	/// Returns the number of changed entities
+	std::size_t size(void) const
+	{
+		return _entries.size();
+	}
+
+	/// Returns the entities that are created by the delta
+	const std::vector<entity_type>& created(void) const
+	{
+		return _created;
+	}
+
+	/// Returns the entities that are destroyed by the delta
+	const std::vector<entity_type>& destroyed(void) const
+	{
+		return _destroyed;
+	}
+
+	/// Returns the number of the new values of Component in the delta
+	template <typename Component>
+	std::size_t value_count(void) const
+	{
+		return _values<Component>().size();
+	}
+
+	/// Removes all changes from the delta
+	void clear(void)
+	{
+		_entries.clear();
+		_created.clear();
+		_destroyed.clear();
+		for(const std::unique_ptr<_column>& column : _columns)
+		{
+			column->clear();
+		}
+	}
+};
+
+/// Returns the delta transforming the state of manager a into that of b
+/** The entity maps of both managers are traversed in order and entities
+ *  with the same component bitsets are compared only by the values
+ *  of their components. Components are compared with == if they define
+ *  it, bytewise if they are trivially copyable and they are always
+ *  considered changed otherwise.
+ *
+ *  @see patch
+ *  @see manager_delta
+ */
+template <typename Group>
+inline manager_delta<Group> diff(manager<Group>& a, manager<Group>& b)
+{
+	return a.diff(b);
+}
+
+/// Applies the delta to manager m
+/** The components of each changed entity are removed, added and replaced
+ *  with a single operation each.
+ *
+ *  @throws std::invalid_argument if m is missing components that
+ *  the delta removes or replaces, i.e. if m is not in the state
+ *  the delta was created from.
+ *
+ *  @see diff
+ *  @see manager_delta
+ */
+template <typename Group>
+inline void patch(manager<Group>& m, const manager_delta<Group>& delta)
+{
+	m.patch(delta);
+}
+
+} // namespace exces
+
+#endif //include guard
@@ -0,0 +1,302 @@
+/**
+ *  @file exces/detail/bitset.hpp
+ *  @brief Fixed-width bitset with word-wise operations
+ *
+ *  Copyright 2012-2014 Matus Chochlik. Distributed under the Boost
+ *  Software License, Version 1.0. (See accompanying file
+ *  LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef EXCES_AUX_BITSET_1405261430_HPP
+#define EXCES_AUX_BITSET_1405261430_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cassert>
+
+namespace exces {
+namespace detail {
+
+typedef std::uint64_t bitset_word;
+
+inline std::size_t bitset_popcount(bitset_word w)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return std::size_t(__builtin_popcountll(w));
+#else
+	w = w - ((w >> 1) & 0x5555555555555555ULL);
+	w = (w & 0x3333333333333333ULL) + ((w >> 2) & 0x3333333333333333ULL);
+	w = (w + (w >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+	return std::size_t((w * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+inline std::size_t bitset_ctz(bitset_word w)
+{
+	assert(w != 0);
+#if defined(__GNUC__) || defined(__clang__)
+	return std::size_t(__builtin_ctzll(w));
+#else
+	std::size_t n = 0;
+	while(!(w & 1)) { w >>= 1; ++n; }
+	return n;
+#endif
+}
+
+// Fixed-width bitset stored in 64-bit words
+//
+// Provides the subset of the std::bitset interface used by the manager,
+// plus word-wise comparison, hashing, rank and mask tests which
+// std::bitset lacks or implements bit by bit. The operations on
+// the whole set are plain loops over a constant number of words
+// that the compiler unrolls and vectorizes. The unused bits
+// of the last word are always zero.
+template <std::size_t N>
+class fixed_bitset
+{
+public:
+	static const std::size_t word_bits = sizeof(bitset_word)*8;
+	static const std::size_t word_count = N?(N+word_bits-1)/word_bits:1;
+private:
+	bitset_word _words[word_count];
+
+	static bitset_word _bit(std::size_t i)
+	{
+		return bitset_word(1) << (i % word_bits);
+	}
+
+	static bitset_word _last_mask(void)
+	{
+		return (N % word_bits)?
+			(bitset_word(1) << (N % word_bits))-1:
+			~bitset_word(0);
+	}
+public:
+	fixed_bitset(void)
+	 : _words()
+	{ }
+
+	static constexpr std::size_t size(void)
+	{
+		return N;
+	}
+
+	bitset_word word(std::size_t w) const
+	{
+		assert(w < word_count);
+		return _words[w];
+	}
+
+	bool test(std::size_t i) const
+	{
+		assert(i < N);
+		return (_words[i / word_bits] & _bit(i)) != 0;
+	}
+
+	bool operator [](std::size_t i) const
+	{
+		return test(i);
+	}
+
+	fixed_bitset& set(void)
+	{
+		for(std::size_t w=0; w!=word_count; ++w)
+			_words[w] = ~bitset_word(0);
+		_words[word_count-1] &= _last_mask();
+		return *this;
+	}
+
+	fixed_bitset& set(std::size_t i, bool value = true)
+	{
+		assert(i < N);
+		if(value) _words[i / word_bits] |= _bit(i);
+		else _words[i / word_bits] &= ~_bit(i);
+		return *this;
+	}
+
+	fixed_bitset& reset(void)
+	{
+		for(std::size_t w=0; w!=word_count; ++w)
+			_words[w] = 0;
+		return *this;
+	}
+
+	fixed_bitset& reset(std::size_t i)
+	{
+		return set(i, false);
+	}
+
+	/// Returns the number of set bits
+	std::size_t count(void) const
+	{
+		std::size_t result = 0;
+		for(std::size_t w=0; w!=word_count; ++w)
+			result += bitset_popcount(_words[w]);
+		return result;
+	}
+
+	/// Returns the number of set bits preceding the i-th bit
+	std::size_t rank(std::size_t i) const
+	{
+		assert(i <= N);
+		std::size_t result = 0;
+		const std::size_t wi = i / word_bits;
+		for(std::size_t w=0; w!=wi; ++w)
+			result += bitset_popcount(_words[w]);
+		if(i % word_bits)
+			result += bitset_popcount(_words[wi] & (_bit(i)-1));
+		return result;
+	}
+
+	bool any(void) const
+	{
+		bitset_word acc = 0;
+		for(std::size_t w=0; w!=word_count; ++w)
+			acc |= _words[w];
+		return acc != 0;
+	}
+
+	bool none(void) const
+	{
+		return !any();
+	}
+
+	/// Returns true if all bits set in mask are set in this bitset
+	bool contains(const fixed_bitset& mask) const
+	{
+		bitset_word acc = 0;
+		for(std::size_t w=0; w!=word_count; ++w)
+			acc |= mask._words[w] & ~_words[w];
+		return acc == 0;
+	}
+
+	/// Returns true if some bit is set in both this bitset and mask
+	bool intersects(const fixed_bitset& mask) const
+	{
+		bitset_word acc = 0;
+		for(std::size_t w=0; w!=word_count; ++w)
+			acc |= mask._words[w] & _words[w];
+		return acc != 0;
+	}
+
+	/// Returns true if the bits selected by mask are equal to required
+	bool matches(
+		const fixed_bitset& mask,
+		const fixed_bitset& required
+	) const
+	{
+		bitset_word acc = 0;
+		for(std::size_t w=0; w!=word_count; ++w)
+			acc |= (_words[w] & mask._words[w]) ^ required._words[w];
+		return acc == 0;
+	}
+
+	/// Calls func with the index of each set bit in ascending order
+	template <typename Function>
+	void for_each_set(Function func) const
+	{
+		for(std::size_t w=0; w!=word_count; ++w)
+		{
+			bitset_word bits = _words[w];
+			while(bits)
+			{
+				func(w*word_bits+bitset_ctz(bits));
+				bits &= bits-1;
+			}
+		}
+	}
+
+	std::size_t hash(void) const
+	{
+		bitset_word h = 0xCBF29CE484222325ULL;
+		for(std::size_t w=0; w!=word_count; ++w)
+		{
+			h ^= _words[w];
+			h *= 0x100000001B3ULL;
+			h ^= h >> 29;
+		}
+		return std::size_t(h);
+	}
+
+	fixed_bitset& operator &= (const fixed_bitset& that)
+	{
+		for(std::size_t w=0; w!=word_count; ++w)
+			_words[w] &= that._words[w];
+		return *this;
+	}
+
+	fixed_bitset& operator |= (const fixed_bitset& that)
+	{
+		for(std::size_t w=0; w!=word_count; ++w)
+			_words[w] |= that._words[w];
+		return *this;
+	}
+
+	fixed_bitset& operator ^= (const fixed_bitset& that)
+	{
+		for(std::size_t w=0; w!=word_count; ++w)
+			_words[w] ^= that._words[w];
+		return *this;
+	}
+
+	/// Clears the bits which are set in that
+	fixed_bitset& and_not(const fixed_bitset& that)
+	{
+		for(std::size_t w=0; w!=word_count; ++w)
+			_words[w] &= ~that._words[w];
+		return *this;
+	}
+
+	fixed_bitset operator ~ (void) const
+	{
+		fixed_bitset result;
+		for(std::size_t w=0; w!=word_count; ++w)
+			result._words[w] = ~_words[w];
+		result._words[word_count-1] &= _last_mask();
+		return result;
+	}
+
+	friend fixed_bitset operator & (fixed_bitset a, const fixed_bitset& b)
+	{
+		return a &= b;
+	}
+
+	friend fixed_bitset operator | (fixed_bitset a, const fixed_bitset& b)
+	{
+		return a |= b;
+	}
+
+	friend fixed_bitset operator ^ (fixed_bitset a, const fixed_bitset& b)
+	{
+		return a ^= b;
+	}
+
+	friend bool operator == (const fixed_bitset& a, const fixed_bitset& b)
+	{
+		bitset_word acc = 0;
+		for(std::size_t w=0; w!=word_count; ++w)
+			acc |= a._words[w] ^ b._words[w];
+		return acc == 0;
+	}
+
+	friend bool operator != (const fixed_bitset& a, const fixed_bitset& b)
+	{
+		return !(a == b);
+	}
+
+	// word-wise strict weak ordering, not the numeric order
+	friend bool operator <  (const fixed_bitset& a, const fixed_bitset& b)
+	{
+		for(std::size_t w=0; w!=word_count; ++w)
+		{
+			if(a._words[w] != b._words[w])
+				return a._words[w] < b._words[w];
+		}
+		return false;
+	}
+};
+
+} // namespace detail
+} // namespace exces
+
+#endif //include guard
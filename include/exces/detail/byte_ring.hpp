@@ -0,0 +1,122 @@
+/**
+ *  @file exces/detail/byte_ring.hpp
+ *  @brief Lock-free single-producer single-consumer ring buffer of bytes
+ *
+ *  Copyright 2012-2014 Matus Chochlik. Distributed under the Boost
+ *  Software License, Version 1.0. (See accompanying file
+ *  LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef EXCES_AUX_BYTE_RING_1405221015_HPP
+#define EXCES_AUX_BYTE_RING_1405221015_HPP
+
+#include <exces/detail/cache_aligned.hpp>
+
+#include <atomic>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cassert>
+#include <cstddef>
+
+namespace exces {
+namespace detail {
+
+// ring buffer of bytes written by one producer and read by one consumer
+// thread at a time without locking. The positions grow monotonically
+// and are wrapped by masking, so the capacity is a power of two
+class byte_ring
+ : public cache_aligned_new
+{
+private:
+	static const std::size_t _cache_line = cache_line_size;
+
+	std::vector<char> _data;
+	std::size_t _mask;
+
+	// the producer and consumer positions are on separate cache lines
+	struct alignas(_cache_line) _position
+	{
+		std::atomic<std::size_t> value;
+	};
+	_position _head;
+	_position _tail;
+
+	static std::size_t _round_up(std::size_t capacity)
+	{
+		std::size_t result = 64;
+		while(result < capacity) result *= 2;
+		return result;
+	}
+
+	void _copy_in(std::size_t pos, const char* bytes, std::size_t size)
+	{
+		const std::size_t offs = pos & _mask;
+		const std::size_t first = std::min(size, _data.size()-offs);
+		std::memcpy(_data.data()+offs, bytes, first);
+		std::memcpy(_data.data(), bytes+first, size-first);
+	}
+
+	void _copy_out(std::size_t pos, char* bytes, std::size_t size) const
+	{
+		const std::size_t offs = pos & _mask;
+		const std::size_t first = std::min(size, _data.size()-offs);
+		std::memcpy(bytes, _data.data()+offs, first);
+		std::memcpy(bytes+first, _data.data(), size-first);
+	}
+public:
+	byte_ring(std::size_t capacity)
+	 : _data(_round_up(capacity))
+	 , _mask(_data.size()-1)
+	{
+		_head.value = 0;
+		_tail.value = 0;
+	}
+
+	byte_ring(const byte_ring&) = delete;
+
+	std::size_t capacity(void) const
+	{
+		return _data.size();
+	}
+
+	// producer: appends all of the bytes or nothing if they do not fit
+	bool push(const char* bytes, std::size_t size)
+	{
+		const std::size_t head = _head.value.load(std::memory_order_relaxed);
+		const std::size_t tail = _tail.value.load(std::memory_order_acquire);
+		if(size > _data.size()-(head-tail)) return false;
+
+		_copy_in(head, bytes, size);
+		_head.value.store(head+size, std::memory_order_release);
+		return true;
+	}
+
+	// consumer: the number of bytes available for reading
+	std::size_t size(void) const
+	{
+		const std::size_t tail = _tail.value.load(std::memory_order_relaxed);
+		return _head.value.load(std::memory_order_acquire)-tail;
+	}
+
+	// consumer: copies size bytes at offset from the read position
+	void peek(std::size_t offset, char* bytes, std::size_t size) const
+	{
+		assert(offset+size <= this->size());
+		const std::size_t tail = _tail.value.load(std::memory_order_relaxed);
+		_copy_out(tail+offset, bytes, size);
+	}
+
+	// consumer: releases size bytes at the read position
+	void pop(std::size_t size)
+	{
+		assert(size <= this->size());
+		const std::size_t tail = _tail.value.load(std::memory_order_relaxed);
+		_tail.value.store(tail+size, std::memory_order_release);
+	}
+};
+
+} // namespace detail
+} // namespace exces
+
+#endif //include guard
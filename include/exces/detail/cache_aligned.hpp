@@ -0,0 +1,49 @@
+/**
+ *  @file exces/detail/cache_aligned.hpp
+ *  @brief Allocation of objects aligned to cache lines
+ *
+ *  Copyright 2012-2014 Matus Chochlik. Distributed under the Boost
+ *  Software License, Version 1.0. (See accompanying file
+ *  LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef EXCES_AUX_CACHE_ALIGNED_1405271015_HPP
+#define EXCES_AUX_CACHE_ALIGNED_1405271015_HPP
+
+#include <new>
+#include <cstddef>
+#include <cstdint>
+
+namespace exces {
+namespace detail {
+
+static const std::size_t cache_line_size = 64;
+
+// base class for classes with cache line aligned members, the operator new
+// before C++17 ignores extended alignment, so the heap allocated instances
+// are aligned explicitly. The pointer to the allocated block is stored
+// right before the aligned object
+struct cache_aligned_new
+{
+	static void* operator new(std::size_t size)
+	{
+		const std::size_t extra = cache_line_size+sizeof(void*);
+		void* block = ::operator new(size+extra);
+		const std::uintptr_t addr =
+			(reinterpret_cast<std::uintptr_t>(block)+extra) &
+			~std::uintptr_t(cache_line_size-1);
+		void* result = reinterpret_cast<void*>(addr);
+		static_cast<void**>(result)[-1] = block;
+		return result;
+	}
+
+	static void operator delete(void* ptr)
+	{
+		if(ptr) ::operator delete(static_cast<void**>(ptr)[-1]);
+	}
+};
+
+} // namespace detail
+} // namespace exces
+
+#endif //include guard
@@ -12,10 +12,11 @@
 
 #include <exces/fwd.hpp>
 #include <exces/detail/metaprog.hpp>
+#include <exces/memory_stats.hpp>
+#include <exces/detail/bitset.hpp>
 
 #include <map>
 #include <array>
-#include <bitset>
 
 namespace exces {
 
@@ -39,37 +40,21 @@ struct sort_components
  : mp::sort<Components, component_less_mf<Group>>
 { };
 
-// less than comparison for bitsets smaller than uint
-struct component_bitset_less_small
-{
-	template <typename Bitset>
-	bool operator()(const Bitset& a, const Bitset& b) const
-	{
-		return a.to_ulong() < b.to_ulong();
-	}
-};
+template <typename Group>
+struct component_bitset
+ : fixed_bitset<mp::size<components<Group>>::value>
+{ };
 
-// less than comparison for bitsets bigger than uint
-template <typename Size>
-struct component_bitset_less_big
+// compares component bitsets word by word
+struct component_bitset_less
 {
 	template <typename Bitset>
 	bool operator()(const Bitset& a, const Bitset& b) const
 	{
-		for(std::size_t i=0; i!=Size(); ++i)
-		{
-			if(a[i] < b[i]) return true;
-			if(a[i] > b[i]) return false;
-		}
-		return false;
+		return a < b;
 	}
 };
 
-template <typename Group>
-struct component_bitset
- : std::bitset<mp::size<components<Group>>::value>
-{ };
-
 template <typename Group>
 class component_index_map
 {
@@ -83,14 +68,6 @@ public:
 		_component_count::value
 	> index_vector;
 private:
-	// the less than comparison functor to be used
-	// when comparing two bitsets
-	typedef typename mp::if_c<
-		_component_count::value <= sizeof(unsigned long)*8,
-		component_bitset_less_small,
-		component_bitset_less_big<_component_count>
-	>::type component_bitset_less;
-
 	typedef std::map<
 		component_bitset<Group>,
 		index_vector,
@@ -101,6 +78,16 @@ private:
 public:
 	const index_vector& get(const component_bitset<Group>& bits) const;
 	const index_vector& get(const component_bitset<Group>& bits);
+
+	std::size_t size(void) const
+	{
+		return _indices.size();
+	}
+
+	std::size_t memory_bytes(void) const
+	{
+		return _indices.size()*map_node_bytes<_index_map>();
+	}
 };
 
 } // namespace detail
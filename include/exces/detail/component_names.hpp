@@ -0,0 +1,145 @@
+/**
+ *  @file exces/detail/component_names.hpp
+ *  @brief Perfect hash table mapping component names to component ids
+ *
+ *  Copyright 2012-2014 Matus Chochlik. Distributed under the Boost
+ *  Software License, Version 1.0. (See accompanying file
+ *  LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef EXCES_AUX_COMPONENT_NAMES_1405241120_HPP
+#define EXCES_AUX_COMPONENT_NAMES_1405241120_HPP
+
+#include <exces/fwd.hpp>
+#include <exces/detail/metaprog.hpp>
+
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+
+namespace exces {
+
+template <typename Group>
+struct components;
+
+template <typename Component>
+struct component_name;
+
+namespace detail {
+
+// seeded FNV-1a hash of a component name
+inline std::uint32_t component_name_hash(
+	const char* name,
+	std::size_t size,
+	std::uint32_t seed
+)
+{
+	std::uint32_t result = 2166136261u ^ seed;
+	for(std::size_t i=0; i!=size; ++i)
+	{
+		result ^= std::uint32_t(static_cast<unsigned char>(name[i]));
+		result *= 16777619u;
+	}
+	return result;
+}
+
+// perfect hash table of the names of the components in a Group, built
+// once on the first use. The seed and size of the table are chosen so
+// that no two names share a slot, so a lookup hashes the name once
+// and compares it with a single candidate
+template <typename Group>
+class component_name_table
+{
+private:
+	typedef mp::size<components<Group>> _component_count;
+
+	std::vector<const char*> _names;
+	std::vector<std::size_t> _sizes;
+
+	// component id + 1 or zero for empty slots
+	std::vector<std::size_t> _slots;
+	std::uint32_t _seed;
+	std::size_t _mask;
+
+	struct _collector
+	{
+		component_name_table& _table;
+
+		template <typename Component>
+		void operator()(mp::identity<Component>) const
+		{
+			const std::size_t cid =
+				component_id<Component, Group>::value;
+			_table._names[cid] = component_name<Component>::c_str();
+			_table._sizes[cid] = component_name<Component>::size();
+		}
+	};
+
+	std::size_t _slot(const char* name, std::size_t size) const
+	{
+		return component_name_hash(name, size, _seed) & _mask;
+	}
+
+	bool _try_build(void)
+	{
+		std::fill(_slots.begin(), _slots.end(), 0);
+		for(std::size_t cid=0; cid!=_names.size(); ++cid)
+		{
+			std::size_t& slot = _slots[_slot(_names[cid], _sizes[cid])];
+			if(slot != 0) return false;
+			slot = cid+1;
+		}
+		return true;
+	}
+
+	component_name_table(void)
+	 : _names(_component_count::value)
+	 , _sizes(_component_count::value)
+	 , _seed(0)
+	{
+		_collector collector = { *this };
+		mp::for_each<typename components<Group>::type>(collector);
+
+		std::size_t size = 1;
+		while(size < 2*_names.size()) size *= 2;
+
+		while(true)
+		{
+			_slots.resize(size);
+			_mask = size-1;
+			for(_seed=0; _seed!=256; ++_seed)
+			{
+				if(_try_build()) return;
+			}
+			size *= 2;
+		}
+	}
+public:
+	static const component_name_table& instance(void)
+	{
+		static const component_name_table table;
+		return table;
+	}
+
+	// returns the id of the component with the specified name
+	// or ~0 if there is no such component in the Group
+	std::size_t find(const char* name, std::size_t size) const
+	{
+		const std::size_t slot = _slots[_slot(name, size)];
+		if(slot != 0)
+		{
+			const std::size_t cid = slot-1;
+			if(	(_sizes[cid] == size) &&
+				(std::memcmp(_names[cid], name, size) == 0)
+			) return cid;
+		}
+		return ~std::size_t(0);
+	}
+};
+
+} // namespace detail
+} // namespace exces
+
+#endif //include guard
@@ -36,7 +36,7 @@ namespace cntr {
 struct null_ { };
 
 // the initial value of the counter
-typedef exces::mp::size_t_<-1> initial;
+typedef exces::mp::size_t_<std::size_t(-1)> initial;
 
 // the zero value
 typedef exces::mp::size_t_<0> zero;
@@ -0,0 +1,137 @@
+/**
+ *  @file exces/detail/mapped_file.hpp
+ *  @brief Read-only file mapped into memory
+ *
+ *  Copyright 2012-2014 Matus Chochlik. Distributed under the Boost
+ *  Software License, Version 1.0. (See accompanying file
+ *  LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef EXCES_AUX_MAPPED_FILE_1405211020_HPP
+#define EXCES_AUX_MAPPED_FILE_1405211020_HPP
+
+#include <exces/config.hpp>
+
+#include <string>
+#include <stdexcept>
+#include <cstddef>
+
+#if EXCES_USE_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#include <vector>
+#include <cstdint>
+#endif
+
+namespace exces {
+namespace detail {
+
+// the contents of a file mapped read-only into memory, the mapped pages
+// are shared with the page cache (and other processes mapping the file).
+// Without mmap the file is read into a page-aligned buffer
+class mapped_file
+{
+private:
+	const char* _data;
+	std::size_t _size;
+#if EXCES_USE_MMAP
+	void* _mapping;
+#else
+	std::vector<char> _buffer;
+	static constexpr std::size_t _alignment = 4096;
+#endif
+
+	static void _fail(const std::string& path)
+	{
+		throw std::runtime_error(
+			"exces::mapped_file: cannot map '"+path+"'"
+		);
+	}
+public:
+	explicit mapped_file(const std::string& path)
+	 : _data(nullptr)
+	 , _size(0)
+#if EXCES_USE_MMAP
+	 , _mapping(nullptr)
+#endif
+	{
+#if EXCES_USE_MMAP
+		int fd = ::open(path.c_str(), O_RDONLY);
+		if(fd < 0) _fail(path);
+
+		struct ::stat st;
+		if(::fstat(fd, &st) != 0)
+		{
+			::close(fd);
+			_fail(path);
+		}
+		_size = std::size_t(st.st_size);
+		if(_size != 0)
+		{
+			_mapping = ::mmap(
+				nullptr,
+				_size,
+				PROT_READ,
+				MAP_SHARED,
+				fd, 0
+			);
+		}
+		// the mapping stays valid after the file is closed
+		::close(fd);
+		if(_mapping == MAP_FAILED)
+		{
+			_mapping = nullptr;
+			_fail(path);
+		}
+		_data = static_cast<const char*>(_mapping);
+#else
+		std::ifstream input(path.c_str(), std::ios::binary);
+		if(!input.good()) _fail(path);
+		input.seekg(0, std::ios::end);
+		_size = std::size_t(input.tellg());
+		input.seekg(0, std::ios::beg);
+
+		_buffer.resize(_size+_alignment);
+		std::uintptr_t addr = reinterpret_cast<std::uintptr_t>(
+			_buffer.data()
+		);
+		addr = ((addr+_alignment-1)/_alignment)*_alignment;
+		char* data = reinterpret_cast<char*>(addr);
+		input.read(data, std::streamsize(_size));
+		if(!input.good()) _fail(path);
+		_data = data;
+#endif
+	}
+
+	mapped_file(const mapped_file&) = delete;
+	mapped_file& operator = (const mapped_file&) = delete;
+
+	~mapped_file(void)
+	{
+#if EXCES_USE_MMAP
+		if(_mapping != nullptr)
+		{
+			::munmap(_mapping, _size);
+		}
+#endif
+	}
+
+	const char* data(void) const
+	{
+		return _data;
+	}
+
+	std::size_t size(void) const
+	{
+		return _size;
+	}
+};
+
+} // namespace detail
+} // namespace exces
+
+#endif //include guard
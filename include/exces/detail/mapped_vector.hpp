@@ -0,0 +1,346 @@
+/**
+ *  @file exces/detail/mapped_vector.hpp
+ *  @brief Vector storing its elements in a reserved range of virtual memory
+ *
+ *  Copyright 2012-2014 Matus Chochlik. Distributed under the Boost
+ *  Software License, Version 1.0. (See accompanying file
+ *  LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef EXCES_AUX_MAPPED_VECTOR_1405191015_HPP
+#define EXCES_AUX_MAPPED_VECTOR_1405191015_HPP
+
+#include <exces/config.hpp>
+
+#include <vector>
+#include <algorithm>
+#include <new>
+#include <memory>
+#include <utility>
+#include <stdexcept>
+#include <cassert>
+#include <cstdint>
+#include <cstddef>
+
+#if EXCES_USE_MMAP
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace exces {
+namespace detail {
+
+// selects std::vector as the container of component_entry_vector
+struct std_vector_sel
+{
+	template <typename T>
+	struct apply
+	{
+		typedef std::vector<T> type;
+	};
+};
+
+#if EXCES_USE_MMAP
+
+// vector-like container of T, that reserves a large range of virtual memory
+// up-front and commits it in chunks as it grows, so the elements are never
+// relocated. The Options type provides the reserved_bytes and huge_pages
+// static member functions (see component_mapping)
+template <typename T, typename Options>
+class mapped_vector
+{
+private:
+	// pointer to and the size of the whole mapping
+	void* _mapping;
+	std::size_t _mapping_size;
+
+	// the aligned start of the elements
+	T* _data;
+	std::size_t _size;
+	// the number of committed bytes (readable and writable)
+	std::size_t _committed;
+	// the number of reserved bytes starting at _data
+	std::size_t _reserved;
+
+	// the memory is committed and aligned in 2MB chunks
+	// (the size of a transparent huge page on x86-64)
+	static std::size_t _granularity(void)
+	{
+		return std::size_t(2) << 20;
+	}
+
+	static std::size_t _round_up(std::size_t bytes)
+	{
+		const std::size_t g = _granularity();
+		return ((bytes+g-1)/g)*g;
+	}
+
+	char* _bytes(void) const
+	{
+		return reinterpret_cast<char*>(_data);
+	}
+
+	void _commit(std::size_t bytes)
+	{
+		if(bytes <= _committed) return;
+		if(bytes > _reserved)
+		{
+			throw std::length_error(
+				"exces::mapped_vector: "
+				"reserved address range exhausted"
+			);
+		}
+		std::size_t new_committed = _round_up(bytes);
+		if(new_committed > _reserved) new_committed = _reserved;
+
+		if(::mprotect(
+			_bytes()+_committed,
+			new_committed-_committed,
+			PROT_READ | PROT_WRITE
+		) != 0) throw std::bad_alloc();
+
+		_committed = new_committed;
+	}
+
+	void _decommit(std::size_t bytes)
+	{
+		std::size_t new_committed = _round_up(bytes);
+		if(new_committed >= _committed) return;
+
+		// give the pages back to the system and make the range
+		// inaccessible again, the address range stays reserved
+		::madvise(
+			_bytes()+new_committed,
+			_committed-new_committed,
+			MADV_DONTNEED
+		);
+		::mprotect(
+			_bytes()+new_committed,
+			_committed-new_committed,
+			PROT_NONE
+		);
+		_committed = new_committed;
+	}
+
+	void _grow(void)
+	{
+		if((_size+1)*sizeof(T) > _committed)
+		{
+			_commit((_size+1)*sizeof(T));
+		}
+	}
+public:
+	typedef T value_type;
+	typedef T& reference;
+	typedef const T& const_reference;
+	typedef T* iterator;
+	typedef const T* const_iterator;
+	typedef std::size_t size_type;
+
+	mapped_vector(void)
+	 : _mapping(nullptr)
+	 , _mapping_size(0)
+	 , _data(nullptr)
+	 , _size(0)
+	 , _committed(0)
+	 , _reserved(0)
+	{
+		const std::size_t g = _granularity();
+		_reserved = _round_up(Options::reserved_bytes());
+		// reserve one extra chunk, so that the start can be aligned
+		_mapping_size = _reserved+g;
+
+		// the reserved range is not accessible and is not accounted
+		// as committed memory until it is committed chunk by chunk
+		_mapping = ::mmap(
+			nullptr,
+			_mapping_size,
+			PROT_NONE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+			-1, 0
+		);
+		if(_mapping == MAP_FAILED)
+		{
+			_mapping = nullptr;
+			throw std::bad_alloc();
+		}
+		std::uintptr_t addr = reinterpret_cast<std::uintptr_t>(_mapping);
+		addr = ((addr+g-1)/g)*g;
+		_data = reinterpret_cast<T*>(addr);
+
+#ifdef MADV_HUGEPAGE
+		if(Options::huge_pages())
+		{
+			// this is only advice, if transparent huge pages
+			// are not available the normal pages are used
+			::madvise(_bytes(), _reserved, MADV_HUGEPAGE);
+		}
+#endif
+	}
+
+	mapped_vector(const mapped_vector&) = delete;
+	mapped_vector& operator = (const mapped_vector&) = delete;
+
+	~mapped_vector(void)
+	{
+		clear();
+		if(_mapping != nullptr)
+		{
+			::munmap(_mapping, _mapping_size);
+		}
+	}
+
+	std::size_t size(void) const
+	{
+		return _size;
+	}
+
+	bool empty(void) const
+	{
+		return _size == 0;
+	}
+
+	std::size_t capacity(void) const
+	{
+		return _committed/sizeof(T);
+	}
+
+	std::size_t max_size(void) const
+	{
+		return _reserved/sizeof(T);
+	}
+
+	T* data(void)
+	{
+		return _data;
+	}
+
+	const T* data(void) const
+	{
+		return _data;
+	}
+
+	iterator begin(void)
+	{
+		return _data;
+	}
+
+	iterator end(void)
+	{
+		return _data+_size;
+	}
+
+	const_iterator begin(void) const
+	{
+		return _data;
+	}
+
+	const_iterator end(void) const
+	{
+		return _data+_size;
+	}
+
+	T& operator [] (std::size_t i)
+	{
+		assert(i < _size);
+		return _data[i];
+	}
+
+	const T& operator [] (std::size_t i) const
+	{
+		assert(i < _size);
+		return _data[i];
+	}
+
+	T& at(std::size_t i)
+	{
+		if(i >= _size)
+		{
+			throw std::out_of_range("exces::mapped_vector::at");
+		}
+		return _data[i];
+	}
+
+	const T& at(std::size_t i) const
+	{
+		if(i >= _size)
+		{
+			throw std::out_of_range("exces::mapped_vector::at");
+		}
+		return _data[i];
+	}
+
+	void reserve(std::size_t n)
+	{
+		_commit(n*sizeof(T));
+	}
+
+	void push_back(T&& value)
+	{
+		_grow();
+		::new(static_cast<void*>(_data+_size)) T(std::move(value));
+		++_size;
+	}
+
+	void push_back(const T& value)
+	{
+		_grow();
+		::new(static_cast<void*>(_data+_size)) T(value);
+		++_size;
+	}
+
+	void pop_back(void)
+	{
+		assert(_size != 0);
+		_data[--_size].~T();
+	}
+
+	iterator erase(iterator first, iterator last)
+	{
+		assert((begin() <= first) && (first <= last) && (last <= end()));
+		iterator result = std::move(last, end(), first);
+		for(iterator i=result; i!=end(); ++i)
+		{
+			i->~T();
+		}
+		_size -= std::size_t(last-first);
+		return first;
+	}
+
+	void clear(void)
+	{
+		erase(begin(), end());
+	}
+
+	// returns the committed pages that are not used back to the system
+	void shrink_to_fit(void)
+	{
+		_decommit(_size*sizeof(T));
+	}
+};
+
+// selects mapped_vector as the container of component_entry_vector
+template <typename Options>
+struct mapped_vector_sel
+{
+	template <typename T>
+	struct apply
+	{
+		typedef mapped_vector<T, Options> type;
+	};
+};
+
+#else // !EXCES_USE_MMAP
+
+// without mmap the mapped storage falls back to std::vector
+template <typename Options>
+struct mapped_vector_sel
+ : std_vector_sel
+{ };
+
+#endif
+
+} // namespace detail
+} // namespace exces
+
+#endif //include guard
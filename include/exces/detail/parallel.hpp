@@ -0,0 +1,135 @@
+/**
+ *  @file exces/detail/parallel.hpp
+ *  @brief Helpers for executing chunked work on multiple threads
+ *
+ *  Copyright 2012-2014 Matus Chochlik. Distributed under the Boost
+ *  Software License, Version 1.0. (See accompanying file
+ *  LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef EXCES_AUX_PARALLEL_1405121932_HPP
+#define EXCES_AUX_PARALLEL_1405121932_HPP
+
+#include <thread>
+#include <vector>
+#include <exception>
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+
+namespace exces {
+namespace detail {
+
+// the minimal number of elements processed by a single thread
+inline std::size_t parallel_min_chunk(void)
+{
+	return 4096;
+}
+
+// returns the number of chunks that a range of size n should be split to
+inline std::size_t parallel_chunk_count(
+	std::size_t n,
+	std::size_t max_threads,
+	std::size_t min_chunk
+)
+{
+	if(max_threads == 0)
+	{
+		max_threads = std::thread::hardware_concurrency();
+		if(max_threads == 0) max_threads = 1;
+	}
+	if(min_chunk == 0) min_chunk = 1;
+	std::size_t chunks = n / min_chunk;
+	if(chunks > max_threads) chunks = max_threads;
+	if(chunks == 0) chunks = 1;
+	return chunks;
+}
+
+// calls func(chunk_index, begin, end) for each of the chunks splitting
+// the range [0, n) in parallel, the first chunk is processed
+// by the calling thread
+template <typename Func>
+inline void parallel_chunks(std::size_t n, std::size_t chunks, Func& func)
+{
+	assert(chunks > 0);
+	if(chunks == 1)
+	{
+		func(std::size_t(0), std::size_t(0), n);
+		return;
+	}
+
+	const std::size_t step = (n + chunks - 1) / chunks;
+
+	std::vector<std::exception_ptr> errors(chunks);
+	std::vector<std::thread> threads;
+	threads.reserve(chunks-1);
+
+	for(std::size_t c=1; c!=chunks; ++c)
+	{
+		const std::size_t b = std::min(c*step, n);
+		const std::size_t e = std::min(b+step, n);
+		threads.push_back(std::thread(
+			[&func, &errors, c, b, e](void) -> void
+			{
+				try { func(c, b, e); }
+				catch(...) { errors[c] = std::current_exception(); }
+			}
+		));
+	}
+
+	try { func(std::size_t(0), std::size_t(0), std::min(step, n)); }
+	catch(...) { errors[0] = std::current_exception(); }
+
+	for(auto& thread : threads)
+	{
+		thread.join();
+	}
+	for(auto& error : errors)
+	{
+		if(error) std::rethrow_exception(error);
+	}
+}
+
+// partial result of a reduction, that may not have a value yet.
+// The chunks accumulate into local values and store them only once
+// at the end, so the workers do not share cache lines while reducing
+template <typename T>
+struct partial_result
+{
+	T value;
+	bool valid;
+
+	partial_result(void)
+	 : value()
+	 , valid(false)
+	{ }
+
+	void set(T&& v)
+	{
+		value = std::move(v);
+		valid = true;
+	}
+};
+
+// combines the initial value with the partial results of the chunks
+template <typename T, typename Combine>
+inline T combine_partials(
+	T init,
+	std::vector<partial_result<T>>& partials,
+	Combine& combine
+)
+{
+	for(auto& partial : partials)
+	{
+		if(partial.valid)
+		{
+			init = combine(std::move(init), std::move(partial.value));
+		}
+	}
+	return init;
+}
+
+} // namespace detail
+} // namespace exces
+
+#endif //include guard
@@ -13,28 +13,224 @@
 #include <boost/uuid/uuid.hpp>
 #include <boost/uuid/uuid_io.hpp>
 #include <boost/uuid/nil_generator.hpp>
-#include <boost/uuid/random_generator.hpp>
+
+#include <random>
+#include <atomic>
+#include <functional>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <pthread.h>
+#endif
 
 namespace exces {
 
+/// Entity using a Boost.UUID as identifier
+/** Default constructed entities get random (version 4) UUIDs generated
+ *  by a per-thread pseudo-random engine, which is seeded from the system
+ *  entropy source once per thread and again in the child after fork().
+ *  The UUIDs are compared and hashed as two 64-bit words.
+ *
+ *  @note The engine is a Mersenne twister, its output can be predicted
+ *  after observing a few hundred generated UUIDs. The UUIDs are unique
+ *  but not unguessable and must not be used as secrets or tokens.
+ */
 struct boost_uuid_entity
  : ::boost::uuids::uuid
 {
+private:
+	static std::mt19937_64 _make_engine(void)
+	{
+		std::random_device rd;
+		std::seed_seq seq = {
+			rd(), rd(), rd(), rd(),
+			rd(), rd(), rd(), rd()
+		};
+		return std::mt19937_64(seq);
+	}
+
+	// incremented in the child process after each fork()
+	static std::atomic<unsigned>& _fork_count(void)
+	{
+		static std::atomic<unsigned> count(0);
+		return count;
+	}
+
+	static void _after_fork_in_child(void)
+	{
+		_fork_count().fetch_add(1, std::memory_order_relaxed);
+	}
+
+	static unsigned _current_fork_count(void)
+	{
+#if defined(__unix__) || defined(__APPLE__)
+		static const int registered =
+			::pthread_atfork(nullptr, nullptr, &_after_fork_in_child);
+		(void)registered;
+#endif
+		return _fork_count().load(std::memory_order_relaxed);
+	}
+
+	struct _thread_engine
+	{
+		std::mt19937_64 engine;
+		unsigned fork_count;
+	};
+
+	// the child process inherits the state of the forking thread's engine,
+	// it is reseeded so that the parent and child generate different UUIDs
+	static std::mt19937_64& _engine(void)
+	{
+		static thread_local _thread_engine te = {
+			_make_engine(),
+			_current_fork_count()
+		};
+		const unsigned fork_count = _current_fork_count();
+		if(te.fork_count != fork_count)
+		{
+			te.engine = _make_engine();
+			te.fork_count = fork_count;
+		}
+		return te.engine;
+	}
+
+	static ::boost::uuids::uuid _generate(void)
+	{
+		std::mt19937_64& engine = _engine();
+		const std::uint64_t words[2] = { engine(), engine() };
+
+		::boost::uuids::uuid result;
+		static_assert(sizeof(result.data) == sizeof(words), "");
+		std::memcpy(result.data, words, sizeof(words));
+		// version 4 (random) and the RFC 4122 variant
+		result.data[6] = std::uint8_t((result.data[6] & 0x0F) | 0x40);
+		result.data[8] = std::uint8_t((result.data[8] & 0x3F) | 0x80);
+		return result;
+	}
+
+	// the i-th word of the UUID in native byte order
+	std::uint64_t _word(std::size_t i) const
+	{
+		std::uint64_t result;
+		std::memcpy(&result, data+i*8, 8);
+		return result;
+	}
+
+	// the i-th word of the UUID in big endian byte order, comparing
+	// these gives the same ordering as comparing the bytes
+	std::uint64_t _be_word(std::size_t i) const
+	{
+		std::uint64_t result = 0;
+		for(std::size_t b=0; b!=8; ++b)
+		{
+			result = (result << 8) | data[i*8+b];
+		}
+		return result;
+	}
+
+	static int _compare(
+		const boost_uuid_entity& e1,
+		const boost_uuid_entity& e2
+	)
+	{
+		const std::uint64_t h1 = e1._be_word(0), h2 = e2._be_word(0);
+		if(h1 != h2) return (h1 < h2)?-1:1;
+		const std::uint64_t l1 = e1._be_word(1), l2 = e2._be_word(1);
+		if(l1 != l2) return (l1 < l2)?-1:1;
+		return 0;
+	}
+public:
 	explicit boost_uuid_entity(::boost::uuids::uuid&& init)
 	 : ::boost::uuids::uuid(std::move(init))
 	{ }
 
 	boost_uuid_entity(void)
-	 : ::boost::uuids::uuid(::boost::uuids::random_generator()())
+	 : ::boost::uuids::uuid(_generate())
 	{ }
 
 	static boost_uuid_entity nil(void)
 	{
 		return boost_uuid_entity(::boost::uuids::nil_generator()());
 	}
+
+	/// Returns a hash of the UUID
+	std::size_t hash(void) const
+	{
+		// the random UUIDs are uniformly distributed,
+		// so folding the words is sufficient
+		return std::size_t(_word(0) ^ _word(1));
+	}
+
+	friend std::size_t hash_value(const boost_uuid_entity& e)
+	{
+		return e.hash();
+	}
+
+	friend bool operator == (
+		const boost_uuid_entity& e1,
+		const boost_uuid_entity& e2
+	)
+	{
+		return (e1._word(0) == e2._word(0)) && (e1._word(1) == e2._word(1));
+	}
+
+	friend bool operator != (
+		const boost_uuid_entity& e1,
+		const boost_uuid_entity& e2
+	)
+	{
+		return !(e1 == e2);
+	}
+
+	friend bool operator <  (
+		const boost_uuid_entity& e1,
+		const boost_uuid_entity& e2
+	)
+	{
+		return _compare(e1, e2) <  0;
+	}
+
+	friend bool operator <= (
+		const boost_uuid_entity& e1,
+		const boost_uuid_entity& e2
+	)
+	{
+		return _compare(e1, e2) <= 0;
+	}
+
+	friend bool operator >  (
+		const boost_uuid_entity& e1,
+		const boost_uuid_entity& e2
+	)
+	{
+		return _compare(e1, e2) >  0;
+	}
+
+	friend bool operator >= (
+		const boost_uuid_entity& e1,
+		const boost_uuid_entity& e2
+	)
+	{
+		return _compare(e1, e2) >= 0;
+	}
 };
 
 } // namespace exces
 
+namespace std {
+
+template <>
+struct hash< ::exces::boost_uuid_entity>
+{
+	std::size_t operator()(const ::exces::boost_uuid_entity& e) const
+	{
+		return e.hash();
+	}
+};
+
+} // namespace std
+
 #endif //include guard
 
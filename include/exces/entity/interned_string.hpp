@@ -0,0 +1,249 @@
+/**
+ *  @file exces/entity/interned_string.hpp
+ *  @brief Implementation of Entity using interned strings as identifiers
+ *
+ *  Copyright 2012-2014 Matus Chochlik. Distributed under the Boost
+ *  Software License, Version 1.0. (See accompanying file
+ *  LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef EXCES_ENTITY_INTERNED_STRING_1405261015_HPP
+#define EXCES_ENTITY_INTERNED_STRING_1405261015_HPP
+
+#include <exces/snapshot.hpp>
+
+#include <string>
+#include <deque>
+#include <unordered_map>
+#include <functional>
+#include <mutex>
+#include <cstdint>
+#include <cassert>
+#include <iostream>
+
+namespace exces {
+namespace detail {
+
+// global table of interned strings. Each distinct string is stored once
+// and gets a sequential index, the entries are never removed and their
+// addresses remain stable
+class string_intern_table
+{
+public:
+	struct entry
+	{
+		std::string str;
+		std::size_t index;
+		std::size_t hash;
+	};
+private:
+	std::mutex _mutex;
+	std::deque<entry> _entries;
+	std::unordered_map<std::string, const entry*> _lookup;
+
+	string_intern_table(void)
+	{
+		// the empty string used by the nil entity has index zero
+		intern(std::string());
+	}
+public:
+	static string_intern_table& instance(void)
+	{
+		static string_intern_table table;
+		return table;
+	}
+
+	const entry& intern(std::string&& str)
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		auto pos = _lookup.find(str);
+		if(pos != _lookup.end()) return *pos->second;
+
+		entry e = { str, _entries.size(), std::hash<std::string>()(str) };
+		_entries.push_back(std::move(e));
+		const entry& result = _entries.back();
+		_lookup.insert(std::make_pair(std::move(str), &result));
+		return result;
+	}
+
+	std::size_t size(void)
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _entries.size();
+	}
+};
+
+} // namespace detail
+
+/// Entity using an interned string as identifier
+/** The strings are interned in a global table, which is locked only when
+ *  an entity is constructed from a string. The entities keep the index
+ *  of the string in the table and its hash, so copying, comparing and
+ *  hashing them does not touch the string. The ordering of the entities
+ *  is the order in which their strings were first interned, not the
+ *  lexicographical order of the strings.
+ *  The interned strings are never released.
+ */
+class interned_string_entity
+{
+private:
+	typedef detail::string_intern_table::entry _entry;
+
+	const _entry* _pentry;
+	std::size_t _index;
+	std::size_t _hash;
+
+	interned_string_entity(const _entry& entry)
+	 : _pentry(&entry)
+	 , _index(entry.index)
+	 , _hash(entry.hash)
+	{ }
+
+	static const _entry& _intern(std::string&& str)
+	{
+		return detail::string_intern_table::instance()
+			.intern(std::move(str));
+	}
+public:
+	interned_string_entity(std::string&& id)
+	 : interned_string_entity(_intern(std::move(id)))
+	{ }
+
+	interned_string_entity(const std::string& id)
+	 : interned_string_entity(_intern(std::string(id)))
+	{ }
+
+	interned_string_entity(const char* id)
+	 : interned_string_entity(_intern(std::string(id)))
+	{ }
+
+	static interned_string_entity nil(void)
+	{
+		return interned_string_entity(std::string());
+	}
+
+	/// Returns the string identifying the entity
+	const std::string& str(void) const
+	{
+		assert(_pentry);
+		return _pentry->str;
+	}
+
+	/// Returns the index of the string in the intern table
+	std::size_t index(void) const
+	{
+		return _index;
+	}
+
+	/// Returns the hash of the string identifying the entity
+	std::size_t hash(void) const
+	{
+		return _hash;
+	}
+
+	friend std::size_t hash_value(const interned_string_entity& e)
+	{
+		return e._hash;
+	}
+
+	friend bool operator == (
+		const interned_string_entity& e1,
+		const interned_string_entity& e2
+	)
+	{
+		return e1._index == e2._index;
+	}
+
+	friend bool operator != (
+		const interned_string_entity& e1,
+		const interned_string_entity& e2
+	)
+	{
+		return e1._index != e2._index;
+	}
+
+	friend bool operator <  (
+		const interned_string_entity& e1,
+		const interned_string_entity& e2
+	)
+	{
+		return e1._index <  e2._index;
+	}
+
+	friend bool operator <= (
+		const interned_string_entity& e1,
+		const interned_string_entity& e2
+	)
+	{
+		return e1._index <= e2._index;
+	}
+
+	friend bool operator >  (
+		const interned_string_entity& e1,
+		const interned_string_entity& e2
+	)
+	{
+		return e1._index >  e2._index;
+	}
+
+	friend bool operator >= (
+		const interned_string_entity& e1,
+		const interned_string_entity& e2
+	)
+	{
+		return e1._index >= e2._index;
+	}
+
+	friend std::ostream& operator << (
+		std::ostream& out,
+		const interned_string_entity& e
+	)
+	{
+		out << "{" << e.str() << "}";
+		return out;
+	}
+};
+
+// the entity is trivially copyable but it must be saved as the string,
+// the index is valid only in the intern table of the current process
+template <>
+struct snapshot_serializer<interned_string_entity, true>
+{
+	static void write(std::ostream& output, const interned_string_entity& e)
+	{
+		const std::string& id = e.str();
+		std::uint64_t size = id.size();
+		output.write(reinterpret_cast<const char*>(&size), sizeof(size));
+		output.write(id.data(), std::streamsize(id.size()));
+	}
+
+	static interned_string_entity read(std::istream& input)
+	{
+		std::uint64_t size = 0;
+		input.read(reinterpret_cast<char*>(&size), sizeof(size));
+		std::string id;
+		if(input.good())
+		{
+			id.resize(std::size_t(size));
+			input.read(&id[0], std::streamsize(id.size()));
+		}
+		return interned_string_entity(std::move(id));
+	}
+};
+
+} // namespace exces
+
+namespace std {
+
+template <>
+struct hash< ::exces::interned_string_entity>
+{
+	std::size_t operator()(const ::exces::interned_string_entity& e) const
+	{
+		return e.hash();
+	}
+};
+
+} // namespace std
+
+#endif //include guard
@@ -10,7 +10,10 @@
 #ifndef EXCES_ENTITY_STRING_1212101511_HPP
 #define EXCES_ENTITY_STRING_1212101511_HPP
 
+#include <exces/snapshot.hpp>
+
 #include <string>
+#include <cstdint>
 #include <cassert>
 #include <iostream>
 
@@ -20,6 +23,8 @@ class string_entity
 {
 private:
 	std::string _id;
+
+	friend struct snapshot_serializer<string_entity, false>;
 public:
 	string_entity(std::string&& id)
 	 : _id(std::move(id))
@@ -67,6 +72,30 @@ public:
 	}
 };
 
+template <>
+struct snapshot_serializer<string_entity, false>
+{
+	static void write(std::ostream& output, const string_entity& e)
+	{
+		std::uint64_t size = e._id.size();
+		output.write(reinterpret_cast<const char*>(&size), sizeof(size));
+		output.write(e._id.data(), std::streamsize(e._id.size()));
+	}
+
+	static string_entity read(std::istream& input)
+	{
+		std::uint64_t size = 0;
+		input.read(reinterpret_cast<char*>(&size), sizeof(size));
+		std::string id;
+		if(input.good())
+		{
+			id.resize(std::size_t(size));
+			input.read(&id[0], std::streamsize(id.size()));
+		}
+		return string_entity(std::move(id));
+	}
+};
+
 } // namespace exces
 
 #endif //include guard
@@ -10,23 +10,104 @@
 #ifndef EXCES_ENTITY_UINTMAX_1212101511_HPP
 #define EXCES_ENTITY_UINTMAX_1212101511_HPP
 
+#include <exces/snapshot.hpp>
+
+#include <atomic>
 #include <cstdint>
 #include <cassert>
 #include <iostream>
 
 namespace exces {
 
+/// Entity using an unsigned integer as identifier
+/** Default constructed entities get unique identifiers, which the threads
+ *  reserve from a global counter in blocks, so entities can be created
+ *  concurrently from multiple threads without contending on the counter.
+ *  The identifiers generated by a single thread are increasing.
+ */
 class uintmax_entity
 {
 private:
 	uintmax_t _id;
 
+	// the number of ids a thread takes from the global counter at once
+	static const uintmax_t _block_size = 4096;
+
+	// the first id not yet handed out to any thread
+	static std::atomic<uintmax_t>& _next_id(void)
+	{
+		static std::atomic<uintmax_t> id(1);
+		return id;
+	}
+
+	// incremented whenever the handed out blocks become invalid
+	static std::atomic<unsigned>& _epoch(void)
+	{
+		static std::atomic<unsigned> epoch(0);
+		return epoch;
+	}
+
+	// the value of the counter when the epoch last changed, the blocks
+	// reserved in the current epoch do not contain ids below it
+	static std::atomic<uintmax_t>& _epoch_start(void)
+	{
+		static std::atomic<uintmax_t> start(0);
+		return start;
+	}
+
+	struct _id_block
+	{
+		uintmax_t next, end;
+		unsigned epoch;
+	};
+
+	// the block of ids reserved by the calling thread
+	static _id_block& _thread_block(void)
+	{
+		static thread_local _id_block block = { 0, 0, 0 };
+		return block;
+	}
+
+	// the ids are generated from per-thread blocks so that the threads
+	// touch the shared counter only once per _block_size entities
 	static uintmax_t _gen_id(void)
 	{
-		static uintmax_t id = 0;
-		assert(id != UINTMAX_MAX);
-		return ++id;
+		_id_block& block = _thread_block();
+		const unsigned epoch = _epoch().load(std::memory_order_acquire);
+		if((block.next == block.end) || (block.epoch != epoch))
+		{
+			block.next = _next_id().fetch_add(
+				_block_size,
+				std::memory_order_relaxed
+			);
+			assert(block.next <= UINTMAX_MAX-_block_size);
+			block.end = block.next+_block_size;
+			block.epoch = epoch;
+		}
+		return block.next++;
+	}
+
+	// makes sure that the generated ids are different from id
+	static void _skip_id(uintmax_t id)
+	{
+		// raise the counter so that the blocks reserved from now on
+		// follow id, the CAS is done only if the counter is not past id
+		std::atomic<uintmax_t>& next_id = _next_id();
+		uintmax_t next = next_id.load(std::memory_order_relaxed);
+		while(next <= id)
+		{
+			if(next_id.compare_exchange_weak(next, id+1)) return;
+		}
+		// the blocks reserved in the current epoch might contain id,
+		// they are invalidated only once, not for each loaded entity
+		if(id >= _epoch_start().load(std::memory_order_relaxed))
+		{
+			_epoch_start().store(next, std::memory_order_relaxed);
+			_epoch().fetch_add(1, std::memory_order_release);
+		}
 	}
+
+	friend struct snapshot_serializer<uintmax_entity, true>;
 public:
 	uintmax_entity(uintmax_t init)
 	 : _id(init)
@@ -78,6 +159,28 @@ public:
 	}
 };
 
+template <>
+struct snapshot_serializer<uintmax_entity, true>
+{
+	static void write(std::ostream& output, uintmax_entity e)
+	{
+		output.write(reinterpret_cast<const char*>(&e._id), sizeof(e._id));
+	}
+
+	// the loaded ids are skipped by the id generator so that the new
+	// entities do not collide with the loaded ones
+	static uintmax_entity read(std::istream& input)
+	{
+		uintmax_t id = 0;
+		input.read(reinterpret_cast<char*>(&id), sizeof(id));
+		uintmax_entity::_skip_id(id);
+		return uintmax_entity(id);
+	}
+
+	// write writes the bytes of the entity
+	static constexpr bool _raw = true;
+};
+
 } // namespace exces
 
 #endif //include guard
@@ -11,6 +11,9 @@
 #define EXCES_ENTITY_FILTERS_1212101457_HPP
 
 #include <exces/metaprog.hpp>
+#include <exces/detail/component.hpp>
+
+#include <type_traits>
 
 namespace exces {
 
@@ -36,6 +39,217 @@ struct entity_with
  : entity_with_seq<mp::typelist<Components...>>
 { };
 
+/// Query clause matching entities having all the Components
+/**
+ *  @see query
+ */
+template <typename ... Components>
+struct with { };
+
+/// Query clause matching entities having none of the Components
+/**
+ *  @see query
+ */
+template <typename ... Components>
+struct without { };
+
+/// Query clause matching entities having at least one of the Components
+/** A query can contain at most one any_of clause.
+ *
+ *  @see query
+ */
+template <typename ... Components>
+struct any_of { };
+
+/// Query clause documenting Components that the entities may have
+/** This clause does not affect which entities match the query.
+ *
+ *  @see query
+ */
+template <typename ... Components>
+struct optional { };
+
+namespace detail {
+
+// the bitset masks of a query. An entity matches if it has all the
+// required components, none of the excluded and (if any_of is not empty)
+// at least one of the any_of components
+template <typename Group>
+struct query_masks
+{
+	component_bitset<Group> require;
+	// the required or the excluded components
+	component_bitset<Group> mask;
+	component_bitset<Group> any_of;
+	bool no_any_of;
+
+	bool matches(const component_bitset<Group>& bits) const
+	{
+		return	bits.matches(mask, require) &
+			(no_any_of | bits.intersects(any_of));
+	}
+};
+
+// sets the bits of the components in a typelist in two bitsets
+template <typename Group, typename Sequence>
+struct query_set_bits;
+
+template <typename Group, typename ... C>
+struct query_set_bits<Group, mp::typelist<C...>>
+{
+	static void apply(
+		component_bitset<Group>& bits,
+		component_bitset<Group>& dst
+	)
+	{
+		const std::size_t ids[] = {
+			component_id<
+				typename std::remove_cv<
+					typename std::remove_reference<C>::type
+				>::type,
+				Group
+			>::value...,
+			0
+		};
+		for(std::size_t i=0; i!=sizeof ... (C); ++i)
+		{
+			bits.set(ids[i]);
+			dst.set(ids[i]);
+		}
+	}
+};
+
+// updates the masks of a query with a single clause
+template <typename Group, typename Clause>
+struct query_clause;
+
+template <typename Group, typename ... C>
+struct query_clause<Group, with<C...>>
+{
+	static void apply(query_masks<Group>& masks)
+	{
+		query_set_bits<Group, mp::typelist<C...>>::apply(
+			masks.require,
+			masks.mask
+		);
+	}
+};
+
+template <typename Group, typename ... C>
+struct query_clause<Group, without<C...>>
+{
+	static void apply(query_masks<Group>& masks)
+	{
+		component_bitset<Group> excluded;
+		query_set_bits<Group, mp::typelist<C...>>::apply(
+			excluded,
+			masks.mask
+		);
+	}
+};
+
+template <typename Group, typename ... C>
+struct query_clause<Group, any_of<C...>>
+{
+	static void apply(query_masks<Group>& masks)
+	{
+		query_set_bits<Group, mp::typelist<C...>>::apply(
+			masks.any_of,
+			masks.any_of
+		);
+		masks.no_any_of = masks.any_of.none();
+	}
+};
+
+template <typename Group, typename ... C>
+struct query_clause<Group, optional<C...>>
+{
+	static void apply(query_masks<Group>&) { }
+};
+
+// counts the any_of clauses of a query
+template <typename ... Clauses>
+struct query_any_of_count
+ : std::integral_constant<std::size_t, 0>
+{ };
+
+template <typename Clause, typename ... Clauses>
+struct query_any_of_count<Clause, Clauses...>
+ : query_any_of_count<Clauses...>
+{ };
+
+template <typename ... C, typename ... Clauses>
+struct query_any_of_count<any_of<C...>, Clauses...>
+ : std::integral_constant<
+	std::size_t,
+	1+query_any_of_count<Clauses...>::value
+>{ };
+
+} // namespace detail
+
+/// Compile-time entity query composed of with, without, any_of, optional
+/** The clauses of the query are turned into precomputed bitset masks
+ *  which are tested against the components of an entity at once.
+ *  A query can be used as an entity predicate (for example with
+ *  manager::select or collection) and the manager's for_each and select
+ *  functions also accept it directly:
+ *
+ *  @code
+ *  typedef query<with<position, velocity>, without<frozen>> moving;
+ *
+ *  m.for_each(moving(), [](manager<>& m, manager<>::entity_key k)
+ *  {
+ *      ...
+ *      return true;
+ *  });
+ *  collection<> c(m, moving());
+ *  @endcode
+ *
+ *  @see with
+ *  @see without
+ *  @see any_of
+ *  @see optional
+ */
+template <typename ... Clauses>
+struct query
+{
+	// all any_of clauses would share a single mask
+	static_assert(
+		detail::query_any_of_count<Clauses...>::value <= 1,
+		"A query can contain at most one any_of clause"
+	);
+
+	/// Returns the precomputed masks of the query for the specified Group
+	template <typename Group>
+	static const detail::query_masks<Group>& masks(void)
+	{
+		static const detail::query_masks<Group> result = _make<Group>();
+		return result;
+	}
+
+	template <typename Group>
+	bool operator ()(
+		manager<Group>& m,
+		typename manager<Group>::entity_key key
+	) const
+	{
+		return m.matches_masks(key, masks<Group>());
+	}
+private:
+	template <typename Group>
+	static detail::query_masks<Group> _make(void)
+	{
+		detail::query_masks<Group> result;
+		result.no_any_of = true;
+		const int dummy[] = {
+			(detail::query_clause<Group, Clauses>::apply(result), 0)...,
+			0
+		};
+		(void)dummy;
+		return result;
+	}
+};
+
 } // namespace exces
 
 #endif //include guard
@@ -11,7 +11,11 @@
 #define EXCES_ENTITY_KEY_SET_1212101511_HPP
 
 #include <exces/entity.hpp>
+#include <exces/cursor.hpp>
+#include <exces/memory_stats.hpp>
 #include <algorithm>
+#include <type_traits>
+#include <unordered_map>
 #include <vector>
 
 namespace exces {
@@ -19,8 +23,14 @@ namespace exces {
 template <typename Group>
 class manager;
 
-// Log(n) insert/removal set of unique entity keys
-template <typename Group>
+/// Ordered set of unique entity keys
+/** The keys are kept sorted by the entity. Lookup is O(log n), insertion
+ *  and removal are O(n) because the underlying vector must be shifted.
+ *  This is the default key set used by collections and classifications.
+ *
+ *  @see unordered_entity_key_set
+ */
+template <typename Group = default_group>
 class entity_key_set
 {
 private:
@@ -31,6 +41,13 @@ private:
 	{
 		return a->first < b->first;
 	}
+
+	typedef typename manager<Group>::entity_type entity_type;
+
+	static bool _e_ek_less(const entity_type& a, entity_key b)
+	{
+		return a < b->first;
+	}
 public:
 	entity_key_set(void) = default;
 	entity_key_set(entity_key_set&&) = default;
@@ -43,6 +60,20 @@ public:
 		return _keys.size();
 	}
 
+	/// Returns the number of bytes allocated by this set
+	std::size_t memory_bytes(void) const
+	{
+		return _keys.capacity()*sizeof(entity_key);
+	}
+
+	/// Releases the unused capacity, returns the number of bytes reclaimed
+	std::size_t shrink_to_fit(void)
+	{
+		const std::size_t before = memory_bytes();
+		_keys.shrink_to_fit();
+		return before-memory_bytes();
+	}
+
 	bool contains(entity_key key)
 	{
 		auto p = std::lower_bound(
@@ -94,6 +125,137 @@ public:
 	{
 		return _keys.end();
 	}
+
+	/// Returns the position where a traversal with cursor should resume
+	const_iterator resume_point(const entity_cursor<Group>& cursor) const
+	{
+		if(cursor.at_start())
+		{
+			return _keys.begin();
+		}
+		return std::upper_bound(
+			_keys.begin(),
+			_keys.end(),
+			cursor.last(),
+			_e_ek_less
+		);
+	}
+};
+
+/// Unordered set of unique entity keys
+/** The keys are stored in a dense vector in no particular order
+ *  and an index maps each key to its position in the vector.
+ *  Lookup, insertion and removal are O(1) on average, removal moves
+ *  the last key into the position of the erased one.
+ *  This key set can be used by collections and classifications
+ *  with many members which change frequently and which do not need
+ *  to be traversed in the order of the entities. Resumable traversal
+ *  with entity_cursor is not supported.
+ *
+ *  @see entity_key_set
+ */
+template <typename Group = default_group>
+class unordered_entity_key_set
+{
+private:
+	typedef typename manager<Group>::entity_key entity_key;
+	std::vector<entity_key> _keys;
+
+	// the address of the entity info is unique for each key
+	typedef const void* _key_id;
+	std::unordered_map<_key_id, std::size_t> _index;
+
+	static _key_id _id_of(entity_key key)
+	{
+		return static_cast<_key_id>(&*key);
+	}
+public:
+	unordered_entity_key_set(void) = default;
+	unordered_entity_key_set(unordered_entity_key_set&&) = default;
+	unordered_entity_key_set(entity_key key)
+	 : _keys(1, key)
+	{
+		_index[_id_of(key)] = 0;
+	}
+
+	std::size_t size(void) const
+	{
+		return _keys.size();
+	}
+
+	/// Returns the (estimated) number of bytes allocated by this set
+	std::size_t memory_bytes(void) const
+	{
+		return	_keys.capacity()*sizeof(entity_key)+
+			detail::unordered_map_bytes(_index);
+	}
+
+	/// Releases the unused capacity, returns the number of bytes reclaimed
+	std::size_t shrink_to_fit(void)
+	{
+		const std::size_t before = memory_bytes();
+		_keys.shrink_to_fit();
+		// use the smallest bucket count suitable for the current size
+		_index.rehash(0);
+		const std::size_t after = memory_bytes();
+		return (before > after)?before-after:0;
+	}
+
+	bool contains(entity_key key)
+	{
+		return _index.find(_id_of(key)) != _index.end();
+	}
+
+	void insert(entity_key key)
+	{
+		auto r = _index.insert(std::make_pair(_id_of(key), _keys.size()));
+		if(r.second)
+		{
+			_keys.push_back(key);
+		}
+	}
+
+	void erase(entity_key key)
+	{
+		auto p = _index.find(_id_of(key));
+		if(p != _index.end())
+		{
+			const std::size_t pos = p->second;
+			_index.erase(p);
+			if(pos+1 != _keys.size())
+			{
+				_keys[pos] = _keys.back();
+				_index[_id_of(_keys[pos])] = pos;
+			}
+			_keys.pop_back();
+		}
+	}
+
+	typedef typename std::vector<entity_key>::const_iterator
+		const_iterator;
+
+	const_iterator begin(void) const
+	{
+		return _keys.begin();
+	}
+
+	const_iterator end(void) const
+	{
+		return _keys.end();
+	}
+
+	// erase moves the last key into the place of the erased one,
+	// so there is no position where a traversal could safely resume
+	template <typename G = Group>
+	const_iterator resume_point(const entity_cursor<G>&) const
+	{
+		static_assert(
+			!std::is_same<G, Group>::value,
+			"Resumable traversal with entity_cursor is not supported "
+			"by collections with unordered_entity_key_set"
+		);
+		return _keys.end();
+	}
 };
 
 } // namespace exces
@@ -12,6 +12,7 @@
 
 #include <exces/entity.hpp>
 #include <exces/component.hpp>
+#include <exces/entity_filters.hpp>
 
 #include <functional>
 
@@ -36,8 +37,14 @@ private:
 	typedef std::function<bool (manager<Group>&, entity_key)> _pred_t;
 	_pred_t _pred;
 
+	const detail::query_masks<Group>* _masks;
+
 	bool _satisfies(void) const
 	{
+		if(_masks)
+		{
+			return _manager.matches_masks(BaseRange::front(), *_masks);
+		}
 		if(_pred)
 		{
 			return _pred(_manager, BaseRange::front());
@@ -62,6 +69,20 @@ public:
 	 , _lock(std::move(lock))
 	 , _manager(man)
 	 , _pred(pred)
+	 , _masks(nullptr)
+	{
+		_skip();
+	}
+
+	entity_range_tpl(
+		_lock_t&& lock,
+		manager<Group>& man,
+		const BaseRange& base,
+		const detail::query_masks<Group>& masks
+	): BaseRange(base)
+	 , _lock(std::move(lock))
+	 , _manager(man)
+	 , _masks(&masks)
 	{
 		_skip();
 	}
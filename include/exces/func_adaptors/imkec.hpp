@@ -7,8 +7,8 @@
  *  LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
  */
 
-#ifndef EXCES_FUNC_ADAPTORS_IMKC_1404292124_HPP
-#define EXCES_FUNC_ADAPTORS_IMKC_1404292124_HPP
+#ifndef EXCES_FUNC_ADAPTORS_IMKEC_1404292124_HPP
+#define EXCES_FUNC_ADAPTORS_IMKEC_1404292124_HPP
 
 #include <exces/fwd.hpp>
 #include <functional>
@@ -47,11 +47,12 @@ struct func_adaptor_imkec
 	{
 		if(m.template has_all<Components...>(k))
 		{
-			_functor(
+			if(!_functor(
 				ii, m, k, m.get_entity(k),
 				m.template raw_access<Components>(k)...
-			);
+			)) return false;
 		}
+		return true;
 	}
 };
 
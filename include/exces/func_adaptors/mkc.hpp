@@ -47,11 +47,12 @@ struct func_adaptor_mkc
 	{
 		if(m.template has_all<Components...>(k))
 		{
-			_functor(
+			if(!_functor(
 				m, k,
 				m.template raw_access<Components>(k)...
-			);
+			)) return false;
 		}
+		return true;
 	}
 };
 
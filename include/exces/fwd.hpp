@@ -41,6 +41,10 @@ struct component_kind_flyweight
 {
 	typedef component_kind_flyweight type;
 };
+struct component_kind_mapped
+{
+	typedef component_kind_mapped type;
+};
  
 struct component_access_read_only
 {
@@ -11,6 +11,7 @@
 #define EXCES_GROUP_1212101431_HPP
 
 #include <exces/detail/global_list.hpp>
+#include <exces/detail/component_names.hpp>
 #include <exces/fwd.hpp>
 
 #include <type_traits>
@@ -105,6 +106,28 @@ EXCES_ADD_TO_GLOBAL_LIST(EXCES_GROUP_SEL(GROUP), COMPONENT) \
 	{ }; \
 	EXCES_REG_COMPONENT_IN_GROUP_END(COMPONENT, GROUP)
 
+/// Registers a component stored in reserved virtual memory in the specified group
+/** The instances of mapped components are stored in a large range of virtual
+ *  memory reserved up-front, that is committed lazily as the storage grows,
+ *  so the instances are never relocated. The size of the range and the use
+ *  of transparent huge pages can be configured by specializing
+ *  component_mapping. This is intended for components with tens of millions
+ *  of instances. If mmap is not available (EXCES_USE_MMAP is zero)
+ *  the component is stored as a normal component.
+ *
+ *  @see #EXCES_REG_GROUP
+ *  @see #EXCES_REG_COMPONENT_IN_GROUP
+ *  @see #EXCES_REG_MAPPED_COMPONENT
+ */
+#define EXCES_REG_MAPPED_COMPONENT_IN_GROUP(COMPONENT, GROUP) \
+	EXCES_REG_COMPONENT_IN_GROUP_BEGIN(COMPONENT, GROUP) \
+	template <> struct component_kind<\
+		COMPONENT, \
+		EXCES_GROUP_SEL(GROUP) \
+	> : component_kind_mapped \
+	{ }; \
+	EXCES_REG_COMPONENT_IN_GROUP_END(COMPONENT, GROUP)
+
 /// Registers the specified component's name
 /** The component names are required for the type-erased any_manager
  *
@@ -147,6 +170,14 @@ struct component_name< COMPONENT > \
 #define EXCES_REG_FLYWEIGHT_COMPONENT(COMPONENT) \
 	EXCES_REG_FLYWEIGHT_COMPONENT_IN_GROUP(COMPONENT, default)
 
+/// Registers the specified mapped component in the default group
+/**
+ *  @see #EXCES_REG_MAPPED_COMPONENT_IN_GROUP
+ *  @see #EXCES_REG_COMPONENT
+ */
+#define EXCES_REG_MAPPED_COMPONENT(COMPONENT) \
+	EXCES_REG_MAPPED_COMPONENT_IN_GROUP(COMPONENT, default)
+
 /// Registers the specified component and also registers its name
 /**
  *  @see #EXCES_REG_COMPONENT
@@ -174,6 +205,15 @@ struct component_name< COMPONENT > \
 	EXCES_REG_COMPONENT_NAME(COMPONENT) \
 	EXCES_REG_FLYWEIGHT_COMPONENT(COMPONENT)
 
+/// Registers the specified mapped component and also registers its name
+/**
+ *  @see #EXCES_REG_MAPPED_COMPONENT
+ *  @see #EXCES_REG_COMPONENT_NAME
+ */
+#define EXCES_REG_NAMED_MAPPED_COMPONENT(COMPONENT) \
+	EXCES_REG_COMPONENT_NAME(COMPONENT) \
+	EXCES_REG_MAPPED_COMPONENT(COMPONENT)
+
 namespace exces {
 
 /// Metafunction returning the sequence of components in the specified group
@@ -189,41 +229,26 @@ struct component_index
 	// TODO: try some size optimizations here
 	typedef std::size_t type;
 
-	struct _by_name_hlp
+	/// Returns the id of the component with the specified name
+	/** The names are looked up in a perfect hash table built on the first
+	 *  call, all components in the Group must have registered names.
+	 *
+	 *  @return the component id or ~0 if the Group does not contain
+	 *  a component with the specified name.
+	 *
+	 *  @see #EXCES_REG_COMPONENT_NAME
+	 */
+	static type by_name(const char* name)
 	{
-		type& result;
-		const char* name;
-		std::size_t size;
-
-		_by_name_hlp(type& res, const char* cname)
-		 : result(res)
-		 , name(cname)
-		 , size(std::strlen(name))
-		{ }
-
-		template <typename C>
-		void operator ()(mp::identity<C>) const
-		{
-			if(size == component_name<C>::size())
-			{
-				if(std::strncmp(
-					name,
-					component_name<C>::c_str(),
-					component_name<C>::size()
-				) == 0)
-				{
-					result = component_id<C, Group>();
-				}
-			}
-		}
-	};
+		return by_name(name, std::strlen(name));
+	}
 
-	static type by_name(const char* name)
+	/// Returns the id of the component with the specified name
+	static type by_name(const char* name, std::size_t size)
 	{
-		type result = ~type(0);
-		_by_name_hlp hlp(result, name);
-		mp::for_each<typename components<Group>::type>(hlp);
-		return result;
+		return type(detail::component_name_table<Group>::instance()
+			.find(name, size)
+		);
 	}
 };
 
@@ -14,6 +14,12 @@
 
 namespace exces {
 
+/// Tag type selecting the installation of a process-wide implicit manager
+/**
+ *  @see implicit_manager
+ */
+struct implicit_global { };
+
 /// Installs/uninstalls an implicit manager for a component Group
 /** The basic manager and entity template classes are designed to be
  *  efficient and flexible. The entities do not store any references
@@ -44,6 +50,20 @@ namespace exces {
  *  e.remove<some_component>();
  *  @endcode
  *
+ *  Each thread has its own stack of implicit managers, so worker threads
+ *  can install their own (for example per-thread or per-shard) managers
+ *  and use implicit entities in parallel. The managers must be installed
+ *  and uninstalled by the same thread in LIFO order. A manager installed
+ *  with the implicit_global tag is used by the threads which have not
+ *  installed any manager themselves:
+ *
+ *  @code
+ *  manager<> the_manager;
+ *  implicit_manager<> install(the_manager, implicit_global());
+ *
+ *  std::thread worker([](void){ implicit_entity<> e; e.add(...); });
+ *  @endcode
+ *
  *  @see implicit_entity
  */
 template <typename Group = default_group>
@@ -51,16 +71,27 @@ class implicit_manager
 {
 private:
 	manager<Group>& _m;
+	manager<Group>* _prev;
+	bool _global;
 public:
 	static void _instantiate(void);
 
-	/// Installs the manager m as the current implicit manager
+	/// Installs the manager m as the implicit manager of the current thread
 	implicit_manager(manager<Group>& m);
 
+	/// Installs the manager m as the process-wide implicit manager
+	implicit_manager(manager<Group>& m, implicit_global);
+
+	implicit_manager(const implicit_manager&) = delete;
+
 	/// Uninstalls the manager installed in constructor
 	~implicit_manager(void);
 
 	/// Gets a reference to the current implicit manager
+	/** Returns the manager at the top of the calling thread's stack or
+	 *  the process-wide implicit manager if the thread did not install
+	 *  any manager.
+	 */
 	static manager<Group>& get(void);
 };
 
@@ -11,6 +11,7 @@
 #define EXCES_ITER_INFO_1212101457_HPP
 
 #include <cstddef>
+#include <cassert>
 
 namespace exces {
 
@@ -25,6 +26,14 @@ public:
 	 , _n(n)
 	{ }
 
+	// used when resuming an iteration at the i-th step
+	iter_info(std::size_t i, std::size_t n)
+	 : _i(i)
+	 , _n(n)
+	{
+		assert(_i <= _n);
+	}
+
 	// called inside for_each, etc.
 	void step(void)
 	{
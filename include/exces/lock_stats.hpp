@@ -0,0 +1,384 @@
+/**
+ *  @file exces/lock_stats.hpp
+ *  @brief Lock contention and hold-time instrumentation
+ *
+ *  Copyright 2012-2014 Matus Chochlik. Distributed under the Boost
+ *  Software License, Version 1.0. (See accompanying file
+ *  LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef EXCES_LOCK_STATS_1405151630_HPP
+#define EXCES_LOCK_STATS_1405151630_HPP
+
+#include <exces/config.hpp>
+#include <exces/threads.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <map>
+#include <string>
+#include <vector>
+#include <ostream>
+#include <cstdint>
+#include <cstddef>
+
+namespace exces {
+
+/// Snapshot of the statistics of the mutexes with a particular name
+/**
+ *  @see lock_stats
+ */
+struct lock_stats_record
+{
+	/// The number of buckets in the wait time histogram
+	static const std::size_t histogram_size = 32;
+
+	/// The name of the mutex
+	std::string name;
+
+	/// The number of exclusive lock acquisitions
+	std::uint64_t exclusive_locks;
+	/// The number of shared lock acquisitions
+	std::uint64_t shared_locks;
+	/// The number of acquisitions that had to wait for the mutex
+	std::uint64_t contended_locks;
+
+	/// Total time spent waiting for the mutex in nanoseconds
+	std::uint64_t total_wait_ns;
+	/// The longest wait for the mutex in nanoseconds
+	std::uint64_t max_wait_ns;
+
+	/// Total time the mutex was held exclusively in nanoseconds
+	std::uint64_t total_hold_ns;
+	/// The longest exclusive hold of the mutex in nanoseconds
+	std::uint64_t max_hold_ns;
+
+	/// Histogram of the wait times of contended acquisitions
+	/** The i-th bucket counts the waits that took less than 2^i
+	 *  nanoseconds (and at least 2^(i-1) nanoseconds), the last bucket
+	 *  counts also all longer waits.
+	 */
+	std::uint64_t wait_histogram[histogram_size];
+};
+
+/// Registry of statistics collected by instrumented mutexes
+/** The statistics are collected by the mutexes used by the
+ *  instrumented_component_locking policy and are aggregated by the name
+ *  of the mutex, i.e. the mutexes of all managers of the same group are
+ *  counted together. The registry is global and thread-safe.
+ *
+ *  If the EXCES_LOCK_STATS preprocessor symbol is defined to zero,
+ *  the instrumentation is compiled out and the registry stays empty.
+ *
+ *  @code
+ *  exces::lock_stats::dump(std::cout);
+ *  @endcode
+ *
+ *  @see instrumented_component_locking
+ */
+class lock_stats
+{
+public:
+	// implementation detail, do not use directly
+	struct _entry
+	{
+		std::atomic<std::uint64_t> exclusive_locks;
+		std::atomic<std::uint64_t> shared_locks;
+		std::atomic<std::uint64_t> contended_locks;
+		std::atomic<std::uint64_t> total_wait_ns;
+		std::atomic<std::uint64_t> max_wait_ns;
+		std::atomic<std::uint64_t> total_hold_ns;
+		std::atomic<std::uint64_t> max_hold_ns;
+		std::atomic<std::uint64_t> wait_histogram[
+			lock_stats_record::histogram_size
+		];
+
+		_entry(void)
+		{
+			reset();
+		}
+
+		void reset(void)
+		{
+			exclusive_locks = 0;
+			shared_locks = 0;
+			contended_locks = 0;
+			total_wait_ns = 0;
+			max_wait_ns = 0;
+			total_hold_ns = 0;
+			max_hold_ns = 0;
+			for(auto& bucket : wait_histogram)
+			{
+				bucket = 0;
+			}
+		}
+
+		static void _update_max(
+			std::atomic<std::uint64_t>& max,
+			std::uint64_t value
+		)
+		{
+			std::uint64_t prev = max.load();
+			while((prev < value) && !max.compare_exchange_weak(prev, value));
+		}
+
+		void record_wait(std::uint64_t ns)
+		{
+			++contended_locks;
+			total_wait_ns += ns;
+			_update_max(max_wait_ns, ns);
+
+			std::size_t bucket = 0;
+			while((ns != 0) && (bucket+1 < lock_stats_record::histogram_size))
+			{
+				ns >>= 1;
+				++bucket;
+			}
+			++wait_histogram[bucket];
+		}
+
+		void record_hold(std::uint64_t ns)
+		{
+			total_hold_ns += ns;
+			_update_max(max_hold_ns, ns);
+		}
+	};
+private:
+	typedef std::map<std::string, std::unique_ptr<_entry>> _entry_map;
+
+	static std::mutex& _mutex(void)
+	{
+		static std::mutex mutex;
+		return mutex;
+	}
+
+	static _entry_map& _entries(void)
+	{
+		static _entry_map entries;
+		return entries;
+	}
+public:
+	// implementation detail, do not use directly
+	static _entry& _get(const std::string& name)
+	{
+		std::lock_guard<std::mutex> lg(_mutex());
+		std::unique_ptr<_entry>& entry = _entries()[name];
+		if(!entry) entry.reset(new _entry());
+		return *entry;
+	}
+
+	/// Returns the statistics of all named mutexes ordered by name
+	static std::vector<lock_stats_record> snapshot(void)
+	{
+		std::lock_guard<std::mutex> lg(_mutex());
+		std::vector<lock_stats_record> result;
+		result.reserve(_entries().size());
+		for(auto& p : _entries())
+		{
+			const _entry& e = *p.second;
+			lock_stats_record r;
+			r.name = p.first;
+			r.exclusive_locks = e.exclusive_locks;
+			r.shared_locks = e.shared_locks;
+			r.contended_locks = e.contended_locks;
+			r.total_wait_ns = e.total_wait_ns;
+			r.max_wait_ns = e.max_wait_ns;
+			r.total_hold_ns = e.total_hold_ns;
+			r.max_hold_ns = e.max_hold_ns;
+			for(std::size_t i=0; i!=lock_stats_record::histogram_size; ++i)
+			{
+				r.wait_histogram[i] = e.wait_histogram[i];
+			}
+			result.push_back(std::move(r));
+		}
+		return result;
+	}
+
+	/// Resets the statistics of all named mutexes
+	static void reset(void)
+	{
+		std::lock_guard<std::mutex> lg(_mutex());
+		for(auto& p : _entries())
+		{
+			p.second->reset();
+		}
+	}
+
+	/// Writes a human-readable report of the statistics to @p out
+	static std::ostream& dump(std::ostream& out)
+	{
+		for(const lock_stats_record& r : snapshot())
+		{
+			out	<< r.name << ": "
+				<< "exclusive=" << r.exclusive_locks << ", "
+				<< "shared=" << r.shared_locks << ", "
+				<< "contended=" << r.contended_locks << ", "
+				<< "wait(total/max)=" << r.total_wait_ns << "/"
+				<< r.max_wait_ns << "ns, "
+				<< "hold(total/max)=" << r.total_hold_ns << "/"
+				<< r.max_hold_ns << "ns"
+				<< std::endl;
+
+			if(r.contended_locks == 0) continue;
+
+			out << "  wait histogram:";
+			for(std::size_t i=0; i!=lock_stats_record::histogram_size; ++i)
+			{
+				if(r.wait_histogram[i] == 0) continue;
+				out << " <2^" << i << "ns:" << r.wait_histogram[i];
+			}
+			out << std::endl;
+		}
+		return out;
+	}
+};
+
+/// Mutex wrapper recording statistics into the lock_stats registry
+/** The wrapper records the number of exclusive and shared acquisitions,
+ *  the times spent waiting for contended acquisitions and the times
+ *  the mutex was held exclusively. The hold times of shared locks are
+ *  not recorded.
+ *
+ *  @see lock_stats
+ *  @see instrumented_component_locking
+ */
+template <typename Mutex>
+class instrumented_mutex
+{
+private:
+	typedef std::chrono::steady_clock _clock;
+
+	Mutex _mutex;
+	lock_stats::_entry* _stats;
+	_clock::time_point _locked_at;
+
+	static std::uint64_t _ns_since(_clock::time_point start)
+	{
+		return std::uint64_t(
+			std::chrono::duration_cast<std::chrono::nanoseconds>(
+				_clock::now() - start
+			).count()
+		);
+	}
+public:
+	instrumented_mutex(void)
+	 : _stats(&lock_stats::_get("unnamed"))
+	{ }
+
+	instrumented_mutex(const instrumented_mutex&) = delete;
+
+	/// Sets the name under which the statistics are aggregated
+	void set_name(const std::string& name)
+	{
+		_stats = &lock_stats::_get(name);
+	}
+
+	void lock(void)
+	{
+		if(!_mutex.try_lock())
+		{
+			_clock::time_point start = _clock::now();
+			_mutex.lock();
+			_stats->record_wait(_ns_since(start));
+		}
+		++_stats->exclusive_locks;
+		_locked_at = _clock::now();
+	}
+
+	bool try_lock(void)
+	{
+		if(_mutex.try_lock())
+		{
+			++_stats->exclusive_locks;
+			_locked_at = _clock::now();
+			return true;
+		}
+		return false;
+	}
+
+	void unlock(void)
+	{
+		_stats->record_hold(_ns_since(_locked_at));
+		_mutex.unlock();
+	}
+
+	void lock_shared(void)
+	{
+		if(!_mutex.try_lock_shared())
+		{
+			_clock::time_point start = _clock::now();
+			_mutex.lock_shared();
+			_stats->record_wait(_ns_since(start));
+		}
+		++_stats->shared_locks;
+	}
+
+	bool try_lock_shared(void)
+	{
+		if(_mutex.try_lock_shared())
+		{
+			++_stats->shared_locks;
+			return true;
+		}
+		return false;
+	}
+
+	void unlock_shared(void)
+	{
+		_mutex.unlock_shared();
+	}
+};
+
+/// Locking policy recording contention statistics for all mutexes
+/** This policy wraps the mutexes of the Base policy (which must be
+ *  std_component_locking or read_mostly_component_locking or another
+ *  policy using real mutexes) into instrumented_mutex. The mutexes of
+ *  manager and of the component storage are named, so the statistics
+ *  can be attributed to them.
+ *
+ *  The policy is selected for a component group by specializing
+ *  the group_locking template:
+ *
+ *  @code
+ *  namespace exces {
+ *  template <>
+ *  struct group_locking<my_group>
+ *   : instrumented_component_locking<std_component_locking>
+ *  { };
+ *  } // namespace exces
+ *  @endcode
+ *
+ *  If the EXCES_LOCK_STATS preprocessor symbol is defined to zero,
+ *  this policy is equivalent to Base.
+ *
+ *  @see lock_stats
+ */
+template <typename Base = std_component_locking>
+struct instrumented_component_locking
+ : Base
+{
+#if EXCES_LOCK_STATS
+	typedef instrumented_mutex<typename Base::mutex> mutex;
+	typedef instrumented_mutex<typename Base::shared_mutex> shared_mutex;
+
+	typedef std::unique_lock<shared_mutex> unique_lock;
+
+	typedef exces::shared_lock<shared_mutex> shared_lock;
+
+	template <typename Mutex>
+	static void name_mutex(
+		instrumented_mutex<Mutex>& mutex,
+		const char* owner,
+		const char* role
+	)
+	{
+		mutex.set_name(std::string(owner)+"::"+role);
+	}
+#endif
+};
+
+} // namespace exces
+
+#endif //include guard
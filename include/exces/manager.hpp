@@ -16,6 +16,13 @@
 #include <exces/storage.hpp>
 #include <exces/component.hpp>
 #include <exces/collection.hpp>
+#include <exces/cursor.hpp>
+#include <exces/detail/parallel.hpp>
+#include <exces/manager_stats.hpp>
+#include <exces/memory_stats.hpp>
+#include <exces/snapshot.hpp>
+#include <exces/change_log.hpp>
+#include <exces/delta.hpp>
 
 #include <array>
 #include <vector>
@@ -31,6 +38,9 @@ namespace exces {
 template <typename Group>
 class manager;
 
+template <typename Group>
+class any_manager_impl;
+
 /// Implementation of basic manager entity traversal functions
 template <typename Group>
 class manager_entity_range
@@ -127,6 +137,9 @@ private:
 	// the component index map mutex
 	_shared_mutex _component_index_mutex;
 
+	// the optional log of the changes of components
+	change_log<Group>* _change_log;
+
 	// a vector of keys that allow to access the components
 	// (ordered by their ids) in the storage
 	struct _component_key_vector
@@ -254,6 +267,236 @@ private:
 	// the entity info mutex
 	_shared_mutex _entity_info_mutex;
 
+	// a column of Component values gathered by for_each_batch,
+	// C is either Component (read-only) or Component& (read-write)
+	template <typename C>
+	struct _batch_column
+	{
+		typedef typename _fix1<C>::type component_type;
+
+		typedef typename mp::if_c<
+			std::is_reference<C>::value &&
+			not(std::is_const<
+				typename std::remove_reference<C>::type
+			>::value),
+			component_type*,
+			const component_type*
+		>::type pointer;
+
+		std::vector<typename _component_storage::component_key> keys;
+		std::vector<component_type> values;
+		component_block<component_type> blk;
+
+		pointer data(void)
+		{
+			return values.data();
+		}
+
+		void gather(void)
+		{
+			for(auto key : keys)
+			{
+				assert(key < blk.size);
+				values.push_back(blk.components[key]);
+			}
+		}
+
+		void _scatter(const component_type*) { }
+
+		void _scatter(component_type*)
+		{
+			for(std::size_t i=0, n=keys.size(); i!=n; ++i)
+			{
+				blk.components[keys[i]] = std::move(values[i]);
+			}
+		}
+
+		void scatter(void)
+		{
+			_scatter(pointer());
+		}
+	};
+
+	// helper functor initializing the columns of for_each_batch
+	struct _batch_init
+	{
+		_component_storage& _storage;
+		const std::size_t n;
+
+		template <typename Column>
+		void operator()(Column& column) const
+		{
+			typedef typename Column::component_type C;
+			column.blk = _storage.template block<C>();
+			column.keys.reserve(n);
+			column.values.reserve(n);
+		}
+	};
+
+	// helper functor resolving the component keys of an entity
+	// for the columns of for_each_batch
+	struct _batch_resolve
+	{
+		_component_index_map& _component_indices;
+		typename _entity_info_map::iterator ek;
+
+		template <typename Column>
+		void operator()(Column& column) const
+		{
+			typedef typename Column::component_type C;
+			std::size_t cid = component_id<C, Group>::value;
+			assert(ek->second._component_bits.test(cid));
+
+			typename component_index<C>::type cidx =
+				_component_indices.get(
+					ek->second._component_bits
+				)[cid];
+			column.keys.push_back(ek->second._component_keys[cidx]);
+		}
+	};
+
+	// helper functor clearing, gathering or scattering batch columns
+	struct _batch_clear
+	{
+		template <typename Column>
+		void operator()(Column& column) const
+		{
+			column.keys.clear();
+			column.values.clear();
+		}
+	};
+
+	struct _batch_gather
+	{
+		template <typename Column>
+		void operator()(Column& column) const
+		{
+			column.gather();
+		}
+	};
+
+	struct _batch_scatter
+	{
+		template <typename Column>
+		void operator()(Column& column) const
+		{
+			column.scatter();
+		}
+	};
+
+	// for_each_batch on a single component type, visits the stored
+	// instances directly in the storage
+	template <typename Function, typename C>
+	void _do_for_each_batch(
+		Function& function,
+		std::size_t max_batch,
+		mp::typelist<C>
+	)
+	{
+		typedef _batch_column<C> _column;
+		typedef typename _column::component_type _comp;
+
+		_shared_lock slst(_storage_mutex);
+
+		const component_block<_comp> blk =
+			_storage.template block<_comp>();
+
+		std::size_t i = 0;
+		while(i != blk.size)
+		{
+			if(!blk.is_live(i))
+			{
+				++i;
+				continue;
+			}
+			std::size_t j = i+1;
+			while((j != blk.size) && (j-i != max_batch) && blk.is_live(j))
+			{
+				++j;
+			}
+			typename _column::pointer column = blk.components+i;
+			if(!function(j-i, column))
+			{
+				break;
+			}
+			i = j;
+		}
+	}
+
+	// for_each_batch on multiple component types, gathers the components
+	// of entities having all of them into contiguous temporary columns
+	template <typename Function, typename ... C, std::size_t ... S>
+	void _do_for_each_batch_gather(
+		Function& function,
+		std::size_t max_batch,
+		mp::n_seq<S...>
+	)
+	{
+		mp::tuple<_batch_column<C>...> columns;
+		const _component_bitset& bits =
+			_get_bits_tl(mp::typelist<typename _fix1<C>::type...>());
+
+		_shared_lock slst(_storage_mutex);
+		_shared_lock slem(_entity_map_mutex);
+
+		_batch_init init = { _storage, max_batch };
+		mp::for_each(columns, init);
+
+		typename _entity_info_map::iterator
+			i = _entities.begin(),
+			e = _entities.end();
+
+		while(i != e)
+		{
+			_batch_clear clear;
+			mp::for_each(columns, clear);
+
+			std::size_t n = 0;
+			{
+				_unique_lock ulci(_component_index_mutex);
+				_shared_lock slei(_entity_info_mutex);
+				while((i != e) && (n != max_batch))
+				{
+					if(i->second._component_bits.contains(bits))
+					{
+						_batch_resolve resolve = {
+							_component_indices,
+							i
+						};
+						mp::for_each(columns, resolve);
+						++n;
+					}
+					++i;
+				}
+			}
+			if(n == 0) break;
+
+			_batch_gather gather;
+			mp::for_each(columns, gather);
+
+			bool cont = function(n, mp::get<S>(columns).data()...);
+
+			_batch_scatter scatter;
+			mp::for_each(columns, scatter);
+
+			if(!cont) break;
+		}
+	}
+
+	template <typename Function, typename ... C>
+	void _do_for_each_batch(
+		Function& function,
+		std::size_t max_batch,
+		mp::typelist<C...>
+	)
+	{
+		_do_for_each_batch_gather<Function, C...>(
+			function,
+			max_batch,
+			typename mp::gen_seq<sizeof ... (C)>::type()
+		);
+	}
+
 	// helper functor that adds a Component into the storage
 	// and remembers the key in a vector at the position specified
 	// by the Component's id
@@ -261,6 +504,8 @@ private:
 	{
 		_component_storage& _storage;
 		_component_key_vector& _keys;
+		change_log<Group>* _log;
+		const typename entity<Group>::type& _entity;
 
 		template <typename Component>
 		void operator()(Component& component) const
@@ -268,6 +513,16 @@ private:
 			const std::size_t cid =
 				component_id<Component, Group>::value;
 			_keys[cid] = _storage.store(std::move(component));
+			if(_log)
+			{
+				_log->record(
+					change_op::add,
+					_entity,
+					&_storage.template access<Component>(
+						_keys[cid]
+					)
+				);
+			}
 		}
 	};
 
@@ -282,6 +537,8 @@ private:
 	{
 		_component_storage& _storage;
 		_component_key_vector& _keys;
+		change_log<Group>* _log;
+		const typename entity<Group>::type& _entity;
 
 		template <typename Component>
 		void operator()(mp::identity<Component>) const
@@ -289,6 +546,14 @@ private:
 			const std::size_t cid =
 				component_id<Component, Group>::value;
 			_storage.template release<Component>(_keys[cid]);
+			if(_log)
+			{
+				_log->record(
+					change_op::remove,
+					_entity,
+					static_cast<const Component*>(nullptr)
+				);
+			}
 		}
 	};
 
@@ -303,6 +568,8 @@ private:
 	{
 		_component_storage& _storage;
 		_component_key_vector& _keys;
+		change_log<Group>* _log;
+		const typename entity<Group>::type& _entity;
 
 		template <typename Component>
 		void operator()(Component& component) const
@@ -313,6 +580,16 @@ private:
 				_keys[cid],
 				std::move(component)
 			);
+			if(_log)
+			{
+				_log->record(
+					change_op::replace,
+					_entity,
+					&_storage.template access<Component>(
+						_keys[cid]
+					)
+				);
+			}
 		}
 	};
 
@@ -330,6 +607,8 @@ private:
 		_component_key_vector& _dst_keys;
 		const typename _component_index_map::index_vector& _src_map;
 		const typename _component_index_map::index_vector& _dst_map;
+		change_log<Group>* _log;
+		const typename entity<Group>::type& _entity;
 
 		template <typename Component>
 		void operator()(mp::identity<Component>) const
@@ -340,6 +619,16 @@ private:
 				_storage.template copy<Component>(
 					_src_keys[_src_map[cid]]
 				);
+			if(_log)
+			{
+				_log->record(
+					change_op::copy,
+					_entity,
+					&_storage.template access<Component>(
+						_dst_keys[_dst_map[cid]]
+					)
+				);
+			}
 		}
 	};
 
@@ -350,6 +639,62 @@ private:
 		const std::function<void(_component_copier&)>&
 	);
 
+	// helper functor that removes the Components with bits set
+	struct _delta_remover
+	{
+		_component_remover& _remover;
+		const _component_bitset& _bits;
+
+		template <typename Component>
+		void operator()(mp::identity<Component> c) const
+		{
+			if(_bits.test(component_id<Component, Group>::value))
+			{
+				_remover(c);
+			}
+		}
+	};
+
+	// helper functor that passes the next values of the Components
+	// with bits set from a delta to an adder or replacer
+	template <typename Target>
+	struct _delta_applier
+	{
+		Target& _target;
+		const _component_bitset& _bits;
+		const manager_delta<Group>& _delta;
+		std::vector<std::size_t>& _positions;
+
+		template <typename Component>
+		void operator()(mp::identity<Component>) const
+		{
+			const std::size_t cid =
+				component_id<Component, Group>::value;
+			if(_bits.test(cid))
+			{
+				Component component = _delta.template
+					_values<Component>()[_positions[cid]++];
+				_target(component);
+			}
+		}
+	};
+
+	// reads the snapshot into the (empty) entity map and storages,
+	// adds the iterators to the loaded entities to eks
+	void _load_snapshot(
+		std::istream& input,
+		std::vector<typename _entity_info_map::iterator>& eks
+	);
+
+	// adds the differences of the components of an entity
+	// in this and in the other manager to the delta
+	void _diff_entity(
+		manager_delta<Group>& delta,
+		const typename entity<Group>::type& e,
+		const _entity_info* from,
+		const _entity_info* to
+	);
+
 	// returns true if this manager has the specified entity
 	bool _has_entity(typename entity<Group>::type e)
 	{
@@ -376,6 +721,10 @@ private:
 	typename _entity_info_map::iterator
 	_find_entity(typename entity<Group>::type e);
 
+	// the type erased manager uses the add and remove sequences
+	// directly with components selected at run-time
+	friend class any_manager_impl<Group>;
+
 	friend class collection_intf<Group>;
 	std::vector<collection_intf<Group>*> _collections;
 	// the collection list mutex
@@ -398,6 +747,20 @@ private:
 		const _collection_update_key_list& update_keys
 	);
 public:
+	manager(void)
+	 : _change_log(nullptr)
+	{
+		_locking::name_mutex(_storage_mutex, "manager", "storage");
+		_locking::name_mutex(
+			_component_index_mutex,
+			"manager",
+			"component_index"
+		);
+		_locking::name_mutex(_entity_map_mutex, "manager", "entity_map");
+		_locking::name_mutex(_entity_info_mutex, "manager", "entity_info");
+		_locking::name_mutex(_collection_mutex, "manager", "collections");
+	}
+
 	// implementation detail DO NOT use directly
 	_component_storage& _get_storage_ref(void)
 	{
@@ -655,14 +1018,14 @@ public:
 	 *  @post has_all_seq< Sequence >(ek)
 	 */
 	template <typename Sequence>
-	manager& replace_seq(entity_key ek, const Sequence& seq)
+	manager& replace_seq(entity_key ek, Sequence seq)
 	{
 		_do_rep_seq(
 			ek,
 			_get_bits(seq),
 			[&seq](_component_replacer& replacer)
 			{
-				mp::for_each<Sequence>(seq, replacer);
+				mp::for_each(seq, replacer);
 			}
 		);
 		return *this;
@@ -731,6 +1094,16 @@ public:
 			ck,
 			std::move(component)
 		);
+		if(_change_log)
+		{
+			_change_log->record(
+				change_op::replace,
+				ek->first,
+				&_storage.template access<Component>(
+					new_keys[new_map[cid]]
+				)
+			);
+		}
 	}
 
 	/// Copy the specified components between the specified entities
@@ -837,7 +1210,7 @@ public:
 	{
 		assert(ek != _entities.end());
 		_shared_lock slei(_entity_info_mutex);
-		return ((ek->second._component_bits & bits) == bits);
+		return ek->second._component_bits.contains(bits);
 	}
 
 	bool has_all_bits(entity_type e, const _component_bitset& bits)
@@ -846,7 +1219,56 @@ public:
 		typename _entity_info_map::const_iterator ek = _entities.find(e);
 		if(ek == _entities.end()) return false;
 		_shared_lock slei(_entity_info_mutex);
-		return ((ek->second._component_bits & bits) == bits);
+		return ek->second._component_bits.contains(bits);
+	}
+
+	// implementation detail, checks which of the n entities have all
+	// the components specified by bits and stores the results into out
+	void has_all_bits(
+		const entity_key* keys,
+		std::size_t n,
+		const _component_bitset& bits,
+		bool* out
+	)
+	{
+		_shared_lock slei(_entity_info_mutex);
+		for(std::size_t i=0; i!=n; ++i)
+		{
+			assert(keys[i] != _entities.end());
+			const _component_bitset& ebits = keys[i]->second._component_bits;
+			out[i] = ebits.contains(bits);
+		}
+	}
+
+	// implementation detail, checks if the entity matches query masks
+	bool matches_masks(
+		entity_key ek,
+		const detail::query_masks<Group>& masks
+	)
+	{
+		assert(ek != _entities.end());
+		_shared_lock slei(_entity_info_mutex);
+		return masks.matches(ek->second._component_bits);
+	}
+
+	/// Returns true if the specified entity matches the query
+	/**
+	 *  @see query
+	 */
+	template <typename ... Clauses>
+	bool matches(entity_key ek, query<Clauses...> = query<Clauses...>())
+	{
+		return matches_masks(ek, query<Clauses...>::template masks<Group>());
+	}
+
+	/// Returns true if the specified entity matches the query
+	template <typename ... Clauses>
+	bool matches(entity_type e, query<Clauses...> q = query<Clauses...>())
+	{
+		_shared_lock slem(_entity_map_mutex);
+		typename _entity_info_map::iterator ek = _entities.find(e);
+		if(ek == _entities.end()) return false;
+		return matches(ek, q);
 	}
 
 	/// Returns true if the specified entity has all the specified Components
@@ -883,7 +1305,7 @@ public:
 	{
 		assert(ek != _entities.end());
 		_shared_lock slei(_entity_info_mutex);
-		return (ek->second._component_bits & bits).any();
+		return ek->second._component_bits.intersects(bits);
 	}
 
 	bool has_some_bits(entity_type e, const _component_bitset& bits)
@@ -892,7 +1314,7 @@ public:
 		typename _entity_info_map::const_iterator ek = _entities.find(e);
 		if(ek == _entities.end()) return false;
 		_shared_lock slei(_entity_info_mutex);
-		return (ek->second._component_bits & bits).any();
+		return ek->second._component_bits.intersects(bits);
 	}
 
 	/// Returns true if the specified entity has some of the Components
@@ -1117,6 +1539,95 @@ public:
 		return _storage.template access<_fixed_C>(key);
 	}
 
+	/// Writes pointers to the Components of n entities into out
+	/** This is equivalent to calling raw_access<Component>(keys[i])
+	 *  for each of the n keys, but the locks are acquired only once.
+	 *  @warning Read the documentation for raw_access before using
+	 *  this function.
+	 *
+	 *  @see raw_access
+	 */
+	template <typename Component, typename OutputIterator>
+	OutputIterator raw_access(
+		const entity_key* keys,
+		std::size_t n,
+		OutputIterator out
+	)
+	{
+		typedef typename _fix1<Component>::type _fixed_C;
+		std::size_t cid = component_id<_fixed_C, Group>::value;
+
+		_unique_lock ulci(_component_index_mutex);
+		_shared_lock slem(_entity_map_mutex);
+
+		// entities with the same components share the index
+		const _component_bitset* prev_bits = nullptr;
+		typename component_index<_fixed_C>::type cidx = 0;
+		for(std::size_t i=0; i!=n; ++i)
+		{
+			const _entity_info& info = keys[i]->second;
+			assert(info._component_bits.test(cid));
+			if(!prev_bits || (*prev_bits != info._component_bits))
+			{
+				cidx = _component_indices.get(
+					info._component_bits
+				)[cid];
+				prev_bits = &info._component_bits;
+			}
+			*out = &_storage.template access<_fixed_C>(
+				info._component_keys[cidx]
+			);
+			++out;
+		}
+		return out;
+	}
+
+	/// Calls function(ek, component) for each entity with the Component
+	/** The entities are visited in the order of their keys, the function
+	 *  gets the key of the entity and a pointer to its instance of the
+	 *  Component in the storage. The locks are acquired only once.
+	 *  @warning Read the documentation for raw_access before using
+	 *  this function. The function must not add or remove components.
+	 *
+	 *  @see raw_access
+	 */
+	template <typename Component, typename Function>
+	void raw_for_each(Function function)
+	{
+		typedef typename _fix1<Component>::type _fixed_C;
+		std::size_t cid = component_id<_fixed_C, Group>::value;
+
+		// the same lock order as in raw_access
+		_unique_lock ulci(_component_index_mutex);
+		_shared_lock slem(_entity_map_mutex);
+		_shared_lock slei(_entity_info_mutex);
+
+		const _component_bitset* prev_bits = nullptr;
+		typename component_index<_fixed_C>::type cidx = 0;
+		for(	typename _entity_info_map::iterator
+			i = _entities.begin(),
+			e = _entities.end();
+			i != e; ++i
+		)
+		{
+			const _entity_info& info = i->second;
+			if(!info._component_bits.test(cid)) continue;
+			if(!prev_bits || (*prev_bits != info._component_bits))
+			{
+				cidx = _component_indices.get(
+					info._component_bits
+				)[cid];
+				prev_bits = &info._component_bits;
+			}
+			function(
+				entity_key(i),
+				&_storage.template access<_fixed_C>(
+					info._component_keys[cidx]
+				)
+			);
+		}
+	}
+
 	/// Equivalent to raw_access<Component>(ek);
 	/** @warning Read the documentation for raw_access before using
 	 *  this function.
@@ -1249,12 +1760,12 @@ public:
 		template <typename Component>
 		void operator()(mp::identity<Component>) const
 		{
-			if(_manager.has<Component>(_key))
+			if(_manager.template has<Component>(_key))
 			{
 				_visitor(
 					_manager,
 					_key,
-					_manager.template read<Component>(_key)
+					_manager.template raw_access<Component>(_key)
 				);
 			}
 		}
@@ -1324,6 +1835,68 @@ public:
 		)>& function
 	);
 
+	/// Calls the specified function on entities, resuming at the cursor
+	/** This function continues the traversal of entities after the last
+	 *  entity visited with the specified @p cursor and visits entities
+	 *  until the @p budget is spent or until the traversal is finished.
+	 *  The entity map is locked only for the duration of the call.
+	 *  If the @p function returns false, the traversal is finished.
+	 *
+	 *  @see entity_cursor
+	 *  @see iter_budget
+	 */
+	manager& for_each(
+		entity_cursor<Group>& cursor,
+		const iter_budget& budget,
+		const std::function<bool (
+			const iter_info&,
+			manager&,
+			entity_key
+		)>& function
+	);
+
+	/// Calls the specified function on each entity matching the query
+	/** The @p function is called with the manager and the key of each
+	 *  entity matching the query and it should have the following
+	 *  signature:
+	 *
+	 *  @code
+	 *  bool function(manager&, entity_key);
+	 *  @endcode
+	 *
+	 *  If the @p function returns false, the traversal is finished.
+	 *
+	 *  @see query
+	 */
+	template <typename ... Clauses, typename Function>
+	manager& for_each(query<Clauses...>, Function function)
+	{
+		EXCES_MANAGER_STATS_SCOPE("manager::for_each_query")
+
+		const detail::query_masks<Group>& masks =
+			query<Clauses...>::template masks<Group>();
+
+		_shared_lock slem(_entity_map_mutex);
+
+		for(	typename _entity_info_map::iterator
+			i = _entities.begin(),
+			e = _entities.end();
+			i != e; ++i
+		)
+		{
+			bool match;
+			{
+				_shared_lock slei(_entity_info_mutex);
+				match = masks.matches(i->second._component_bits);
+			}
+			if(match && !function(*this, entity_key(i)))
+			{
+				break;
+			}
+		}
+		return *this;
+	}
+
 	/// Calls the specified function on every instance of Component
 	/** This function is more efficient in cases where all instances
 	 *  of a Component type must be processed and the reference to
@@ -1332,10 +1905,304 @@ public:
 	template <typename Component>
 	manager& for_each(const std::function<bool (Component&)>& function)
 	{
-		_storage.for_each<Component>(function);
+		EXCES_MANAGER_STATS_SCOPE("manager::for_each_component")
+		_storage.template for_each<Component>(function);
+		return *this;
+	}
+
+	/// Calls the specified function on contiguous batches of Components
+	/** This function calls the @p function on batches of at most
+	 *  @p max_batch components at a time. The @p function is passed
+	 *  the number of entries in the batch and a pointer to the first
+	 *  entry of a contiguous array of the instances of each of the specified
+	 *  Components, i.e. it should have the following signature:
+	 *
+	 *  @code
+	 *  bool function(std::size_t count, C1* c1, const C2* c2, ...);
+	 *  @endcode
+	 *
+	 *  Like with raw_access_lock a plain Component type name requests
+	 *  read-only access (the function gets a pointer to const) and
+	 *  a reference-to-Component type name requests read-write access.
+	 *  If the function returns false the traversal is stopped.
+	 *
+	 *  If a single Component is specified, the batches are spans of the
+	 *  component storage and (like with for_each<Component>) all stored
+	 *  instances of the Component are visited, regardless of the entity
+	 *  they belong to. Tight loops over the batches can be vectorized:
+	 *
+	 *  @code
+	 *  m.for_each_batch<clock&>(
+	 *      [](std::size_t n, clock* c) -> bool
+	 *      {
+	 *          for(std::size_t i=0; i!=n; ++i)
+	 *              c[i].time += c[i].pace;
+	 *          return true;
+	 *      }
+	 *  );
+	 *  @endcode
+	 *
+	 *  If several Components are specified, the components of the entities
+	 *  having all of them are copied into temporary contiguous columns
+	 *  in the order of the entities and the read-write components are copied
+	 *  back after the function returns.
+	 *
+	 *  @note Like the other functions accessing the component instances
+	 *  directly, this function does not lock the Components and does not
+	 *  update the collections depending on the values of the Components.
+	 *
+	 *  @see raw_access_lock
+	 */
+	template <typename ... Components, typename Function>
+	manager& for_each_batch(Function function, std::size_t max_batch = 1024)
+	{
+		static_assert(
+			sizeof ... (Components) > 0,
+			"At least one Component must be specified"
+		);
+		if(max_batch == 0)
+		{
+			throw std::invalid_argument(
+				"exces::manager::for_each_batch: zero batch size"
+			);
+		}
+		EXCES_MANAGER_STATS_SCOPE("manager::for_each_batch")
+		_do_for_each_batch(
+			function,
+			max_batch,
+			mp::typelist<Components...>()
+		);
 		return *this;
 	}
 
+	/// Reduces all instances of Component into a single value
+	/** This function calls @p map on every instance of Component and
+	 *  combines the results together with the @p init value by using
+	 *  the @p combine function. The instances are processed in contiguous
+	 *  chunks in parallel by up to @p max_threads threads (zero means
+	 *  the hardware concurrency), so @p map must be thread-safe and
+	 *  @p combine must be associative. The order in which the partial
+	 *  results are combined is unspecified but deterministic.
+	 *
+	 *  @code
+	 *  float total_mass = m.reduce<mass>(
+	 *      0.0f,
+	 *      [](const mass& m) { return m.value; },
+	 *      std::plus<float>()
+	 *  );
+	 *  @endcode
+	 *
+	 *  @note Instances of flyweight components are shared by entities
+	 *  and are visited only once, regardless of the number of entities
+	 *  referencing them.
+	 *
+	 *  @note Like the other functions accessing the component instances
+	 *  directly, this function does not lock the Component. A raw access
+	 *  lock for Component must be held by the calling thread if the
+	 *  components are concurrently modified or if they are backbuffered.
+	 *
+	 *  @see raw_access_lock
+	 *  @see reduce_keys
+	 */
+	template <typename Component, typename T, typename Map, typename Combine>
+	T reduce(
+		T init,
+		Map map,
+		Combine combine,
+		std::size_t max_threads = 0
+	)
+	{
+		EXCES_MANAGER_STATS_SCOPE("manager::reduce")
+		_shared_lock slst(_storage_mutex);
+
+		const component_block<Component> blk =
+			_storage.template block<Component>();
+
+		const std::size_t chunks = detail::parallel_chunk_count(
+			blk.size,
+			max_threads,
+			detail::parallel_min_chunk()
+		);
+		std::vector<detail::partial_result<T>> partials(chunks);
+
+		auto reduce_chunk = [&blk, &partials, &map, &combine](
+			std::size_t c,
+			std::size_t b,
+			std::size_t e
+		) -> void
+		{
+			const Component* cs = blk.components;
+			// the accumulator is seeded from the first live instance
+			std::size_t i = b;
+			while((i != e) && !blk.is_live(i)) ++i;
+			if(i == e) return;
+
+			T acc = T(map(cs[i]));
+			for(++i; i!=e; ++i)
+			{
+				if(blk.is_live(i))
+				{
+					acc = combine(std::move(acc), T(map(cs[i])));
+				}
+			}
+			partials[c].set(std::move(acc));
+		};
+		detail::parallel_chunks(blk.size, chunks, reduce_chunk);
+
+		return detail::combine_partials(std::move(init), partials, combine);
+	}
+
+	/// Reduces the Component of the entities in the range [begin, end)
+	/** This function works like reduce but processes only the instances
+	 *  of Component belonging to the entities with keys in the range
+	 *  specified by the @p begin and @p end iterators. Entities that do not
+	 *  have the Component are skipped. Instances of flyweight components
+	 *  shared by several entities in the range are processed once
+	 *  for every such entity.
+	 *
+	 *  @see reduce
+	 */
+	template <
+		typename Component,
+		typename Iterator,
+		typename T,
+		typename Map,
+		typename Combine
+	>
+	T reduce_keys(
+		Iterator begin,
+		Iterator end,
+		T init,
+		Map map,
+		Combine combine,
+		std::size_t max_threads = 0
+	)
+	{
+		EXCES_MANAGER_STATS_SCOPE("manager::reduce_keys")
+		std::size_t cid = component_id<Component, Group>::value;
+		std::vector<typename _component_storage::component_key> keys;
+
+		_shared_lock slst(_storage_mutex);
+		{
+			_unique_lock ulci(_component_index_mutex);
+			_shared_lock slei(_entity_info_mutex);
+			for(Iterator i=begin; i!=end; ++i)
+			{
+				const entity_key ek = *i;
+				if(ek->second._component_bits.test(cid))
+				{
+					typename component_index<Component>::type cidx =
+						_component_indices.get(
+							ek->second._component_bits
+						)[cid];
+					keys.push_back(ek->second._component_keys[cidx]);
+				}
+			}
+		}
+
+		const component_block<Component> blk =
+			_storage.template block<Component>();
+
+		const std::size_t chunks = detail::parallel_chunk_count(
+			keys.size(),
+			max_threads,
+			detail::parallel_min_chunk()
+		);
+		std::vector<detail::partial_result<T>> partials(chunks);
+
+		auto reduce_chunk = [&blk, &keys, &partials, &map, &combine](
+			std::size_t c,
+			std::size_t b,
+			std::size_t e
+		) -> void
+		{
+			if(b == e) return;
+			const Component* cs = blk.components;
+			assert(keys[b] < blk.size);
+			T acc = T(map(cs[keys[b]]));
+			for(std::size_t i=b+1; i!=e; ++i)
+			{
+				assert(keys[i] < blk.size);
+				acc = combine(std::move(acc), T(map(cs[keys[i]])));
+			}
+			partials[c].set(std::move(acc));
+		};
+		detail::parallel_chunks(keys.size(), chunks, reduce_chunk);
+
+		return detail::combine_partials(std::move(init), partials, combine);
+	}
+
+	/// Returns the memory statistics of this manager
+	/** The statistics include the entity map, the component key vectors
+	 *  and the component index map of the manager, the storages of all
+	 *  components in the Group and all collections registered with this
+	 *  manager. Entities that have no components left still occupy
+	 *  entity map nodes, so a growing entity count with a stable number
+	 *  of live components indicates leaked entities.
+	 */
+	manager_memory_stats memory_stats(void);
+
+	/// Releases unused memory after mass removals of components
+	/** Releases the free slots at the end of the component storages
+	 *  and their unused capacity, drops the empty classes of
+	 *  classifications and compacts the key sets of all collections
+	 *  registered with this manager. This function must not be called
+	 *  while a raw access lock or a traversal of the components
+	 *  is in progress.
+	 *
+	 *  @return the number of bytes reclaimed.
+	 *
+	 *  @see memory_stats
+	 */
+	std::size_t shrink_to_fit(void);
+
+	/// Writes the entities and components of this manager into output
+	/** This function must not be called while a raw access lock
+	 *  or a traversal of the components is in progress.
+	 *
+	 *  @see load_snapshot
+	 */
+	void save_snapshot(std::ostream& output);
+
+	/// Loads entities and components from a snapshot read from input
+	/** This manager must not contain any entities. If the snapshot
+	 *  cannot be loaded the exception is propagated and this manager
+	 *  is left empty, so that another snapshot can be loaded into it.
+	 *
+	 *  @see save_snapshot
+	 */
+	void load_snapshot(std::istream& input);
+
+	/// Returns the delta transforming the state of this manager into other
+	/** This function must not be called while a raw access lock
+	 *  or a traversal of the components is in progress.
+	 *
+	 *  @see patch
+	 *  @see manager_delta
+	 */
+	manager_delta<Group> diff(manager& other);
+
+	/// Applies the delta created by diff to this manager
+	/**
+	 *  @see diff
+	 *  @see manager_delta
+	 */
+	manager& patch(const manager_delta<Group>& delta);
+
+	/// Attaches a change log recording the changes of the components
+	/** The log records every subsequent addition, removal, replacement
+	 *  and copy of a component. Passing nullptr detaches the current
+	 *  log. The log must outlive this manager or be detached before
+	 *  it is destroyed.
+	 *
+	 *  @see change_log
+	 */
+	void set_change_log(change_log<Group>* log)
+	{
+		_unique_lock ulci(_component_index_mutex);
+		_change_log = log;
+	}
+
 	/// The entity range type
 	typedef entity_range_tpl<
 		Group,
@@ -1361,6 +2228,22 @@ public:
 		);
 	}
 
+	/// Returns an entity_range containing entities matching the query
+	template <typename ... Clauses>
+	entity_range select(query<Clauses...>)
+	{
+		_shared_lock slem(_entity_map_mutex);
+		return entity_range(
+			std::move(slem),
+			*this,
+			manager_entity_range<Group>(
+				_entities.begin(),
+				_entities.end()
+			),
+			query<Clauses...>::template masks<Group>()
+		);
+	}
+
 	/// Returns an entity_range containing entities with the Components
 	template <typename ... Components>
 	entity_range select_with(void)
@@ -0,0 +1,327 @@
+/**
+ *  @file exces/manager_stats.hpp
+ *  @brief Per-operation counters and timing of manager operations
+ *
+ *  Copyright 2012-2014 Matus Chochlik. Distributed under the Boost
+ *  Software License, Version 1.0. (See accompanying file
+ *  LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef EXCES_MANAGER_STATS_1405161104_HPP
+#define EXCES_MANAGER_STATS_1405161104_HPP
+
+#include <exces/config.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <map>
+#include <string>
+#include <vector>
+#include <ostream>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+namespace exces {
+
+/// Aggregated count and duration of a particular manager operation
+/**
+ *  @see manager_stats
+ */
+struct manager_stats_record
+{
+	/// The name of the operation
+	std::string name;
+
+	/// The number of times the operation was executed
+	std::uint64_t count;
+
+	/// The total time spent in the operation in nanoseconds
+	std::uint64_t total_ns;
+
+	/// The average duration of the operation in nanoseconds
+	double average_ns(void) const
+	{
+		return count?double(total_ns)/double(count):0.0;
+	}
+};
+
+/// Counters and timers of the operations done by managers
+/** If the EXCES_MANAGER_STATS preprocessor symbol is defined to a nonzero
+ *  value, the managers (of all groups), their component storage and their
+ *  collections count and time the following operations:
+ *
+ *  - manager::add, manager::remove, manager::replace and manager::copy,
+ *  - the entity and component traversals of manager,
+ *  - <component>::store and <component>::release in the component storage,
+ *  - <collection>::begin_update, <collection>::finish_update and
+ *    <collection>::for_each of each collection (named by set_name).
+ *
+ *  The operations are recorded into thread-local counters, which are
+ *  aggregated only when a snapshot is requested, so the recording does
+ *  not cause contention between threads. The time spent in an operation
+ *  includes the time spent in all operations nested in it (for example
+ *  manager::add includes the collection updates and component stores).
+ *
+ *  If EXCES_MANAGER_STATS is zero (the default) the recording compiles
+ *  to nothing and the snapshot is empty.
+ *
+ *  @code
+ *  exces::manager_stats::dump(std::cout);
+ *  @endcode
+ */
+class manager_stats
+{
+public:
+	/// The maximum number of distinct operation names
+	static const std::size_t max_names = 512;
+
+	// implementation detail, do not use directly
+	struct _counter
+	{
+		std::atomic<std::uint64_t> count;
+		std::atomic<std::uint64_t> total_ns;
+		// the values at the last reset, accessed under the registry mutex
+		std::uint64_t base_count;
+		std::uint64_t base_ns;
+
+		_counter(void)
+		 : count(0)
+		 , total_ns(0)
+		 , base_count(0)
+		 , base_ns(0)
+		{ }
+
+		void add(std::uint64_t ns)
+		{
+			// only the owning thread writes into the counter
+			count.store(
+				count.load(std::memory_order_relaxed)+1,
+				std::memory_order_relaxed
+			);
+			total_ns.store(
+				total_ns.load(std::memory_order_relaxed)+ns,
+				std::memory_order_relaxed
+			);
+		}
+
+		// the counter is not written by other threads than the owner,
+		// the values recorded so far are remembered and subtracted
+		void reset(void)
+		{
+			base_count = count.load(std::memory_order_relaxed);
+			base_ns = total_ns.load(std::memory_order_relaxed);
+		}
+
+		std::uint64_t recorded_count(void) const
+		{
+			return count.load(std::memory_order_relaxed)-base_count;
+		}
+
+		std::uint64_t recorded_ns(void) const
+		{
+			return total_ns.load(std::memory_order_relaxed)-base_ns;
+		}
+	};
+private:
+	struct _thread_table
+	{
+		_counter counters[max_names];
+
+		_thread_table(void);
+		~_thread_table(void);
+	};
+
+	struct _registry
+	{
+		std::mutex mutex;
+		std::map<std::string, std::size_t> ids;
+		std::vector<std::string> names;
+		std::vector<_thread_table*> tables;
+		// totals of the tables of already finished threads
+		std::vector<std::uint64_t> retired_count;
+		std::vector<std::uint64_t> retired_ns;
+
+		_registry(void)
+		 : retired_count(max_names, 0)
+		 , retired_ns(max_names, 0)
+		{ }
+	};
+
+	static _registry& _reg(void)
+	{
+		static _registry reg;
+		return reg;
+	}
+
+	static _thread_table& _table(void)
+	{
+		static thread_local _thread_table table;
+		return table;
+	}
+public:
+	// implementation detail, do not use directly
+	static std::size_t _id(const std::string& name)
+	{
+		_registry& reg = _reg();
+		std::lock_guard<std::mutex> lg(reg.mutex);
+		auto p = reg.ids.find(name);
+		if(p != reg.ids.end()) return p->second;
+
+		if(reg.names.size()+1 == max_names)
+		{
+			// the last slot collects all overflowing names
+			return max_names-1;
+		}
+		std::size_t id = reg.names.size();
+		reg.names.push_back(name);
+		reg.ids[name] = id;
+		return id;
+	}
+
+	// implementation detail, do not use directly
+	static void _record(std::size_t id, std::uint64_t ns)
+	{
+		_table().counters[id].add(ns);
+	}
+
+	// implementation detail, do not use directly
+	class _scope
+	{
+	private:
+		typedef std::chrono::steady_clock _clock;
+		std::size_t _id;
+		_clock::time_point _start;
+	public:
+		_scope(std::size_t id)
+		 : _id(id)
+		 , _start(_clock::now())
+		{ }
+
+		_scope(const _scope&) = delete;
+
+		~_scope(void)
+		{
+			_record(_id, std::uint64_t(
+				std::chrono::duration_cast<std::chrono::nanoseconds>(
+					_clock::now() - _start
+				).count()
+			));
+		}
+	};
+
+	/// Returns the aggregated statistics of all recorded operations
+	static std::vector<manager_stats_record> snapshot(void)
+	{
+		_registry& reg = _reg();
+		std::lock_guard<std::mutex> lg(reg.mutex);
+		std::vector<manager_stats_record> result;
+
+		for(std::size_t id=0; id!=max_names; ++id)
+		{
+			manager_stats_record r;
+			r.count = reg.retired_count[id];
+			r.total_ns = reg.retired_ns[id];
+			for(_thread_table* t : reg.tables)
+			{
+				r.count += t->counters[id].recorded_count();
+				r.total_ns += t->counters[id].recorded_ns();
+			}
+			if(r.count == 0) continue;
+
+			if(id < reg.names.size()) r.name = reg.names[id];
+			else r.name = "(other)";
+			result.push_back(std::move(r));
+		}
+		std::sort(
+			result.begin(),
+			result.end(),
+			[](
+				const manager_stats_record& a,
+				const manager_stats_record& b
+			) -> bool
+			{
+				return a.name < b.name;
+			}
+		);
+		return result;
+	}
+
+	/// Resets all counters
+	/** The operations recorded concurrently with the reset may or may
+	 *  not be counted.
+	 */
+	static void reset(void)
+	{
+		_registry& reg = _reg();
+		std::lock_guard<std::mutex> lg(reg.mutex);
+		std::fill(reg.retired_count.begin(), reg.retired_count.end(), 0);
+		std::fill(reg.retired_ns.begin(), reg.retired_ns.end(), 0);
+		for(_thread_table* t : reg.tables)
+		{
+			for(_counter& c : t->counters)
+			{
+				c.reset();
+			}
+		}
+	}
+
+	/// Writes a human-readable report of the statistics to @p out
+	static std::ostream& dump(std::ostream& out)
+	{
+		for(const manager_stats_record& r : snapshot())
+		{
+			out	<< r.name << ": "
+				<< "count=" << r.count << ", "
+				<< "total=" << r.total_ns << "ns, "
+				<< "average=" << r.average_ns() << "ns"
+				<< std::endl;
+		}
+		return out;
+	}
+};
+
+inline
+manager_stats::_thread_table::
+_thread_table(void)
+{
+	_registry& reg = _reg();
+	std::lock_guard<std::mutex> lg(reg.mutex);
+	reg.tables.push_back(this);
+}
+
+inline
+manager_stats::_thread_table::
+~_thread_table(void)
+{
+	_registry& reg = _reg();
+	std::lock_guard<std::mutex> lg(reg.mutex);
+	for(std::size_t id=0; id!=max_names; ++id)
+	{
+		reg.retired_count[id] += counters[id].recorded_count();
+		reg.retired_ns[id] += counters[id].recorded_ns();
+	}
+	reg.tables.erase(
+		std::find(reg.tables.begin(), reg.tables.end(), this)
+	);
+}
+
+} // namespace exces
+
+#if EXCES_MANAGER_STATS
+// Counts and times the rest of the enclosing scope under a name
+// (evaluated once per expansion)
+#define EXCES_MANAGER_STATS_SCOPE(NAME) \
+	static const std::size_t _exces_stats_id = \
+		::exces::manager_stats::_id(NAME); \
+	::exces::manager_stats::_scope _exces_stats_scope(_exces_stats_id);
+// Counts and times the rest of the enclosing scope under a name id
+#define EXCES_MANAGER_STATS_SCOPE_ID(ID) \
+	::exces::manager_stats::_scope _exces_stats_scope(ID);
+#else
+#define EXCES_MANAGER_STATS_SCOPE(NAME)
+#define EXCES_MANAGER_STATS_SCOPE_ID(ID)
+#endif
+
+#endif //include guard
@@ -0,0 +1,180 @@
+/**
+ *  @file exces/memory_stats.hpp
+ *  @brief Memory accounting of component storage, managers and collections
+ *
+ *  Copyright 2012-2014 Matus Chochlik. Distributed under the Boost
+ *  Software License, Version 1.0. (See accompanying file
+ *  LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef EXCES_MEMORY_STATS_1405171420_HPP
+#define EXCES_MEMORY_STATS_1405171420_HPP
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include <cstddef>
+
+namespace exces {
+namespace detail {
+
+// estimates the size of a node of an ordered associative container
+template <typename Map>
+inline std::size_t map_node_bytes(void)
+{
+	// value, parent, left and right pointers and the color
+	return sizeof(typename Map::value_type)+4*sizeof(void*);
+}
+
+// estimates the memory allocated by an unordered associative container
+template <typename Map>
+inline std::size_t unordered_map_bytes(const Map& map)
+{
+	// the bucket array plus nodes with value, next pointer and hash
+	return	map.bucket_count()*sizeof(void*)+
+		map.size()*(
+			sizeof(typename Map::value_type)+
+			2*sizeof(void*)
+		);
+}
+
+} // namespace detail
+
+/// Memory used by the storage of a single component type
+/** The byte counts include only the memory allocated by the storage
+ *  itself, not the memory allocated by the component instances (for
+ *  example the characters of a std::string member).
+ *
+ *  @see component_storage::memory_stats
+ */
+struct component_memory_stats
+{
+	/// The name of the component
+	std::string name;
+
+	/// The number of live component instances
+	std::size_t live_count;
+
+	/// The number of allocated slots (live or free)
+	std::size_t slot_count;
+
+	/// The number of slots that can be stored without reallocation
+	std::size_t capacity;
+
+	/// The number of free slots (holes) waiting for reuse
+	std::size_t free_count;
+
+	/// The number of bytes occupied by live component instances
+	std::size_t bytes_used;
+
+	/// The number of bytes occupied by the free slots
+	std::size_t bytes_free;
+
+	/// The total number of bytes allocated by the storage
+	std::size_t bytes_reserved;
+};
+
+/// Memory used by the key set(s) of a collection or classification
+/**
+ *  @see manager::memory_stats
+ */
+struct collection_memory_stats
+{
+	/// The name of the collection
+	std::string name;
+
+	/// The number of stored entity keys
+	std::size_t key_count;
+
+	/// The number of classes (one for plain collections)
+	std::size_t class_count;
+
+	/// The number of bytes allocated for the keys and classes
+	std::size_t bytes;
+};
+
+/// Memory used by a manager, its component storage and collections
+/** The byte counts of the node-based containers are estimates, based on
+ *  the typical layout of the nodes of the standard library containers.
+ *
+ *  @see manager::memory_stats
+ */
+struct manager_memory_stats
+{
+	/// The number of entities registered in the manager
+	std::size_t entity_count;
+
+	/// The number of bytes allocated for the entity map nodes
+	std::size_t entity_bytes;
+
+	/// The total number of component keys of all entities
+	std::size_t component_key_count;
+
+	/// The number of bytes allocated for the component key vectors
+	std::size_t component_key_bytes;
+
+	/// The number of entries in the component index map
+	std::size_t component_index_entries;
+
+	/// The number of bytes allocated for the component index map
+	std::size_t component_index_bytes;
+
+	/// The memory statistics of the individual component storages
+	std::vector<component_memory_stats> components;
+
+	/// The memory statistics of the registered collections
+	std::vector<collection_memory_stats> collections;
+
+	/// Returns the total number of allocated bytes
+	std::size_t total_bytes(void) const
+	{
+		std::size_t result =
+			entity_bytes+
+			component_key_bytes+
+			component_index_bytes;
+		for(const auto& c : components)
+		{
+			result += c.bytes_reserved;
+		}
+		for(const auto& c : collections)
+		{
+			result += c.bytes;
+		}
+		return result;
+	}
+
+	/// Writes a human-readable report of the statistics to @p out
+	std::ostream& dump(std::ostream& out) const
+	{
+		out	<< "entities: " << entity_count << " ("
+			<< entity_bytes << " B)" << std::endl
+			<< "component keys: " << component_key_count << " ("
+			<< component_key_bytes << " B)" << std::endl
+			<< "component index: " << component_index_entries << " ("
+			<< component_index_bytes << " B)" << std::endl;
+		for(const auto& c : components)
+		{
+			out	<< "component " << c.name << ": "
+				<< c.live_count << " live, "
+				<< c.free_count << " free, "
+				<< c.capacity << " capacity ("
+				<< c.bytes_used << " B used, "
+				<< c.bytes_free << " B free, "
+				<< c.bytes_reserved << " B reserved)"
+				<< std::endl;
+		}
+		for(const auto& c : collections)
+		{
+			out	<< "collection " << c.name << ": "
+				<< c.key_count << " keys, "
+				<< c.class_count << " classes ("
+				<< c.bytes << " B)" << std::endl;
+		}
+		out << "total: " << total_bytes() << " B" << std::endl;
+		return out;
+	}
+};
+
+} // namespace exces
+
+#endif //include guard
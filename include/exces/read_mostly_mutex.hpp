@@ -0,0 +1,171 @@
+/**
+ *  @file exces/read_mostly_mutex.hpp
+ *  @brief Implementation of reader-biased shared mutex
+ *
+ *  Copyright 2012-2014 Matus Chochlik. Distributed under the Boost
+ *  Software License, Version 1.0. (See accompanying file
+ *  LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef EXCES_READ_MOSTLY_MUTEX_1405141012_HPP
+#define EXCES_READ_MOSTLY_MUTEX_1405141012_HPP
+
+#include <exces/detail/cache_aligned.hpp>
+
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <cassert>
+#include <cstddef>
+
+namespace exces {
+
+/// Reader-biased shared-ownership mutex for read-mostly data
+/** Unlike shared_mutex, which serializes all lock operations on a single
+ *  internal mutex, this mutex counts the readers in several counters
+ *  placed in separate cache lines. Each thread is assigned one of the
+ *  counters, so readers running on different cores do not contend
+ *  for the same cache line when there is no writer.
+ *  Writers are serialized by an internal mutex, announce themselves
+ *  by setting a flag and then wait until all reader counters drop to
+ *  zero. Readers arriving while a writer holds (or waits for) the lock
+ *  block on the writer mutex, i.e. writers are preferred once they arrive.
+ *
+ *  The price for fast shared locking is a larger memory footprint
+ *  (about 2KB per instance) and slower exclusive locking, which must
+ *  inspect all the reader counters.
+ *
+ *  @see read_mostly_component_locking
+ */
+class read_mostly_shared_mutex
+ : public detail::cache_aligned_new
+{
+private:
+	static const std::size_t _cache_line = detail::cache_line_size;
+	static const std::size_t _slot_count = 32;
+
+	// each reader counter occupies a whole cache line
+	struct alignas(_cache_line) _slot
+	{
+		std::atomic<unsigned> readers;
+	};
+
+	_slot _slots[_slot_count];
+
+	std::atomic<bool> _writing;
+	std::mutex _writer_mutex;
+
+	// returns the index of the reader counter used by the calling thread
+	static std::size_t _slot_index(void)
+	{
+		static std::atomic<std::size_t> next_index(0);
+		static thread_local std::size_t index = next_index++;
+		return index % _slot_count;
+	}
+
+	_slot& _my_slot(void)
+	{
+		return _slots[_slot_index()];
+	}
+
+	bool _no_readers(void) const
+	{
+		for(std::size_t i=0; i!=_slot_count; ++i)
+		{
+			if(_slots[i].readers.load() != 0)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+public:
+	read_mostly_shared_mutex(void)
+	 : _writing(false)
+	{
+		for(std::size_t i=0; i!=_slot_count; ++i)
+		{
+			_slots[i].readers.store(0);
+		}
+	}
+
+	read_mostly_shared_mutex(const read_mostly_shared_mutex&) = delete;
+
+	~read_mostly_shared_mutex(void)
+	{
+		assert(!_writing.load());
+		assert(_no_readers());
+	}
+
+	void lock(void)
+	{
+		_writer_mutex.lock();
+		_writing.store(true);
+		while(!_no_readers())
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	bool try_lock(void)
+	{
+		if(!_writer_mutex.try_lock())
+		{
+			return false;
+		}
+		_writing.store(true);
+		if(!_no_readers())
+		{
+			_writing.store(false);
+			_writer_mutex.unlock();
+			return false;
+		}
+		return true;
+	}
+
+	void unlock(void)
+	{
+		assert(_writing.load());
+		_writing.store(false);
+		_writer_mutex.unlock();
+	}
+
+	void lock_shared(void)
+	{
+		_slot& slot = _my_slot();
+		while(true)
+		{
+			slot.readers.fetch_add(1);
+			if(!_writing.load())
+			{
+				return;
+			}
+			slot.readers.fetch_sub(1);
+			// wait until the current writer finishes
+			std::lock_guard<std::mutex> lg(_writer_mutex);
+		}
+	}
+
+	bool try_lock_shared(void)
+	{
+		_slot& slot = _my_slot();
+		slot.readers.fetch_add(1);
+		if(!_writing.load())
+		{
+			return true;
+		}
+		slot.readers.fetch_sub(1);
+		return false;
+	}
+
+	void unlock_shared(void)
+	{
+		_slot& slot = _my_slot();
+		assert(slot.readers.load() != 0);
+		slot.readers.fetch_sub(1);
+	}
+};
+
+} // namespace exces
+
+#endif //include guard
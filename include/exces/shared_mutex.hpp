@@ -14,6 +14,7 @@
 #include <mutex>
 #include <condition_variable>
 #include <stdexcept>
+#include <system_error>
 #include <climits>
 #include <cassert>
 
@@ -46,16 +47,18 @@ public:
 	void lock(void)
 	{
 		std::unique_lock<std::mutex> l(_mutex);
+		// wait until other writers finish
 		while(_state & _writing)
 		{
-			_cond_2.wait(l);
+			_cond_1.wait(l);
 		}
 
 		_state |= _writing;
 
+		// wait until the readers finish
 		while(_state & _readers)
 		{
-			_cond_1.wait(l);
+			_cond_2.wait(l);
 		}
 	}
 
@@ -104,6 +107,7 @@ public:
 		{
 			if((_state & _readers) != _readers)
 			{
+				++_state;
 				return true;
 			}
 		}
@@ -145,15 +149,15 @@ private:
 	{
 		if(!_lockable)
 		{
-			throw std::system_error(
+			throw std::system_error(std::make_error_code(
 				std::errc::operation_not_permitted
-			);
+			));
 		}
 		if(_locked)
 		{
-			throw std::system_error(
+			throw std::system_error(std::make_error_code(
 				std::errc::resource_deadlock_would_occur
-			);
+			));
 		}
 	}
 
@@ -162,9 +166,9 @@ private:
 		assert(_lockable);
 		if(!_locked)
 		{
-			throw std::system_error(
+			throw std::system_error(std::make_error_code(
 				std::errc::resource_deadlock_would_occur
-			);
+			));
 		}
 	}
 public:
@@ -202,6 +206,7 @@ public:
 		tmp._lockable = nullptr;
 		_locked = tmp._locked;
 		tmp._locked = false;
+		return *this;
 	}
 
 	~shared_lock(void)
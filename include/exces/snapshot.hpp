@@ -0,0 +1,467 @@
+/**
+ *  @file exces/snapshot.hpp
+ *  @brief Binary snapshots of the contents of a manager
+ *
+ *  Copyright 2012-2014 Matus Chochlik. Distributed under the Boost
+ *  Software License, Version 1.0. (See accompanying file
+ *  LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef EXCES_SNAPSHOT_1405201130_HPP
+#define EXCES_SNAPSHOT_1405201130_HPP
+
+#include <exces/fwd.hpp>
+
+#include <type_traits>
+#include <stdexcept>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <sstream>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+
+namespace exces {
+
+/// Writes and reads the values of T into and from snapshots
+/** The default implementation for trivially copyable types writes
+ *  the raw bytes of the values and the instances of such components
+ *  are written and read as contiguous blocks. For other types this
+ *  template must be specialized and the specialization must implement
+ *  the following static member functions:
+ *
+ *  @code
+ *  static void write(std::ostream& output, const T& value);
+ *  static T read(std::istream& input);
+ *  @endcode
+ *
+ *  The default implementation for types that are not trivially copyable
+ *  throws std::invalid_argument if an instance of T is saved or loaded.
+ *
+ *  @see save_snapshot
+ *  @see load_snapshot
+ */
+template <typename T, bool Raw = std::is_trivially_copyable<T>::value>
+struct snapshot_serializer
+{
+	static void write(std::ostream& output, const T& value)
+	{
+		output.write(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	static T read(std::istream& input)
+	{
+		typename std::aligned_storage<
+			sizeof(T),
+			alignof(T)
+		>::type buffer;
+		input.read(reinterpret_cast<char*>(&buffer), sizeof(T));
+		return *reinterpret_cast<const T*>(&buffer);
+	}
+
+	// implementation detail, indicates that write writes the bytes
+	// of the value (so the values can be written and read in blocks)
+	static constexpr bool _raw = true;
+};
+
+template <typename T>
+struct snapshot_serializer<T, false>
+{
+	static void write(std::ostream&, const T&)
+	{
+		throw std::invalid_argument(
+			"exces::snapshot_serializer: "
+			"no serializer for a type that is not trivially copyable"
+		);
+	}
+
+	static T read(std::istream&)
+	{
+		throw std::invalid_argument(
+			"exces::snapshot_serializer: "
+			"no serializer for a type that is not trivially copyable"
+		);
+	}
+
+	static constexpr bool _raw = false;
+};
+
+namespace detail {
+
+// checks if the snapshot_serializer for T writes raw bytes
+// (user-defined specializations are never raw)
+template <typename T>
+struct snapshot_raw
+{
+	template <typename S>
+	static std::integral_constant<bool, S::_raw> _check(S*);
+
+	static std::false_type _check(...);
+
+	typedef decltype(_check(
+		static_cast<snapshot_serializer<T>*>(nullptr)
+	)) type;
+
+	static constexpr bool value = type::value;
+};
+
+// checks if T can be written through the snapshot_serializer, that is
+// it is trivially copyable or the serializer is specialized for it
+template <typename T>
+struct snapshot_serializable
+{
+	template <typename S>
+	static std::integral_constant<bool, S::_raw> _check(S*);
+
+	static std::true_type _check(...);
+
+	typedef decltype(_check(
+		static_cast<snapshot_serializer<T>*>(nullptr)
+	)) type;
+
+	static constexpr bool value = type::value;
+};
+
+// the alignment of the blocks of data in a snapshot, allowing to access
+// the blocks in place when the snapshot is mapped into memory
+static constexpr std::size_t snapshot_alignment = 64;
+
+// the version of the snapshot format
+static constexpr std::uint32_t snapshot_version = 2;
+
+// writes the header, the sizes and blocks of bytes of a snapshot
+class snapshot_writer
+{
+private:
+	std::ostream& _output;
+	// the number of bytes written so far
+	std::size_t _offset;
+	// buffer for values that are not written as raw bytes
+	std::ostringstream _values;
+public:
+	snapshot_writer(std::ostream& output)
+	 : _output(output)
+	 , _offset(0)
+	{ }
+
+	void check(void)
+	{
+		if(!_output.good() || !_values.good())
+		{
+			throw std::runtime_error(
+				"exces::save_snapshot: write error"
+			);
+		}
+	}
+
+	void write_bytes(const void* bytes, std::size_t size)
+	{
+		if(size != 0)
+		{
+			_output.write(static_cast<const char*>(bytes), size);
+			check();
+			_offset += size;
+		}
+	}
+
+	// pads the output to the snapshot_alignment
+	void align(void)
+	{
+		static const char zeros[snapshot_alignment] = { 0 };
+		write_bytes(
+			zeros,
+			(snapshot_alignment-_offset%snapshot_alignment)%
+			snapshot_alignment
+		);
+	}
+
+	template <typename T>
+	void write(T value)
+	{
+		write_bytes(&value, sizeof(value));
+	}
+
+	void write_size(std::size_t size)
+	{
+		write(std::uint64_t(size));
+	}
+
+	void write_string(const std::string& str)
+	{
+		write_size(str.size());
+		write_bytes(str.data(), str.size());
+	}
+
+	// starts a block of count values of type T, the raw values are
+	// written directly, the other ones are buffered so that the size
+	// of the block is known before it is written
+	template <typename T>
+	void begin_values(std::size_t count)
+	{
+		if(snapshot_raw<T>::value)
+		{
+			write_size(count*sizeof(T));
+			align();
+		}
+		else _values.str(std::string());
+	}
+
+	template <typename T>
+	void write_value(const T& value)
+	{
+		if(snapshot_raw<T>::value)
+		{
+			snapshot_serializer<T>::write(_output, value);
+			check();
+			_offset += sizeof(T);
+		}
+		else
+		{
+			snapshot_serializer<T>::write(_values, value);
+			check();
+		}
+	}
+
+	// finishes the block of values, every block starts with the size
+	// and its values are aligned to the snapshot_alignment
+	template <typename T>
+	void finish_values(void)
+	{
+		if(!snapshot_raw<T>::value)
+		{
+			const std::string values = _values.str();
+			_values.str(std::string());
+			write_size(values.size());
+			align();
+			write_bytes(values.data(), values.size());
+		}
+		align();
+	}
+
+	void write_header(void)
+	{
+		write_bytes("EXCESSNP", 8);
+		write(snapshot_version);
+		// byte order and size of int (used by the storage)
+		write(std::uint32_t(0x01020304));
+		write(std::uint32_t(sizeof(int)));
+	}
+};
+
+// reads the header, the sizes and blocks of bytes of a snapshot
+class snapshot_reader
+{
+private:
+	std::istream& _input;
+	// the number of bytes read so far
+	std::size_t _offset;
+	// buffer for values that are not read as raw bytes
+	std::istringstream _values;
+public:
+	snapshot_reader(std::istream& input)
+	 : _input(input)
+	 , _offset(0)
+	{ }
+
+	void check(void)
+	{
+		if(!_input.good())
+		{
+			throw std::runtime_error(
+				"exces::load_snapshot: read error"
+			);
+		}
+	}
+
+	void read_bytes(void* bytes, std::size_t size)
+	{
+		if(size != 0)
+		{
+			_input.read(static_cast<char*>(bytes), size);
+			check();
+			_offset += size;
+		}
+	}
+
+	void skip(std::size_t size)
+	{
+		if(size != 0)
+		{
+			_input.ignore(std::streamsize(size));
+			check();
+			_offset += size;
+		}
+	}
+
+	// skips the padding up to the snapshot_alignment
+	void align(void)
+	{
+		skip(
+			(snapshot_alignment-_offset%snapshot_alignment)%
+			snapshot_alignment
+		);
+	}
+
+	template <typename T>
+	T read(void)
+	{
+		T value;
+		read_bytes(&value, sizeof(value));
+		return value;
+	}
+
+	std::size_t read_size(void)
+	{
+		std::uint64_t size = read<std::uint64_t>();
+		if(size > std::uint64_t(std::size_t(-1)))
+		{
+			throw std::invalid_argument(
+				"exces::load_snapshot: size out of range"
+			);
+		}
+		return std::size_t(size);
+	}
+
+	std::string read_string(void)
+	{
+		std::string result(read_size(), '\0');
+		if(!result.empty())
+		{
+			read_bytes(&result[0], result.size());
+		}
+		return result;
+	}
+
+	// starts reading a block of count values of type T
+	template <typename T>
+	void begin_values(std::size_t count)
+	{
+		const std::size_t size = read_size();
+		align();
+		if(snapshot_raw<T>::value)
+		{
+			if(size != count*sizeof(T))
+			{
+				throw std::invalid_argument(
+					"exces::load_snapshot: "
+					"value block size mismatch"
+				);
+			}
+		}
+		else
+		{
+			std::string buffer(size, '\0');
+			if(size != 0) read_bytes(&buffer[0], size);
+			_values.str(std::move(buffer));
+			_values.clear();
+		}
+	}
+
+	void finish_values(void)
+	{
+		align();
+	}
+
+	// skips a block of values of unknown type
+	void skip_values(void)
+	{
+		const std::size_t size = read_size();
+		align();
+		skip(size);
+		align();
+	}
+
+	template <typename T>
+	T read_value(void)
+	{
+		if(snapshot_raw<T>::value)
+		{
+			T result = snapshot_serializer<T>::read(_input);
+			check();
+			_offset += sizeof(T);
+			return result;
+		}
+		else
+		{
+			T result = snapshot_serializer<T>::read(_values);
+			if(_values.fail())
+			{
+				throw std::invalid_argument(
+					"exces::load_snapshot: malformed value"
+				);
+			}
+			return result;
+		}
+	}
+
+	void read_header(void)
+	{
+		char magic[8];
+		read_bytes(magic, sizeof(magic));
+		if(std::memcmp(magic, "EXCESSNP", sizeof(magic)) != 0)
+		{
+			throw std::invalid_argument(
+				"exces::load_snapshot: not a snapshot"
+			);
+		}
+		if(read<std::uint32_t>() != snapshot_version)
+		{
+			throw std::invalid_argument(
+				"exces::load_snapshot: unsupported version"
+			);
+		}
+		if(	(read<std::uint32_t>() != 0x01020304) ||
+			(read<std::uint32_t>() != sizeof(int))
+		)
+		{
+			throw std::invalid_argument(
+				"exces::load_snapshot: incompatible platform"
+			);
+		}
+	}
+};
+
+} // namespace detail
+
+/// Writes the entities and components of manager m into output
+/** The snapshot contains the storages of all components in the Group,
+ *  identified by their names, followed by the entities, their component
+ *  bitsets and component keys. Trivially copyable components are written
+ *  as blocks of raw bytes, other components and entities are written
+ *  through their snapshot_serializer. The snapshot is not portable between
+ *  platforms with different byte order or size of int.
+ *
+ *  @see load_snapshot
+ *  @see snapshot_serializer
+ */
+template <typename Group>
+inline void save_snapshot(manager<Group>& m, std::ostream& output)
+{
+	m.save_snapshot(output);
+}
+
+/// Loads the entities and components from a snapshot into manager m
+/** The manager must not contain any entities. The component storages,
+ *  the entity map and component index map are rebuilt directly from
+ *  the snapshot and all collections registered with m are filled
+ *  with the loaded entities. Components are matched by their names,
+ *  so they may be registered in a different order than in the saved
+ *  manager. Components missing in the Group are skipped and removed
+ *  from the loaded entities.
+ *
+ *  @throws std::invalid_argument if the snapshot is malformed or
+ *  incompatible with the Group and std::runtime_error if it cannot
+ *  be read from input.
+ *
+ *  @see save_snapshot
+ */
+template <typename Group>
+inline void load_snapshot(manager<Group>& m, std::istream& input)
+{
+	m.load_snapshot(input);
+}
+
+} // namespace exces
+
+#endif //include guard
@@ -0,0 +1,524 @@
+/**
+ *  @file exces/snapshot_view.hpp
+ *  @brief Read-only view of a snapshot file mapped into memory
+ *
+ *  Copyright 2012-2014 Matus Chochlik. Distributed under the Boost
+ *  Software License, Version 1.0. (See accompanying file
+ *  LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef EXCES_SNAPSHOT_VIEW_1405211020_HPP
+#define EXCES_SNAPSHOT_VIEW_1405211020_HPP
+
+#include <exces/entity.hpp>
+#include <exces/storage.hpp>
+#include <exces/snapshot.hpp>
+#include <exces/iter_info.hpp>
+#include <exces/detail/mapped_file.hpp>
+
+#include <vector>
+#include <string>
+#include <functional>
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+
+namespace exces {
+
+/// Read-only view of the entities and components in a snapshot file
+/** The snapshot file (written by save_snapshot) is mapped into memory
+ *  and the entities and the instances of trivially copyable components
+ *  are accessed directly in the mapped pages, without loading them.
+ *  Opening a view only reads the directory of the snapshot, the pages are
+ *  loaded on demand and are shared with the page cache, so many processes
+ *  can view the same snapshot. The entity type of the Group must be written
+ *  as raw bytes by its snapshot_serializer (for example uintmax_entity).
+ *  Components are matched by their names like in load_snapshot and the
+ *  components that are not saved in the snapshot are treated as if no
+ *  entity had them.
+ *
+ *  All member functions are const and the view can be used concurrently
+ *  from multiple threads.
+ *
+ *  @see save_snapshot
+ */
+template <typename Group = default_group>
+class snapshot_view
+{
+public:
+	/// The type of entity used by the viewed snapshot
+	typedef typename entity<Group>::type entity_type;
+
+	/// Key for O(1) access to entity data (position of the entity)
+	typedef std::size_t entity_key;
+private:
+	static_assert(
+		detail::snapshot_raw<entity_type>::value,
+		"The entities of the snapshot_view must be written as raw bytes"
+	);
+
+	typedef mp::size<components<Group>> _component_count;
+
+	detail::mapped_file _file;
+
+	// the block of slots of a saved component
+	struct _section
+	{
+		// the position of the component in the snapshot
+		// (or _component_count if it was not saved)
+		std::size_t index;
+		std::size_t slot_count;
+		const int* neg_rc_or_nf;
+		// the slots of raw components (nullptr otherwise)
+		const char* components;
+	};
+	// the sections ordered by the ids of the components in Group
+	std::vector<_section> _sections;
+
+	std::size_t _entity_count;
+	const entity_type* _entities;
+	// the packed component bitsets of the entities
+	std::size_t _bit_bytes;
+	const unsigned char* _bits;
+	// the index of the first component key of each entity
+	const std::uint64_t* _key_offsets;
+	std::size_t _key_count;
+	const std::uint64_t* _keys;
+
+	// sequential reader of the mapped snapshot
+	class _cursor
+	{
+	private:
+		const char* _data;
+		std::size_t _size;
+		std::size_t _offset;
+	public:
+		_cursor(const char* data, std::size_t size)
+		 : _data(data)
+		 , _size(size)
+		 , _offset(0)
+		{ }
+
+		const char* take(std::size_t size)
+		{
+			if(size > _size-_offset)
+			{
+				throw std::invalid_argument(
+					"exces::snapshot_view: truncated snapshot"
+				);
+			}
+			const char* result = _data+_offset;
+			_offset += size;
+			return result;
+		}
+
+		// the size is checked before multiplying it by the size
+		// of an element so that it cannot overflow
+		const char* take(std::size_t count, std::size_t size)
+		{
+			if((size != 0) && (count > (_size-_offset)/size))
+			{
+				throw std::invalid_argument(
+					"exces::snapshot_view: truncated snapshot"
+				);
+			}
+			return take(count*size);
+		}
+
+		void align(void)
+		{
+			const std::size_t a = detail::snapshot_alignment;
+			take((a-_offset%a)%a);
+		}
+
+		template <typename T>
+		T read(void)
+		{
+			T result;
+			std::memcpy(&result, take(sizeof(T)), sizeof(T));
+			return result;
+		}
+
+		std::size_t read_size(void)
+		{
+			std::uint64_t size = read<std::uint64_t>();
+			if(size > std::uint64_t(_size))
+			{
+				throw std::invalid_argument(
+					"exces::snapshot_view: size out of range"
+				);
+			}
+			return std::size_t(size);
+		}
+
+		std::string read_string(void)
+		{
+			std::size_t size = read_size();
+			return std::string(take(size), size);
+		}
+	};
+
+	// collects the sizes of the raw slots (zero for the other components)
+	struct _slot_size_collector
+	{
+		std::vector<std::size_t>& result;
+
+		template <typename Component>
+		void operator()(mp::identity<Component>) const
+		{
+			result[component_id<Component, Group>::value] =
+				detail::snapshot_raw<Component>::value?
+				sizeof(Component):0;
+		}
+	};
+
+	void _parse(void);
+
+	static void _missing(void)
+	{
+		throw std::invalid_argument(
+			"exces::snapshot_view: "
+			"the entity does not have the requested component"
+		);
+	}
+
+	template <typename Component>
+	const _section& _section_of(void) const
+	{
+		return _sections[component_id<Component, Group>::value];
+	}
+
+	bool _has_bit(entity_key k, std::size_t i) const
+	{
+		assert(k < _entity_count);
+		return (_bits[k*_bit_bytes+i/8] & (1 << (i%8))) != 0;
+	}
+
+	// the key of the i-th saved component of the entity k
+	std::size_t _key_of(entity_key k, std::size_t i) const
+	{
+		const unsigned char* bytes = _bits+k*_bit_bytes;
+		std::size_t rank = 0;
+		for(std::size_t b=0; b!=i/8; ++b)
+		{
+			for(unsigned char byte=bytes[b]; byte; byte &= byte-1)
+			{
+				++rank;
+			}
+		}
+		unsigned char byte = bytes[i/8] & ((1 << (i%8))-1);
+		for(; byte; byte &= byte-1) ++rank;
+
+		const std::uint64_t pos = _key_offsets[k]+rank;
+		if(pos >= _key_count)
+		{
+			throw std::invalid_argument(
+				"exces::snapshot_view: invalid component key"
+			);
+		}
+		return std::size_t(_keys[pos]);
+	}
+public:
+	/// Maps the snapshot file at the specified path
+	/**
+	 *  @throws std::runtime_error if the file cannot be mapped and
+	 *  std::invalid_argument if it is not a valid snapshot or if
+	 *  the layout of the components does not match.
+	 */
+	explicit snapshot_view(const std::string& path)
+	 : _file(path)
+	 , _entity_count(0)
+	 , _entities(nullptr)
+	 , _bit_bytes(0)
+	 , _bits(nullptr)
+	 , _key_offsets(nullptr)
+	 , _key_count(0)
+	 , _keys(nullptr)
+	{
+		_parse();
+	}
+
+	snapshot_view(const snapshot_view&) = delete;
+
+	/// Returns the number of entities in the snapshot
+	std::size_t size(void) const
+	{
+		return _entity_count;
+	}
+
+	/// Returns true if the snapshot contains the specified entity
+	bool has_key(entity_type e) const
+	{
+		const entity_type* p = std::lower_bound(
+			_entities,
+			_entities+_entity_count,
+			e
+		);
+		return (p != _entities+_entity_count) && (*p == e);
+	}
+
+	/// Get a key for O(1) access to the specified entity
+	/**
+	 *  @throws std::invalid_argument if the entity is not in the snapshot
+	 *
+	 *  @see has_key
+	 */
+	entity_key get_key(entity_type e) const
+	{
+		const entity_type* p = std::lower_bound(
+			_entities,
+			_entities+_entity_count,
+			e
+		);
+		if((p == _entities+_entity_count) || !(*p == e))
+		{
+			throw std::invalid_argument(
+				"exces::snapshot_view: "
+				"requested entity not found"
+			);
+		}
+		return entity_key(p-_entities);
+	}
+
+	/// Get the entity pointed to by key
+	entity_type get_entity(entity_key k) const
+	{
+		assert(k < _entity_count);
+		return _entities[k];
+	}
+
+	/// Returns true if the entity has the specified Component
+	template <typename Component>
+	bool has(entity_key k) const
+	{
+		const _section& s = _section_of<Component>();
+		if(s.index == _component_count::value) return false;
+		return _has_bit(k, s.index);
+	}
+
+	/// Returns true if the entity has the specified Component
+	template <typename Component>
+	bool has(entity_type e) const
+	{
+		return has_key(e) && has<Component>(get_key(e));
+	}
+
+	/// Returns a reference to the Component of the entity in the snapshot
+	/**
+	 *  @throws std::invalid_argument if the entity does not have
+	 *  the Component.
+	 */
+	template <typename Component>
+	const Component& cref(entity_key k) const
+	{
+		static_assert(
+			detail::snapshot_raw<Component>::value,
+			"Only trivially copyable components can be viewed"
+		);
+		const _section& s = _section_of<Component>();
+		if(!has<Component>(k)) _missing();
+
+		const std::size_t key = _key_of(k, s.index);
+		if((key >= s.slot_count) || (s.neg_rc_or_nf[key] >= 0))
+		{
+			throw std::invalid_argument(
+				"exces::snapshot_view: invalid component key"
+			);
+		}
+		return reinterpret_cast<const Component*>(s.components)[key];
+	}
+
+	/// Returns a reference to the Component of the entity in the snapshot
+	template <typename Component>
+	const Component& cref(entity_type e) const
+	{
+		return cref<Component>(get_key(e));
+	}
+
+	/// Returns a copy of the Component of the entity in the snapshot
+	template <typename Component>
+	Component read(entity_key k) const
+	{
+		return cref<Component>(k);
+	}
+
+	/// Returns a copy of the Component of the entity in the snapshot
+	template <typename Component>
+	Component read(entity_type e) const
+	{
+		return cref<Component>(get_key(e));
+	}
+
+	/// Calls the specified function on each entity in the snapshot
+	const snapshot_view& for_each(
+		const std::function<bool (
+			const iter_info&,
+			const snapshot_view&,
+			entity_key
+		)>& function
+	) const
+	{
+		iter_info ii(_entity_count);
+		for(entity_key k=0; k!=_entity_count; ++k)
+		{
+			if(!function(ii, *this, k)) break;
+			ii.step();
+		}
+		return *this;
+	}
+
+	/// Calls the specified function on every instance of Component
+	template <typename Component>
+	const snapshot_view& for_each(
+		const std::function<bool (const Component&)>& function
+	) const
+	{
+		static_assert(
+			detail::snapshot_raw<Component>::value,
+			"Only trivially copyable components can be viewed"
+		);
+		const _section& s = _section_of<Component>();
+		const Component* components =
+			reinterpret_cast<const Component*>(s.components);
+		for(std::size_t i=0; i!=s.slot_count; ++i)
+		{
+			if(s.neg_rc_or_nf[i] < 0)
+			{
+				if(!function(components[i])) break;
+			}
+		}
+		return *this;
+	}
+};
+
+template <typename Group>
+void
+snapshot_view<Group>::
+_parse(void)
+{
+	_cursor cur(_file.data(), _file.size());
+
+	if(std::memcmp(cur.take(8), "EXCESSNP", 8) != 0)
+	{
+		throw std::invalid_argument(
+			"exces::snapshot_view: not a snapshot"
+		);
+	}
+	if(cur.read<std::uint32_t>() != detail::snapshot_version)
+	{
+		throw std::invalid_argument(
+			"exces::snapshot_view: unsupported version"
+		);
+	}
+	if(	(cur.read<std::uint32_t>() != 0x01020304) ||
+		(cur.read<std::uint32_t>() != sizeof(int))
+	)
+	{
+		throw std::invalid_argument(
+			"exces::snapshot_view: incompatible platform"
+		);
+	}
+
+	const std::vector<std::string> names =
+		component_storage<Group>::names();
+	std::vector<std::size_t> slot_sizes(_component_count::value);
+	_slot_size_collector collector = { slot_sizes };
+	mp::for_each<typename components<Group>::type>(collector);
+
+	_section none = { _component_count::value, 0, nullptr, nullptr };
+	_sections.assign(_component_count::value, none);
+
+	const std::size_t saved_count = cur.read_size();
+	std::vector<std::size_t> ids(saved_count, _component_count::value);
+	for(std::size_t i=0; i!=saved_count; ++i)
+	{
+		const std::string name = cur.read_string();
+		auto p = std::find(names.begin(), names.end(), name);
+		if(p != names.end())
+		{
+			ids[i] = std::size_t(p-names.begin());
+		}
+	}
+
+	// the component storages
+	for(std::size_t i=0; i!=saved_count; ++i)
+	{
+		_section s = { i, 0, nullptr, nullptr };
+		s.slot_count = cur.read_size();
+		const std::size_t slot_size = cur.read<std::uint32_t>();
+		cur.read<std::uint32_t>();
+		cur.align();
+		s.neg_rc_or_nf = reinterpret_cast<const int*>(
+			cur.take(s.slot_count, sizeof(int))
+		);
+		cur.align();
+		if(slot_size != 0)
+		{
+			s.components = cur.take(s.slot_count, slot_size);
+			cur.align();
+		}
+		else
+		{
+			const std::size_t size = cur.read_size();
+			cur.align();
+			cur.take(size);
+			cur.align();
+		}
+
+		const std::size_t id = ids[i];
+		if(id == _component_count::value) continue;
+		if(slot_size != slot_sizes[id])
+		{
+			throw std::invalid_argument(
+				"exces::snapshot_view: the layout of component '"+
+				names[id]+"' does not match"
+			);
+		}
+		if(_sections[id].index != _component_count::value)
+		{
+			throw std::invalid_argument(
+				"exces::snapshot_view: duplicate component '"+
+				names[id]+"'"
+			);
+		}
+		_sections[id] = s;
+	}
+
+	// the entities
+	_entity_count = cur.read_size();
+	if(cur.read_size()/sizeof(entity_type) != _entity_count)
+	{
+		throw std::invalid_argument(
+			"exces::snapshot_view: value block size mismatch"
+		);
+	}
+	cur.align();
+	_entities = reinterpret_cast<const entity_type*>(
+		cur.take(_entity_count, sizeof(entity_type))
+	);
+	cur.align();
+
+	// the component bitsets
+	_bit_bytes = (saved_count+7)/8;
+	_bits = reinterpret_cast<const unsigned char*>(
+		cur.take(_entity_count, _bit_bytes)
+	);
+	cur.align();
+
+	// the component keys
+	_key_count = cur.read_size();
+	cur.align();
+	_key_offsets = reinterpret_cast<const std::uint64_t*>(
+		cur.take(_entity_count, sizeof(std::uint64_t))
+	);
+	cur.align();
+	_keys = reinterpret_cast<const std::uint64_t*>(
+		cur.take(_key_count, sizeof(std::uint64_t))
+	);
+}
+
+} // namespace exces
+
+#endif //include guard
@@ -15,8 +15,16 @@
 #include <exces/metaprog.hpp>
 #include <exces/fwd.hpp>
 
+#include <exces/manager_stats.hpp>
+#include <exces/memory_stats.hpp>
+#include <exces/snapshot.hpp>
+#include <exces/detail/cache_aligned.hpp>
+
 #include <cassert>
 #include <functional>
+#include <typeinfo>
+#include <string>
+#include <vector>
 
 namespace exces {
 namespace detail {
@@ -38,6 +46,47 @@ struct component_kind_storage_locking<Group, Component, component_kind_backbuf>
 
 } // namespace detail
 
+// Returns the registered name of the Component or the name from type_info
+template <typename Component>
+inline auto component_storage_name(int)
+ -> decltype(component_name<Component>::c_str())
+{
+	return component_name<Component>::c_str();
+}
+
+template <typename Component>
+inline const char* component_storage_name(...)
+{
+	return typeid(Component).name();
+}
+
+/// Options of the storage of components registered as mapped
+/** This template can be specialized for a particular Component
+ *  and Group to change the options.
+ *
+ *  @see #EXCES_REG_MAPPED_COMPONENT
+ */
+template <typename Component, typename Group = default_group>
+struct component_mapping
+{
+	/// The size of the virtual memory range reserved for the instances
+	/** Only the used part of the range is committed. The storage
+	 *  cannot grow beyond this size.
+	 */
+	static std::size_t reserved_bytes(void)
+	{
+		return (sizeof(void*) < 8)?
+			(std::size_t(1) << 28):
+			(std::size_t(1) << 36);
+	}
+
+	/// Indicates if the use of transparent huge pages should be advised
+	static bool huge_pages(void)
+	{
+		return true;
+	}
+};
+
 template <typename Group, typename Component>
 struct component_storage_locking
  : detail::component_kind_storage_locking<
@@ -47,9 +96,37 @@ struct component_storage_locking
 >
 { };
 
+/// Contiguous block of components in a component storage vector
+/** The block may contain slots of released components, which must be skipped
+ *  during traversal, use the is_live member function to check if a slot
+ *  contains a live component.
+ */
+template <typename Component>
+struct component_block
+{
+	/// Pointer to the first component in the block
+	Component* components;
+
+	// implementation detail, do not use directly
+	const int* _neg_rc_or_nf;
+
+	/// The number of slots in the block
+	std::size_t size;
+
+	/// Returns true if the i-th slot contains a live component
+	bool is_live(std::size_t i) const
+	{
+		assert(i < size);
+		return _neg_rc_or_nf[i] < 0;
+	}
+};
+
 // Interface for component storage vectors of component_storage
+// the storage vectors may contain cache line aligned mutexes
 template <typename Group, typename Component>
-struct component_storage_vector : lock_intf
+struct component_storage_vector
+ : lock_intf
+ , detail::cache_aligned_new
 {
 	typedef component_storage_locking<Group, Component> _locking;
 	typedef typename _locking::shared_lock shared_lock;
@@ -76,6 +153,17 @@ struct component_storage_vector : lock_intf
 	virtual bool release(component_key) = 0;
 
 	virtual void for_each(const std::function<bool (Component&)>&) = 0;
+
+	virtual component_block<Component> block(void) = 0;
+
+	virtual component_memory_stats memory_stats(void) = 0;
+
+	virtual std::size_t shrink_to_fit(void) = 0;
+
+	virtual void save(detail::snapshot_writer&) = 0;
+	virtual void load(detail::snapshot_reader&) = 0;
+	virtual void clear(void) = 0;
+	virtual bool check_keys(const std::vector<component_key>&) = 0;
 };
 
 template <typename Group>
@@ -122,6 +210,107 @@ private:
 		return *_pcsv;
 	}
 
+	struct _memory_stats_collector
+	{
+		component_storage& storage;
+		std::vector<component_memory_stats>& result;
+
+		template <typename Component>
+		void operator()(mp::identity<Component>) const
+		{
+			result.push_back(
+				storage.template memory_stats<Component>()
+			);
+		}
+	};
+
+	struct _shrinker
+	{
+		component_storage& storage;
+		std::size_t& result;
+
+		template <typename Component>
+		void operator()(mp::identity<Component>) const
+		{
+			result += storage.template shrink_to_fit<Component>();
+		}
+	};
+
+	struct _name_collector
+	{
+		std::vector<std::string>& result;
+
+		template <typename Component>
+		void operator()(mp::identity<Component>) const
+		{
+			result[component_id<Component, Group>::value] =
+				component_storage_name<Component>(0);
+		}
+	};
+
+	struct _saver
+	{
+		component_storage& storage;
+		detail::snapshot_writer& output;
+		const std::size_t id;
+
+		template <typename Component>
+		void operator()(mp::identity<Component>) const
+		{
+			if(component_id<Component, Group>::value == id)
+			{
+				storage.template _store_of<Component>()
+					.save(output);
+			}
+		}
+	};
+
+	struct _loader
+	{
+		component_storage& storage;
+		detail::snapshot_reader& input;
+		const std::size_t id;
+
+		template <typename Component>
+		void operator()(mp::identity<Component>) const
+		{
+			if(component_id<Component, Group>::value == id)
+			{
+				storage.template _store_of<Component>()
+					.load(input);
+			}
+		}
+	};
+
+	struct _clearer
+	{
+		component_storage& storage;
+
+		template <typename Component>
+		void operator()(mp::identity<Component>) const
+		{
+			storage.template _store_of<Component>().clear();
+		}
+	};
+
+	struct _key_checker
+	{
+		component_storage& storage;
+		const std::vector<std::size_t>& keys;
+		const std::size_t id;
+		bool& result;
+
+		template <typename Component>
+		void operator()(mp::identity<Component>) const
+		{
+			if(component_id<Component, Group>::value == id)
+			{
+				result = storage.template _store_of<Component>()
+					.check_keys(keys);
+			}
+		}
+	};
+
 	template <typename Component>
 	static
 	typename component_locking<Group, Component>::shared_lock
@@ -215,6 +404,10 @@ public:
 	template <typename Component>
 	component_key store(Component&& component)
 	{
+		EXCES_MANAGER_STATS_SCOPE(
+			std::string(component_storage_name<Component>(0))+
+			"::store"
+		)
 		return _store_of<Component>()
 			.store(std::move(component));
 	}
@@ -247,6 +440,10 @@ public:
 	template <typename Component>
 	bool release(component_key key)
 	{
+		EXCES_MANAGER_STATS_SCOPE(
+			std::string(component_storage_name<Component>(0))+
+			"::release"
+		)
 		return _store_of<Component>()
 			.release(key);
 	}
@@ -258,6 +455,109 @@ public:
 			.for_each(function);
 	}
 
+	/// Returns the block of all stored instances of Component
+	/** The returned block is valid only until the next modification
+	 *  of the storage of Component.
+	 */
+	template <typename Component>
+	component_block<Component> block(void)
+	{
+		return _store_of<Component>()
+			.block();
+	}
+
+	/// Returns the memory statistics of the storage of Component
+	template <typename Component>
+	component_memory_stats memory_stats(void)
+	{
+		component_memory_stats result = _store_of<Component>()
+			.memory_stats();
+		result.name = component_storage_name<Component>(0);
+		return result;
+	}
+
+	/// Returns the memory statistics of the storages of all Components
+	std::vector<component_memory_stats> memory_stats(void)
+	{
+		std::vector<component_memory_stats> result;
+		_memory_stats_collector collector = { *this, result };
+		mp::for_each<typename components<Group>::type>(collector);
+		return result;
+	}
+
+	/// Releases the unused memory of the storage of Component
+	/** Releases the free slots at the end of the storage and the unused
+	 *  capacity. The keys of the live components do not change, so the
+	 *  free slots between them stay allocated. Nothing is released while
+	 *  the storage is locked for traversal.
+	 *
+	 *  @return the number of bytes reclaimed.
+	 */
+	template <typename Component>
+	std::size_t shrink_to_fit(void)
+	{
+		return _store_of<Component>()
+			.shrink_to_fit();
+	}
+
+	/// Releases the unused memory of the storages of all Components
+	/**
+	 *  @return the number of bytes reclaimed.
+	 */
+	std::size_t shrink_to_fit(void)
+	{
+		std::size_t result = 0;
+		_shrinker shrinker = { *this, result };
+		mp::for_each<typename components<Group>::type>(shrinker);
+		return result;
+	}
+
+	/// Returns the names of the Components ordered by their ids
+	static std::vector<std::string> names(void)
+	{
+		std::vector<std::string> result(
+			mp::size<components<Group>>::value
+		);
+		_name_collector collector = { result };
+		mp::for_each<typename components<Group>::type>(collector);
+		return result;
+	}
+
+	/// Writes the storage of the Component with the specified id
+	void save(std::size_t id, detail::snapshot_writer& output)
+	{
+		_saver saver = { *this, output, id };
+		mp::for_each<typename components<Group>::type>(saver);
+	}
+
+	/// Replaces the storage of the Component with the specified id
+	void load(std::size_t id, detail::snapshot_reader& input)
+	{
+		_loader loader = { *this, input, id };
+		mp::for_each<typename components<Group>::type>(loader);
+	}
+
+	/// Removes all instances of all Components
+	/** Used to roll back a snapshot which failed to load.
+	 */
+	void clear(void)
+	{
+		_clearer clearer = { *this };
+		mp::for_each<typename components<Group>::type>(clearer);
+	}
+
+	/// Checks the keys referring to the Component with the specified id
+	/** Returns true if all keys refer to live instances and none of
+	 *  the instances is referred to by more keys than its reference count.
+	 */
+	bool check_keys(std::size_t id, const std::vector<component_key>& keys)
+	{
+		bool result = false;
+		_key_checker checker = { *this, keys, id, result };
+		mp::for_each<typename components<Group>::type>(checker);
+		return result;
+	}
+
 	template <typename Component>
 	void mark_write(component_key key)
 	{
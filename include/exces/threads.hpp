@@ -13,6 +13,7 @@
 #include <exces/group.hpp>
 #include <mutex>
 #include <exces/shared_mutex.hpp> // TODO: use C++14 if available
+#include <exces/read_mostly_mutex.hpp>
 #include <cassert>
 
 namespace exces {
@@ -95,6 +96,9 @@ struct fake_component_locking
 	{
 		func(std::forward<Args>(args)...);
 	}
+
+	template <typename Mutex>
+	static void name_mutex(Mutex&, const char*, const char*) { }
 };
 
 struct std_component_locking
@@ -134,6 +138,34 @@ struct std_component_locking
 		);
 	}
 
+	template <typename Mutex>
+	static void name_mutex(Mutex&, const char*, const char*) { }
+};
+
+/// Locking policy using reader-biased mutexes for read-mostly workloads
+/** This policy can be selected for a component group by specializing
+ *  the group_locking template:
+ *
+ *  @code
+ *  namespace exces {
+ *  template <>
+ *  struct group_locking<my_group>
+ *   : read_mostly_component_locking
+ *  { };
+ *  } // namespace exces
+ *  @endcode
+ *
+ *  @see read_mostly_shared_mutex
+ *  @see std_component_locking
+ */
+struct read_mostly_component_locking
+ : std_component_locking
+{
+	typedef read_mostly_shared_mutex shared_mutex;
+
+	typedef std::unique_lock<shared_mutex> unique_lock;
+
+	typedef exces::shared_lock<shared_mutex> shared_lock;
 };
 
 template <typename Group>
@@ -229,7 +261,7 @@ public:
 	 : _pimpl(nullptr)
 	{ }
 
-	poly_lock(poly_lock&& tmp)
+	poly_lock(poly_lock&& tmp) noexcept
 	 : _pimpl(tmp._pimpl)
 	{
 		tmp._pimpl = nullptr;
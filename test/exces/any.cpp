@@ -0,0 +1,295 @@
+/**
+ *  .file test/exces/any.cpp
+ *  .brief Test case for the type erased manager
+ *
+ *  .author Matus Chochlik
+ *
+ *  Copyright 2011-2014 Matus Chochlik. Distributed under the Boost
+ *  Software License, Version 1.0. (See accompanying file
+ *  LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE EXCES_Any
+#include <boost/test/unit_test.hpp>
+
+#include <exces/simple.hpp>
+#include <exces/any.hpp>
+
+#include <string>
+#include <vector>
+#include <memory>
+
+struct position { float x, y; };
+EXCES_REG_NAMED_COMPONENT(position)
+
+struct velocity { float dx, dy; };
+EXCES_REG_NAMED_COMPONENT(velocity)
+
+struct name { std::string str; };
+EXCES_REG_NAMED_COMPONENT(name)
+
+struct tag { int kind; };
+EXCES_REG_NAMED_COMPONENT(tag)
+
+#include <exces/implement.hpp>
+
+typedef exces::entity<>::type entity_t;
+
+BOOST_AUTO_TEST_SUITE(Any)
+
+BOOST_AUTO_TEST_CASE(Any_component_by_name)
+{
+	typedef exces::component_index<> index;
+
+	BOOST_CHECK_EQUAL(
+		index::by_name("position"),
+		(exces::component_id<position>::value)
+	);
+	BOOST_CHECK_EQUAL(
+		index::by_name("velocity"),
+		(exces::component_id<velocity>::value)
+	);
+	BOOST_CHECK_EQUAL(
+		index::by_name("name"),
+		(exces::component_id<name>::value)
+	);
+	BOOST_CHECK_EQUAL(
+		index::by_name("tag"),
+		(exces::component_id<tag>::value)
+	);
+	BOOST_CHECK_EQUAL(index::by_name("position", 3), ~std::size_t(0));
+	BOOST_CHECK_EQUAL(index::by_name("tags"), ~std::size_t(0));
+	BOOST_CHECK_EQUAL(index::by_name(""), ~std::size_t(0));
+}
+
+BOOST_AUTO_TEST_CASE(Any_component_id)
+{
+	std::vector<entity_t> e(3);
+	exces::manager<> m;
+	exces::any_manager<> am(m);
+
+	const exces::any_component_id pos = am.component_id("position");
+	const exces::any_component_id nme = am.component_id<name>();
+	const exces::any_component_id none = am.component_id("nothing");
+
+	BOOST_CHECK(pos.is_valid());
+	BOOST_CHECK(nme.is_valid());
+	BOOST_CHECK(!none.is_valid());
+	BOOST_CHECK(pos == am.component_id<position>());
+	BOOST_CHECK(pos != nme);
+
+	position p = { 1, 2 };
+	am.add(e[0], p, name{"first"});
+	am.add_raw(am.get_key(e[1]), pos, &p);
+
+	BOOST_CHECK(am.has(e[0], pos));
+	BOOST_CHECK(am.has(e[0], nme));
+	BOOST_CHECK(am.has(e[1], pos));
+	BOOST_CHECK(!am.has(e[1], nme));
+	BOOST_CHECK(!am.has(e[2], pos));
+	BOOST_CHECK(!am.has(e[0], none));
+
+	exces::any_entity_key k0 = am.get_key(e[0]);
+	BOOST_CHECK(am.has<position>(k0));
+	BOOST_CHECK((am.has_all<position, name>(k0)));
+	BOOST_CHECK((!am.has_all<position, velocity>(k0)));
+	BOOST_CHECK((am.has_some<velocity, name>(k0)));
+
+	BOOST_CHECK_EQUAL(am.raw_access<position>(k0, pos).y, 2);
+	BOOST_CHECK_EQUAL(am.raw_access<name>(k0, nme).str, "first");
+	BOOST_CHECK(am.raw_access(k0, none) == nullptr);
+	BOOST_CHECK_EQUAL(am.rw<name>(k0).str, "first");
+
+	{
+		exces::any_lock l = am.raw_access_lock(pos);
+		l.lock();
+		am.raw_access<position>(k0, pos).x = 3;
+		l.unlock();
+	}
+	BOOST_CHECK_EQUAL(m.rw<position>(e[0]).x, 3);
+
+	am.remove(k0, nme);
+	BOOST_CHECK(!m.has<name>(e[0]));
+	am.remove<position>(e[1]);
+	BOOST_CHECK(!m.has<position>(e[1]));
+
+	am.copy<position>(e[0], e[2]);
+	BOOST_CHECK_EQUAL(m.rw<position>(e[2]).x, 3);
+}
+
+BOOST_AUTO_TEST_CASE(Any_batches)
+{
+	const std::size_t n = 100;
+	std::vector<entity_t> e(n);
+	exces::manager<> m;
+	exces::any_manager<> am(m);
+
+	std::vector<exces::any_entity_key> keys;
+	for(std::size_t i=0; i!=n; ++i)
+	{
+		keys.push_back(am.get_key(e[i]));
+	}
+
+	std::vector<position> ps(n);
+	std::vector<velocity> vs(n);
+	for(std::size_t i=0; i!=n; ++i)
+	{
+		ps[i].x = float(i);
+		vs[i].dx = -float(i);
+	}
+	am.add_n(keys.data(), n, ps.data(), vs.data());
+	BOOST_CHECK_EQUAL(m.rw<position>(e[42]).x, 42);
+	BOOST_CHECK_EQUAL(m.rw<velocity>(e[42]).dx, -42);
+
+	std::vector<name> ns(n/2);
+	for(std::size_t i=0; i!=n/2; ++i)
+	{
+		ns[i].str = std::to_string(i);
+	}
+	const exces::any_component_id nme = am.component_id<name>();
+	void* const arrays[] = { ns.data() };
+	am.add_n(keys.data(), n/2, &nme, 1, arrays);
+	BOOST_CHECK_EQUAL(m.rw<name>(e[7]).str, "7");
+
+	std::unique_ptr<bool[]> has(new bool[n]);
+	am.has_all_n<position, name>(keys.data(), n, has.get());
+	for(std::size_t i=0; i!=n; ++i)
+	{
+		BOOST_CHECK_EQUAL(has[i], i < n/2);
+	}
+
+	std::vector<velocity*> pvs(n);
+	am.raw_access_n(keys.data(), n, pvs.data());
+	for(std::size_t i=0; i!=n; ++i)
+	{
+		BOOST_ASSERT(pvs[i] != nullptr);
+		BOOST_CHECK_EQUAL(pvs[i]->dx, -float(i));
+	}
+
+	am.remove_n<velocity, name>(keys.data(), n/2);
+	am.has_all_n<velocity>(keys.data(), n, has.get());
+	for(std::size_t i=0; i!=n; ++i)
+	{
+		BOOST_CHECK_EQUAL(has[i], i >= n/2);
+		BOOST_CHECK_EQUAL(m.has<name>(e[i]), false);
+		BOOST_CHECK(m.has<position>(e[i]));
+	}
+}
+
+BOOST_AUTO_TEST_CASE(Any_column)
+{
+	const std::size_t n = 100;
+	std::vector<entity_t> e(n);
+	exces::manager<> m;
+	exces::any_manager<> am(m);
+
+	for(std::size_t i=0; i!=n; ++i)
+	{
+		position p = { float(i), float(2*i) };
+		m.add(e[i], p);
+	}
+	for(std::size_t i=0; i<n; i += 10)
+	{
+		m.remove<position>(e[i]);
+	}
+
+	BOOST_CHECK(am.column(am.component_id("nothing")).empty());
+	BOOST_CHECK(am.column<velocity>().empty());
+
+	auto ra_lock = am.raw_access_lock(am.component_id<position>());
+	ra_lock.lock();
+
+	exces::any_component_column col = am.column<position>();
+	BOOST_CHECK_EQUAL(col.count(), n-n/10);
+	BOOST_CHECK(col.size() <= n/10+1);
+
+	std::size_t count = 0;
+	for(const exces::any_component_chunk& chunk : col)
+	{
+		BOOST_CHECK_EQUAL(chunk.stride, sizeof(position));
+		const position* ps = static_cast<const position*>(chunk.base);
+		for(std::size_t i=0; i!=chunk.count; ++i)
+		{
+			const entity_t ent = am.get_entity(chunk.keys[i]);
+			BOOST_CHECK_EQUAL(ps[i].x, m.rw<position>(ent).x);
+			BOOST_CHECK_EQUAL(ps[i].y, 2*ps[i].x);
+			BOOST_CHECK(chunk.at(i) == &ps[i]);
+		}
+		count += chunk.count;
+	}
+	BOOST_CHECK_EQUAL(count, col.count());
+
+	// modifications through the column are visible in the manager
+	static_cast<position*>(col[0].base)->y = -1;
+	ra_lock.unlock();
+	BOOST_CHECK_EQUAL(am.rw<position>(col[0].keys[0]).y, -1);
+}
+
+struct counting_lock
+{
+	int* count;
+
+	void lock(void) { ++*count; }
+	bool try_lock(void) { ++*count; return true; }
+	void unlock(void) { --*count; }
+};
+
+struct big_counting_lock
+ : counting_lock
+{
+	char padding[256];
+};
+
+BOOST_AUTO_TEST_CASE(Any_lock)
+{
+	exces::manager<> m;
+
+	BOOST_CHECK(exces::any_lock::is_stored_in_place<
+		decltype(m.raw_access_lock<position>())
+	>());
+	BOOST_CHECK(exces::any_lock::is_stored_in_place<
+		decltype(m.lifetime_lock<position, name>())
+	>());
+	BOOST_CHECK(exces::any_lock::is_stored_in_place<counting_lock>());
+	BOOST_CHECK(!exces::any_lock::is_stored_in_place<big_counting_lock>());
+
+	int count = 0;
+	counting_lock cl = { &count };
+	big_counting_lock bcl;
+	bcl.count = &count;
+
+	exces::any_lock l1(cl);
+	exces::any_lock l2(bcl);
+	exces::any_lock l3(
+		counting_lock(cl),
+		m.raw_access_lock<position>(),
+		m.lifetime_lock<name>()
+	);
+
+	l1.lock();
+	BOOST_CHECK_EQUAL(count, 1);
+	l2.lock();
+	BOOST_CHECK_EQUAL(count, 2);
+	BOOST_CHECK(l3.try_lock());
+	BOOST_CHECK_EQUAL(count, 3);
+	l3.unlock();
+	BOOST_CHECK_EQUAL(count, 2);
+
+	// moving preserves both in-place and heap allocated lockables
+	exces::any_lock l4(std::move(l1));
+	exces::any_lock l5;
+	l5 = std::move(l2);
+	l4.unlock();
+	l5.unlock();
+	BOOST_CHECK_EQUAL(count, 0);
+
+	l4.swap(l5);
+	l4.lock();
+	l5.lock();
+	BOOST_CHECK_EQUAL(count, 2);
+	l4.unlock();
+	l5.unlock();
+	BOOST_CHECK_EQUAL(count, 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,115 @@
+/**
+ *  .file test/exces/bitset.cpp
+ *  .brief Test case for the fixed-width component bitset
+ *
+ *  .author Matus Chochlik
+ *
+ *  Copyright 2011-2014 Matus Chochlik. Distributed under the Boost
+ *  Software License, Version 1.0. (See accompanying file
+ *  LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE EXCES_Bitset
+#include <boost/test/unit_test.hpp>
+
+#include <exces/detail/bitset.hpp>
+
+#include <bitset>
+#include <vector>
+#include <random>
+
+typedef exces::detail::fixed_bitset<200> bits_t;
+typedef std::bitset<200> ref_t;
+
+static void random_bits(std::mt19937& rng, bits_t& b, ref_t& r)
+{
+	std::uniform_int_distribution<int> dist(0, 3);
+	for(std::size_t i=0; i!=b.size(); ++i)
+	{
+		bool v = (dist(rng) == 0);
+		b.set(i, v);
+		r.set(i, v);
+	}
+}
+
+static bool same(const bits_t& b, const ref_t& r)
+{
+	for(std::size_t i=0; i!=b.size(); ++i)
+	{
+		if(b[i] != r[i]) return false;
+	}
+	return b.count() == r.count();
+}
+
+BOOST_AUTO_TEST_SUITE(Bitset)
+
+BOOST_AUTO_TEST_CASE(Bitset_basic)
+{
+	bits_t b;
+	BOOST_CHECK_EQUAL(b.size(), 200);
+	BOOST_CHECK(b.none());
+	BOOST_CHECK_EQUAL(b.count(), 0);
+
+	b.set(0).set(63).set(64).set(199);
+	BOOST_CHECK(b.any());
+	BOOST_CHECK_EQUAL(b.count(), 4);
+	BOOST_CHECK(b.test(63) && b.test(64) && b[199]);
+	BOOST_CHECK(!b.test(1) && !b.test(198));
+
+	BOOST_CHECK_EQUAL(b.rank(0), 0);
+	BOOST_CHECK_EQUAL(b.rank(63), 1);
+	BOOST_CHECK_EQUAL(b.rank(64), 2);
+	BOOST_CHECK_EQUAL(b.rank(65), 3);
+	BOOST_CHECK_EQUAL(b.rank(200), 4);
+
+	std::vector<std::size_t> set;
+	b.for_each_set([&set](std::size_t i) { set.push_back(i); });
+	BOOST_CHECK_EQUAL(set.size(), 4);
+	BOOST_CHECK_EQUAL(set[1], 63);
+	BOOST_CHECK_EQUAL(set[3], 199);
+
+	b.reset(63);
+	BOOST_CHECK(!b.test(63));
+	BOOST_CHECK_EQUAL((~b).count(), 197);
+	BOOST_CHECK_EQUAL(bits_t().set().count(), 200);
+	BOOST_CHECK(b.reset().none());
+}
+
+BOOST_AUTO_TEST_CASE(Bitset_ops)
+{
+	std::mt19937 rng(42);
+	for(int n=0; n!=100; ++n)
+	{
+		bits_t a, b;
+		ref_t ra, rb;
+		random_bits(rng, a, ra);
+		random_bits(rng, b, rb);
+
+		BOOST_CHECK(same(a & b, ra & rb));
+		BOOST_CHECK(same(a | b, ra | rb));
+		BOOST_CHECK(same(a ^ b, ra ^ rb));
+		BOOST_CHECK(same(~a, ~ra));
+		BOOST_CHECK(same(bits_t(a).and_not(b), ra & ~rb));
+
+		BOOST_CHECK_EQUAL(a.contains(b), (ra & rb) == rb);
+		BOOST_CHECK(a.contains(a & b));
+		BOOST_CHECK_EQUAL(a.intersects(b), (ra & rb).any());
+		BOOST_CHECK_EQUAL(a.matches(b, a & b), true);
+		BOOST_CHECK_EQUAL(a.matches(b, b), (ra & rb) == rb);
+
+		for(std::size_t i=0; i<=a.size(); i += 13)
+		{
+			std::size_t rank = 0;
+			for(std::size_t j=0; j!=i; ++j) rank += ra[j];
+			BOOST_CHECK_EQUAL(a.rank(i), rank);
+		}
+
+		BOOST_CHECK_EQUAL(a == b, ra == rb);
+		BOOST_CHECK(a == bits_t(a));
+		BOOST_CHECK(a.hash() == bits_t(a).hash());
+		BOOST_CHECK((a < b) != (b < a) || (a == b));
+		BOOST_CHECK(!(a < a));
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,199 @@
+/**
+ *  .file test/exces/change_log.cpp
+ *  .brief Test case for the change log of the manager
+ *
+ *  .author Matus Chochlik
+ *
+ *  Copyright 2011-2014 Matus Chochlik. Distributed under the Boost
+ *  Software License, Version 1.0. (See accompanying file
+ *  LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE EXCES_ChangeLog
+#include <boost/test/unit_test.hpp>
+
+#include <exces/simple.hpp>
+#include <exces/change_log.hpp>
+
+#include <sstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <stdexcept>
+
+#include "test_components.hpp"
+
+struct opaque { std::string str; };
+EXCES_REG_COMPONENT(opaque)
+
+#include <exces/implement.hpp>
+
+typedef exces::entity<>::type entity_t;
+
+BOOST_AUTO_TEST_SUITE(ChangeLog)
+
+BOOST_AUTO_TEST_CASE(ChangeLog_records)
+{
+	exces::change_log<> log(64);
+	BOOST_CHECK_EQUAL(log.capacity(), 64);
+
+	exces::manager<> m;
+	m.set_change_log(&log);
+
+	entity_t e;
+	std::vector<char> buffer;
+
+	// the records wrap around the end of the ring buffer
+	for(int i=0; i!=20; ++i)
+	{
+		position p = { float(i), float(-i) };
+		m.add(e, p);
+		m.remove<position>(e);
+
+		BOOST_REQUIRE(log.pop(buffer));
+		exces::change_record<> added = log.decode(buffer);
+		BOOST_CHECK(added.op == exces::change_op::add);
+		BOOST_CHECK(added.entity == e);
+		BOOST_CHECK_EQUAL(
+			added.component_id,
+			(exces::component_id<position, exces::default_group>::value)
+		);
+		BOOST_REQUIRE_EQUAL(added.value_size, sizeof(position));
+		BOOST_CHECK_EQUAL(
+			reinterpret_cast<const position*>(added.value)->x,
+			float(i)
+		);
+
+		BOOST_REQUIRE(log.pop(buffer));
+		exces::change_record<> removed = log.decode(buffer);
+		BOOST_CHECK(removed.op == exces::change_op::remove);
+		BOOST_CHECK(removed.value == nullptr);
+		BOOST_CHECK(!log.pop(buffer));
+	}
+	BOOST_CHECK_EQUAL(log.dropped(), 0);
+
+	// records that do not fit are dropped
+	for(int i=0; i!=10; ++i)
+	{
+		m.add(e, position());
+		m.remove<position>(e);
+	}
+	BOOST_CHECK(log.dropped() > 0);
+	std::size_t popped = 0;
+	while(log.pop(buffer)) ++popped;
+	BOOST_CHECK_EQUAL(popped+log.dropped(), 20);
+
+	// components without a serializer are logged without the value
+	opaque o = { "opaque" };
+	m.add(e, o);
+	BOOST_REQUIRE(log.pop(buffer));
+	exces::change_record<> added = log.decode(buffer);
+	BOOST_CHECK(added.op == exces::change_op::add);
+	BOOST_CHECK(added.value == nullptr);
+
+	exces::manager<> r;
+	BOOST_CHECK_THROW(
+		exces::apply_change(r, added),
+		std::invalid_argument
+	);
+
+	m.set_change_log(nullptr);
+	m.remove<opaque>(e);
+	BOOST_CHECK(!log.pop(buffer));
+
+	std::vector<char> garbage(3, '\0');
+	BOOST_CHECK_THROW(log.decode(garbage), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(ChangeLog_replication)
+{
+	const std::size_t n = 1000;
+	std::vector<entity_t> e(n);
+
+	exces::change_log<> log(1 << 20);
+	exces::manager<> m;
+	m.set_change_log(&log);
+
+	// the consumer streams the records while the manager is modified
+	std::stringstream pipe;
+	std::atomic<bool> done(false);
+	std::thread consumer(
+		[&log, &pipe, &done](void)
+		{
+			while(!done.load()) log.drain(pipe);
+			log.drain(pipe);
+		}
+	);
+
+	for(std::size_t i=0; i!=n; ++i)
+	{
+		position p = { float(i), float(2*i) };
+		m.add(e[i], p);
+		if(i % 3 == 0)
+		{
+			color c = { int(i % 4) };
+			m.add(e[i], c);
+		}
+		if(i % 5 == 0)
+		{
+			label l = { "entity #"+std::to_string(i) };
+			m.add(e[i], l);
+		}
+		if(i % 7 == 0)
+		{
+			position q = { -float(i), 0 };
+			m.replace(e[i], q);
+		}
+		if(i % 11 == 0)
+		{
+			m.remove<position>(e[i]);
+		}
+		if(	(i % 13 == 1) &&
+			m.has<label>(e[i-1]) &&
+			!m.has<label>(e[i])
+		)
+		{
+			m.copy<label>(e[i-1], e[i]);
+		}
+	}
+	done = true;
+	consumer.join();
+
+	BOOST_CHECK_EQUAL(log.dropped(), 0);
+
+	exces::manager<> r;
+	std::vector<char> buffer;
+	while(exces::change_log<>::read_record(pipe, buffer))
+	{
+		exces::apply_change(r, exces::change_log<>::decode(buffer));
+	}
+
+	for(std::size_t i=0; i!=n; ++i)
+	{
+		BOOST_CHECK_EQUAL(m.has<position>(e[i]), r.has<position>(e[i]));
+		BOOST_CHECK_EQUAL(m.has<color>(e[i]), r.has<color>(e[i]));
+		BOOST_CHECK_EQUAL(m.has<label>(e[i]), r.has<label>(e[i]));
+
+		if(r.has<position>(e[i]))
+		{
+			BOOST_CHECK_EQUAL(
+				r.rw<position>(e[i]).x,
+				m.rw<position>(e[i]).x
+			);
+		}
+		if(r.has<color>(e[i]))
+		{
+			BOOST_CHECK_EQUAL(r.rw<color>(e[i]).rgb, int(i % 4));
+		}
+		if(r.has<label>(e[i]))
+		{
+			BOOST_CHECK_EQUAL(
+				r.rw<label>(e[i]).str,
+				m.rw<label>(e[i]).str
+			);
+		}
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,444 @@
+/**
+ *  .file test/exces/collection.cpp
+ *  .brief Test case for entity collections and classifications
+ *
+ *  .author Matus Chochlik
+ *
+ *  Copyright 2011-2014 Matus Chochlik. Distributed under the Boost
+ *  Software License, Version 1.0. (See accompanying file
+ *  LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE EXCES_Collection
+#include <boost/test/unit_test.hpp>
+
+#include <exces/simple.hpp>
+
+#include <vector>
+#include <set>
+#include <functional>
+#include <chrono>
+
+struct c1 { int i; };
+EXCES_REG_COMPONENT(c1)
+
+struct c2 { int j; };
+EXCES_REG_COMPONENT(c2)
+
+#include <exces/implement.hpp>
+
+template <typename Collection>
+static std::size_t count_members(const Collection& c)
+{
+	std::size_t n = 0;
+	c.for_each(
+		[&n](
+			const exces::iter_info&,
+			exces::manager<>&,
+			exces::manager<>::entity_key
+		) -> bool
+		{
+			++n;
+			return true;
+		}
+	);
+	return n;
+}
+
+template <typename KeySet>
+static void test_collection_maintenance(void)
+{
+	const std::size_t n = 100;
+	std::vector<exces::entity<>::type> e(n);
+	exces::manager<> m;
+
+	exces::collection<exces::default_group, KeySet> with_c1(
+		m, exces::entity_with<c1>()
+	);
+	exces::collection<exces::default_group, KeySet> with_c1c2(
+		m, exces::entity_with<c1, c2>()
+	);
+
+	for(std::size_t i=0; i!=n; ++i)
+	{
+		m.add(e[i], c1());
+		if(i % 2 == 0) m.add(e[i], c2());
+	}
+	BOOST_CHECK_EQUAL(count_members(with_c1), n);
+	BOOST_CHECK_EQUAL(count_members(with_c1c2), n/2);
+
+	for(std::size_t i=0; i!=n; i += 4)
+	{
+		m.remove<c1>(e[i]);
+	}
+	BOOST_CHECK_EQUAL(count_members(with_c1), n-n/4);
+	BOOST_CHECK_EQUAL(count_members(with_c1c2), n/2-n/4);
+
+	std::set<exces::entity<>::type> members;
+	with_c1c2.for_each(
+		[&members](
+			const exces::iter_info&,
+			exces::manager<>& mgr,
+			exces::manager<>::entity_key k
+		) -> bool
+		{
+			BOOST_CHECK((mgr.has_all<c1, c2>(k)));
+			members.insert(mgr.get_entity(k));
+			return true;
+		}
+	);
+	BOOST_CHECK_EQUAL(members.size(), n/2-n/4);
+}
+
+BOOST_AUTO_TEST_SUITE(Collection)
+
+BOOST_AUTO_TEST_CASE(Collection_ordered)
+{
+	test_collection_maintenance<exces::entity_key_set<>>();
+}
+
+BOOST_AUTO_TEST_CASE(Collection_unordered)
+{
+	test_collection_maintenance<exces::unordered_entity_key_set<>>();
+}
+
+BOOST_AUTO_TEST_CASE(Classification_unordered)
+{
+	const std::size_t n = 60;
+	std::vector<exces::entity<>::type> e(n);
+	exces::manager<> m;
+
+	exces::classification<
+		int,
+		exces::default_group,
+		exces::unordered_entity_key_set<>
+	> by_i(m, &c1::i);
+
+	for(std::size_t i=0; i!=n; ++i)
+	{
+		c1 c = { int(i % 3) };
+		m.add(e[i], c);
+	}
+	BOOST_CHECK_EQUAL(by_i.class_count(), 3);
+	BOOST_CHECK_EQUAL(by_i.cardinality(0), n/3);
+	BOOST_CHECK_EQUAL(by_i.cardinality(1), n/3);
+
+	for(std::size_t i=0; i!=n; i += 3)
+	{
+		c1 c = { 1 };
+		m.replace(e[i], c);
+	}
+	BOOST_CHECK_EQUAL(by_i.cardinality(0), 0);
+	BOOST_CHECK_EQUAL(by_i.cardinality(1), 2*n/3);
+	BOOST_CHECK_EQUAL(by_i.cardinality(2), n/3);
+}
+
+BOOST_AUTO_TEST_CASE(Manager_cursor)
+{
+	const std::size_t n = 100;
+	std::vector<exces::entity<>::type> e(n);
+	exces::manager<> m;
+
+	for(std::size_t i=0; i!=n; ++i)
+	{
+		m.add(e[i], c1());
+	}
+
+	std::set<exces::entity<>::type> visited;
+	auto func = [&visited](
+		const exces::iter_info&,
+		exces::manager<>& mgr,
+		exces::manager<>::entity_key k
+	) -> bool
+	{
+		BOOST_CHECK(visited.insert(mgr.get_entity(k)).second);
+		return true;
+	};
+
+	exces::entity_cursor<> cur;
+	m.for_each(cur, exces::iter_budget::steps(30), func);
+	BOOST_CHECK(!cur.done());
+	BOOST_CHECK_EQUAL(cur.visited(), 30);
+
+	// new entities inserted between the resumptions
+	std::vector<exces::entity<>::type> f(10);
+	for(auto& x : f) m.add(x, c2());
+
+	std::size_t steps = 1;
+	while(!cur.done())
+	{
+		m.for_each(cur, exces::iter_budget::steps(30), func);
+		++steps;
+	}
+	BOOST_CHECK_EQUAL(steps, 4);
+	BOOST_CHECK_EQUAL(visited.size(), n+f.size());
+	BOOST_CHECK_EQUAL(cur.visited(), n+f.size());
+
+	cur.reset();
+	visited.clear();
+	m.for_each(cur, exces::iter_budget(), func);
+	BOOST_CHECK(cur.done());
+	BOOST_CHECK_EQUAL(visited.size(), n+f.size());
+
+	// the time budget is checked before the first step
+	// and then every clock_check_interval steps
+	cur.reset();
+	visited.clear();
+	m.for_each(cur, exces::iter_budget::time(std::chrono::seconds(0)), func);
+	BOOST_CHECK_EQUAL(cur.visited(), 0);
+	m.for_each(cur, exces::iter_budget::time(std::chrono::hours(1)), func);
+	BOOST_CHECK(cur.done());
+	BOOST_CHECK_EQUAL(visited.size(), n+f.size());
+}
+
+BOOST_AUTO_TEST_CASE(Collection_cursor)
+{
+	const std::size_t n = 100;
+	std::vector<exces::entity<>::type> e(n);
+	exces::manager<> m;
+	exces::collection<> with_c2(m, exces::entity_with<c2>());
+
+	for(std::size_t i=0; i!=n; ++i)
+	{
+		m.add(e[i], c2());
+	}
+
+	std::size_t count = 0;
+	auto func = [&count](
+		const exces::iter_info&,
+		exces::manager<>&,
+		exces::manager<>::entity_key
+	) -> bool
+	{
+		++count;
+		return true;
+	};
+
+	exces::entity_cursor<> cur;
+	with_c2.for_each(cur, exces::iter_budget::steps(n/2), func);
+	BOOST_CHECK_EQUAL(count, n/2);
+
+	// remove some already visited and some not yet visited members
+	m.remove<c2>(cur.last());
+	m.remove<c2>(e[n-1]);
+
+	while(!cur.done())
+	{
+		with_c2.for_each(cur, exces::iter_budget::steps(7), func);
+	}
+	BOOST_CHECK(count >= n-1);
+	BOOST_CHECK(count <= n);
+}
+
+BOOST_AUTO_TEST_CASE(Reduce)
+{
+	const std::size_t n = 10000;
+	std::vector<exces::entity<>::type> e(n);
+	exces::manager<> m;
+	exces::collection<> with_c2(m, exces::entity_with<c2>());
+	exces::classification<int> by_i(m, &c1::i);
+
+	for(std::size_t i=0; i!=n; ++i)
+	{
+		c1 c = { int(i % 2) };
+		m.add(e[i], c);
+		if(i % 5 == 0) m.add(e[i], c2());
+	}
+	// leaves released slots in the storage
+	for(std::size_t i=0; i!=n; i += 10)
+	{
+		m.remove<c1>(e[i]);
+	}
+
+	auto one = [](const c1&) -> std::size_t { return 1; };
+	auto get_i = [](const c1& c) -> long { return c.i; };
+	auto sum = [](long a, long b) -> long { return a+b; };
+
+	for(std::size_t t=1; t!=5; ++t)
+	{
+		BOOST_CHECK_EQUAL(
+			m.reduce<c1>(long(7), get_i, sum, t),
+			long(7+n/2)
+		);
+		BOOST_CHECK_EQUAL(
+			m.reduce<c1>(
+				std::size_t(0),
+				one,
+				std::plus<std::size_t>(),
+				t
+			),
+			n-n/10
+		);
+	}
+	BOOST_CHECK_EQUAL(
+		with_c2.reduce<c1>(std::size_t(0), one, std::plus<std::size_t>()),
+		n/5-n/10
+	);
+	BOOST_CHECK_EQUAL(by_i.reduce<c1>(1, long(0), get_i, sum), long(n/2));
+	BOOST_CHECK_EQUAL(by_i.reduce<c1>(2, long(3), get_i, sum), long(3));
+}
+
+BOOST_AUTO_TEST_CASE(For_each_batch)
+{
+	const std::size_t n = 100;
+	std::vector<exces::entity<>::type> e(n);
+	exces::manager<> m;
+
+	for(std::size_t i=0; i!=n; ++i)
+	{
+		c1 a = { int(i) };
+		m.add(e[i], a);
+		if(i % 2 == 0) m.add(e[i], c2());
+	}
+	m.remove<c1>(e[3]);
+
+	long sum = 0;
+	std::size_t batches = 0;
+	m.for_each_batch<c1>(
+		[&sum, &batches](std::size_t count, const c1* c) -> bool
+		{
+			++batches;
+			for(std::size_t i=0; i!=count; ++i) sum += c[i].i;
+			return true;
+		}
+	);
+	BOOST_CHECK_EQUAL(sum, long(n*(n-1)/2-3));
+	BOOST_CHECK_EQUAL(batches, 2);
+
+	m.for_each_batch<c1, c2&>(
+		[](std::size_t count, const c1* a, c2* b) -> bool
+		{
+			BOOST_CHECK(count <= 16);
+			for(std::size_t i=0; i!=count; ++i) b[i].j = a[i].i;
+			return true;
+		}, 16
+	);
+	for(std::size_t i=0; i!=n; i += 2)
+	{
+		BOOST_CHECK_EQUAL(m.rw<c2>(e[i]).j, int(i));
+	}
+}
+
+BOOST_AUTO_TEST_CASE(Memory_stats)
+{
+	const std::size_t n = 50;
+	std::vector<exces::entity<>::type> e(n);
+	exces::manager<> m;
+
+	exces::collection<> with_c2(
+		m,
+		[](exces::manager<>& m, exces::manager<>::entity_key k) -> bool
+		{
+			return m.has<c2>(k);
+		}
+	);
+	with_c2.set_name("with_c2");
+
+	for(std::size_t i=0; i!=n; ++i)
+	{
+		c1 a = { int(i) };
+		m.add(e[i], a);
+		if(i % 5 == 0) m.add(e[i], c2());
+	}
+	m.remove<c1>(e[7]);
+	m.remove<c1>(e[9]);
+
+	exces::manager_memory_stats ms = m.memory_stats();
+
+	BOOST_CHECK_EQUAL(ms.entity_count, n);
+	BOOST_CHECK_EQUAL(ms.component_key_count, n-2+n/5);
+	BOOST_CHECK(ms.entity_bytes > 0);
+	BOOST_CHECK(ms.component_index_entries > 0);
+
+	BOOST_CHECK_EQUAL(ms.components.size(), 2);
+	std::size_t live = 0, free = 0;
+	for(const exces::component_memory_stats& cs : ms.components)
+	{
+		BOOST_CHECK(cs.live_count+cs.free_count == cs.slot_count);
+		BOOST_CHECK(cs.slot_count <= cs.capacity);
+		BOOST_CHECK(cs.bytes_used+cs.bytes_free <= cs.bytes_reserved);
+		live += cs.live_count;
+		free += cs.free_count;
+	}
+	BOOST_CHECK_EQUAL(live, n-2+n/5);
+	BOOST_CHECK_EQUAL(free, 2);
+
+	BOOST_CHECK_EQUAL(ms.collections.size(), 1);
+	BOOST_CHECK_EQUAL(ms.collections[0].name, "with_c2");
+	BOOST_CHECK_EQUAL(ms.collections[0].key_count, n/5);
+	BOOST_CHECK_EQUAL(ms.collections[0].class_count, 1);
+
+	BOOST_CHECK(ms.total_bytes() > ms.entity_bytes);
+}
+
+BOOST_AUTO_TEST_CASE(Shrink_to_fit)
+{
+	const std::size_t n = 1000;
+	std::vector<exces::entity<>::type> e(n);
+	exces::manager<> m;
+
+	exces::collection<exces::default_group, exces::unordered_entity_key_set<>>
+	with_c2(
+		m,
+		[](exces::manager<>& m, exces::manager<>::entity_key k) -> bool
+		{
+			return m.has<c2>(k);
+		}
+	);
+	exces::classification<int> by_i(m, &c1::i);
+
+	for(std::size_t i=0; i!=n; ++i)
+	{
+		c1 a = { int(i / 10) };
+		c2 b = { int(i) };
+		m.add(e[i], a, b);
+	}
+	BOOST_CHECK_EQUAL(by_i.class_count(), n/10);
+
+	// keep only every 100-th entity of the first half
+	for(std::size_t i=0; i!=n; ++i)
+	{
+		if((i >= n/2) || (i % 100 != 0))
+		{
+			m.remove<c1, c2>(e[i]);
+		}
+	}
+
+	exces::manager_memory_stats before = m.memory_stats();
+	std::size_t reclaimed = m.shrink_to_fit();
+	exces::manager_memory_stats after = m.memory_stats();
+
+	BOOST_CHECK(reclaimed > 0);
+	BOOST_CHECK_EQUAL(reclaimed, before.total_bytes()-after.total_bytes());
+	BOOST_CHECK_EQUAL(by_i.class_count(), n/200);
+	BOOST_CHECK_EQUAL(m.shrink_to_fit(), 0);
+
+	for(const exces::component_memory_stats& cs : after.components)
+	{
+		BOOST_CHECK_EQUAL(cs.live_count, n/200);
+		BOOST_CHECK(cs.slot_count < n/2);
+	}
+	for(std::size_t i=0; i<n/2; i += 100)
+	{
+		BOOST_CHECK_EQUAL(m.rw<c1>(e[i]).i, int(i / 10));
+		BOOST_CHECK_EQUAL(m.rw<c2>(e[i]).j, int(i));
+	}
+
+	// the remaining free slots are reused
+	for(std::size_t i=n/2; i!=n; ++i)
+	{
+		c1 a = { int(i) };
+		m.add(e[i], a);
+	}
+	for(std::size_t i=n/2; i!=n; ++i)
+	{
+		BOOST_CHECK_EQUAL(m.rw<c1>(e[i]).i, int(i));
+	}
+	for(std::size_t i=0; i<n/2; i += 100)
+	{
+		BOOST_CHECK_EQUAL(m.rw<c1>(e[i]).i, int(i / 10));
+	}
+	BOOST_CHECK_EQUAL(count_members(with_c2), n/200);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,101 @@
+/**
+ *  .file test/exces/delta.cpp
+ *  .brief Test case for the differences between managers
+ *
+ *  .author Matus Chochlik
+ *
+ *  Copyright 2011-2014 Matus Chochlik. Distributed under the Boost
+ *  Software License, Version 1.0. (See accompanying file
+ *  LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE EXCES_Delta
+#include <boost/test/unit_test.hpp>
+
+#include <exces/simple.hpp>
+#include <exces/delta.hpp>
+
+#include <vector>
+#include <stdexcept>
+
+#include "test_components.hpp"
+
+#include <exces/implement.hpp>
+
+typedef exces::entity<>::type entity_t;
+
+BOOST_AUTO_TEST_SUITE(Delta)
+
+BOOST_AUTO_TEST_CASE(Delta_diff_patch)
+{
+	const std::size_t n = 1000;
+	std::vector<entity_t> e(n+10);
+	std::vector<entity_t> old_e(e.begin(), e.begin()+n);
+
+	exces::manager<> a, b;
+	populate(a, old_e);
+	populate(b, old_e);
+
+	BOOST_CHECK(exces::diff(a, b).empty());
+
+	// changed values
+	for(std::size_t i=0; i<n; i += 10)
+	{
+		position p = { -float(i), 0 };
+		b.replace(e[i], p);
+	}
+	// added and removed components
+	color c = { 7 };
+	b.add(e[1], c);
+	b.remove<label>(e[5]);
+	// destroyed entities
+	b.remove<position, color, label>(e[0]);
+	b.remove<position>(e[1]);
+	b.remove<position>(e[2]);
+	// created entities
+	for(std::size_t i=n; i!=n+10; ++i)
+	{
+		label l = { "new" };
+		b.add(e[i], l);
+	}
+
+	exces::manager_delta<> d = exces::diff(a, b);
+	BOOST_CHECK(!d.empty());
+	BOOST_CHECK_EQUAL(d.created().size(), 10);
+	BOOST_CHECK_EQUAL(d.destroyed().size(), 2);
+	BOOST_CHECK_EQUAL(d.value_count<position>(), n/10-1);
+	BOOST_CHECK_EQUAL(d.value_count<color>(), 1);
+	BOOST_CHECK_EQUAL(d.value_count<label>(), 10);
+
+	exces::manager<> r;
+	exces::collection<> with_label(r, exces::entity_with<label>());
+	populate(r, old_e);
+	exces::patch(r, d);
+	check_equal(r, b, e);
+	BOOST_CHECK(exces::diff(r, b).empty());
+
+	std::size_t labels = 0;
+	with_label.for_each(
+		[&labels](
+			const exces::iter_info&,
+			exces::manager<>&,
+			exces::manager<>::entity_key
+		) -> bool
+		{
+			++labels;
+			return true;
+		}
+	);
+	BOOST_CHECK_EQUAL(labels, n/5-2+10);
+
+	// the reverse delta rolls the changes back
+	exces::patch(r, exces::diff(b, a));
+	check_equal(r, a, e);
+	BOOST_CHECK(exces::diff(r, a).empty());
+
+	// the delta does not apply to a manager in a different state
+	exces::manager<> w;
+	BOOST_CHECK_THROW(exces::patch(w, d), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -13,8 +13,21 @@
 #include <boost/test/unit_test.hpp>
 
 #include <exces/entity.hpp>
+#include <exces/entity/boost_uuid.hpp>
+#include <exces/entity/interned_string.hpp>
+#include <exces/entity/uintmax.hpp>
 
 #include <vector>
+#include <thread>
+#include <algorithm>
+#include <unordered_set>
+#include <sstream>
+#include <map>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 BOOST_AUTO_TEST_SUITE(Entity)
 
@@ -58,4 +71,183 @@ BOOST_AUTO_TEST_CASE(Entity_identity_2)
 	}
 }
 
+BOOST_AUTO_TEST_CASE(Entity_concurrent_creation)
+{
+	typedef exces::entity<>::type entity_t;
+	const std::size_t nt = 4, ne = 10000;
+	std::vector<std::vector<entity_t>> evs(nt);
+	std::vector<std::thread> threads;
+	for(std::size_t t=0; t!=nt; ++t)
+	{
+		threads.push_back(std::thread(
+			[&evs, t, ne](void)
+			{
+				for(std::size_t i=0; i!=ne; ++i)
+				{
+					evs[t].push_back(entity_t());
+				}
+			}
+		));
+	}
+	for(std::thread& thread : threads)
+	{
+		thread.join();
+	}
+
+	std::vector<entity_t> all;
+	for(std::size_t t=0; t!=nt; ++t)
+	{
+		// the entities created by a single thread are ordered
+		BOOST_CHECK(std::is_sorted(evs[t].begin(), evs[t].end()));
+		all.insert(all.end(), evs[t].begin(), evs[t].end());
+	}
+	std::sort(all.begin(), all.end());
+	BOOST_CHECK(std::adjacent_find(all.begin(), all.end()) == all.end());
+	BOOST_CHECK(
+		std::find(all.begin(), all.end(), entity_t::nil()) == all.end()
+	);
+}
+
+BOOST_AUTO_TEST_CASE(Entity_loaded_ids)
+{
+	typedef exces::uintmax_entity entity_t;
+	typedef exces::snapshot_serializer<entity_t> serializer;
+
+	// the ids following the first one are in the block
+	// reserved by this thread
+	const entity_t first;
+	std::stringstream buffer;
+	serializer::write(buffer, first);
+	uintmax_t first_id = 0;
+	buffer.read(reinterpret_cast<char*>(&first_id), sizeof(first_id));
+	for(uintmax_t d=1; d!=100; ++d)
+	{
+		serializer::write(buffer, entity_t(first_id+d));
+	}
+	std::vector<entity_t> loaded;
+	for(std::size_t i=1; i!=100; ++i)
+	{
+		loaded.push_back(serializer::read(buffer));
+	}
+
+	// the generated entities do not collide with the loaded ones
+	for(std::size_t i=0; i!=1000; ++i)
+	{
+		const entity_t e;
+		BOOST_CHECK(e != first);
+		BOOST_CHECK(
+			std::find(loaded.begin(), loaded.end(), e) == loaded.end()
+		);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(Entity_boost_uuid)
+{
+	typedef exces::boost_uuid_entity entity_t;
+	const std::size_t n = 10000;
+
+	std::vector<entity_t> ev(n);
+	std::unordered_set<entity_t> es(ev.begin(), ev.end());
+	BOOST_CHECK_EQUAL(es.size(), n);
+	BOOST_CHECK(es.find(entity_t::nil()) == es.end());
+
+	for(std::size_t i=0; i!=n; ++i)
+	{
+		const boost::uuids::uuid& u = ev[i];
+		BOOST_CHECK_EQUAL(
+			u.version(),
+			boost::uuids::uuid::version_random_number_based
+		);
+		BOOST_CHECK_EQUAL(
+			u.variant(),
+			boost::uuids::uuid::variant_rfc_4122
+		);
+		BOOST_CHECK(es.find(ev[i]) != es.end());
+
+		// the ordering is the same as the ordering of Boost.UUID
+		const std::size_t j = (i*7919) % n;
+		const boost::uuids::uuid& v = ev[j];
+		BOOST_CHECK_EQUAL(ev[i] <  ev[j], u <  v);
+		BOOST_CHECK_EQUAL(ev[i] >= ev[j], u >= v);
+		BOOST_CHECK_EQUAL(ev[i] == ev[j], u == v);
+	}
+	entity_t e1 = ev[0];
+	BOOST_CHECK(e1 == ev[0]);
+	BOOST_CHECK(e1 <= ev[0]);
+	BOOST_CHECK(!(e1 != ev[0]));
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+BOOST_AUTO_TEST_CASE(Entity_boost_uuid_fork)
+{
+	typedef exces::boost_uuid_entity entity_t;
+	// make sure that the engine of this thread is seeded
+	entity_t before;
+	(void)before;
+
+	int fds[2];
+	BOOST_REQUIRE(::pipe(fds) == 0);
+	const ::pid_t pid = ::fork();
+	BOOST_REQUIRE(pid >= 0);
+	if(pid == 0)
+	{
+		const entity_t e;
+		const ssize_t n = ::write(fds[1], e.data, sizeof(e.data));
+		::_exit(n == ssize_t(sizeof(e.data))?0:1);
+	}
+	::close(fds[1]);
+	const entity_t e;
+	entity_t c = entity_t::nil();
+	const ssize_t n = ::read(fds[0], c.data, sizeof(c.data));
+	::close(fds[0]);
+	int status = 0;
+	::waitpid(pid, &status, 0);
+
+	// the child does not repeat the UUIDs of the parent
+	BOOST_CHECK_EQUAL(n, ssize_t(sizeof(c.data)));
+	BOOST_CHECK(c != entity_t::nil());
+	BOOST_CHECK(c != e);
+}
+#endif
+
+BOOST_AUTO_TEST_CASE(Entity_interned_string)
+{
+	typedef exces::interned_string_entity entity_t;
+
+	entity_t a("alpha"), b(std::string("beta")), a2(std::string("alpha"));
+	BOOST_CHECK(a == a2);
+	BOOST_CHECK(a != b);
+	BOOST_CHECK_EQUAL(a.index(), a2.index());
+	BOOST_CHECK_EQUAL(a.hash(), std::hash<std::string>()("alpha"));
+	BOOST_CHECK_EQUAL(a.str(), "alpha");
+	BOOST_CHECK_EQUAL(b.str(), "beta");
+	BOOST_CHECK(entity_t::nil() == entity_t(""));
+	BOOST_CHECK(entity_t::nil() != a);
+
+	// the ordering follows the order of interning
+	entity_t z("zzz-interned-first"), y("yyy-interned-second");
+	BOOST_CHECK(z < y);
+	BOOST_CHECK(y >= z);
+
+	std::map<entity_t, int> m;
+	std::unordered_set<entity_t> s;
+	for(int i=0; i!=100; ++i)
+	{
+		entity_t e("entity-"+std::to_string(i % 10));
+		++m[e];
+		s.insert(e);
+	}
+	BOOST_CHECK_EQUAL(m.size(), 10);
+	BOOST_CHECK_EQUAL(s.size(), 10);
+	BOOST_CHECK_EQUAL(m[entity_t("entity-3")], 10);
+
+	std::stringstream ss;
+	exces::snapshot_serializer<entity_t>::write(ss, b);
+	BOOST_CHECK(exces::snapshot_serializer<entity_t>::read(ss) == b);
+
+	std::stringstream out;
+	out << a;
+	BOOST_CHECK_EQUAL(out.str(), "{alpha}");
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -15,6 +15,7 @@ function(add_exces_test TEST_NAME BUILD_ONLY)
 		target_link_libraries(
 			${TEST_NAME}
 			${Boost_UNIT_TEST_FRAMEWORK_LIBRARY}
+			${CMAKE_THREAD_LIBS_INIT}
 		)
 	endif()
 
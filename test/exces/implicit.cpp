@@ -0,0 +1,102 @@
+/**
+ *  .file test/exces/implicit.cpp
+ *  .brief Test case for the implicit manager and entity
+ *
+ *  .author Matus Chochlik
+ *
+ *  Copyright 2011-2014 Matus Chochlik. Distributed under the Boost
+ *  Software License, Version 1.0. (See accompanying file
+ *  LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE EXCES_Implicit
+#include <boost/test/unit_test.hpp>
+
+#include <exces/simple.hpp>
+
+#include <vector>
+#include <thread>
+
+struct counter { int value; };
+EXCES_REG_COMPONENT(counter)
+
+#include <exces/implement.hpp>
+
+BOOST_AUTO_TEST_SUITE(Implicit)
+
+BOOST_AUTO_TEST_CASE(Implicit_stack)
+{
+	exces::manager<> m1, m2;
+	exces::implicit_manager<> im1(m1);
+	BOOST_CHECK(&exces::implicit_manager<>::get() == &m1);
+	{
+		exces::implicit_manager<> im2(m2);
+		BOOST_CHECK(&exces::implicit_manager<>::get() == &m2);
+
+		exces::implicit_entity<> e;
+		counter c = { 1 };
+		e.add(c);
+		BOOST_CHECK(m2.has<counter>(e));
+		BOOST_CHECK(!m1.has<counter>(e));
+	}
+	BOOST_CHECK(&exces::implicit_manager<>::get() == &m1);
+}
+
+BOOST_AUTO_TEST_CASE(Implicit_threads)
+{
+	const std::size_t nt = 4, ne = 1000;
+	exces::manager<> global;
+	exces::implicit_manager<> install(global, exces::implicit_global());
+
+	std::vector<exces::manager<>> managers(nt);
+	std::vector<exces::implicit_entity<>> shared(ne);
+	std::vector<std::thread> threads;
+	for(std::size_t t=0; t!=nt; ++t)
+	{
+		threads.push_back(std::thread(
+			[&managers, &shared, t, ne](void)
+			{
+				exces::implicit_manager<> im(managers[t]);
+				for(std::size_t i=0; i!=ne; ++i)
+				{
+					counter c = { int(t) };
+					shared[i].add(c);
+					++shared[i].rw<counter>().value;
+				}
+			}
+		));
+	}
+	// the threads without their own manager use the global one
+	threads.push_back(std::thread(
+		[&shared, ne](void)
+		{
+			for(std::size_t i=0; i!=ne; ++i)
+			{
+				counter c = { -1 };
+				shared[i].add(c);
+			}
+		}
+	));
+	for(std::thread& thread : threads)
+	{
+		thread.join();
+	}
+
+	for(std::size_t t=0; t!=nt; ++t)
+	{
+		for(std::size_t i=0; i!=ne; ++i)
+		{
+			BOOST_CHECK_EQUAL(
+				managers[t].rw<counter>(shared[i]).value,
+				int(t)+1
+			);
+		}
+	}
+	for(std::size_t i=0; i!=ne; ++i)
+	{
+		BOOST_CHECK_EQUAL(global.rw<counter>(shared[i]).value, -1);
+	}
+	BOOST_CHECK(&exces::implicit_manager<>::get() == &global);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
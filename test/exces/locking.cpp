@@ -0,0 +1,177 @@
+/**
+ *  .file test/exces/locking.cpp
+ *  .brief Test case for component group locking policies
+ *
+ *  .author Matus Chochlik
+ *
+ *  Copyright 2011-2014 Matus Chochlik. Distributed under the Boost
+ *  Software License, Version 1.0. (See accompanying file
+ *  LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE EXCES_Locking
+#include <boost/test/unit_test.hpp>
+
+#include <exces/group.hpp>
+#include <exces/threads.hpp>
+#include <exces/lock_stats.hpp>
+
+#include <memory>
+#include <cstdint>
+
+EXCES_REG_GROUP(read_mostly)
+EXCES_REG_GROUP(instrumented)
+
+namespace exces {
+
+template <>
+struct group_locking<EXCES_GROUP_SEL(read_mostly)>
+ : read_mostly_component_locking
+{ };
+
+template <>
+struct group_locking<EXCES_GROUP_SEL(instrumented)>
+ : instrumented_component_locking<std_component_locking>
+{ };
+
+} // namespace exces
+
+struct c1 { int i; };
+EXCES_REG_COMPONENT_IN_GROUP(c1, read_mostly)
+EXCES_REG_COMPONENT_IN_GROUP(c1, instrumented)
+EXCES_REG_COMPONENT_NAME(c1)
+
+#include <exces/exces.hpp>
+#include <exces/implement.hpp>
+
+#include <thread>
+#include <vector>
+#include <atomic>
+
+template <typename Group>
+static void test_concurrent_access(void)
+{
+	typedef exces::manager<Group> manager;
+	typedef typename exces::entity<Group>::type entity;
+
+	const std::size_t n = 100;
+	std::vector<entity> e(n);
+	manager m;
+
+	for(std::size_t i=0; i!=n; ++i)
+	{
+		c1 c = { 1 };
+		m.add(e[i], c);
+	}
+
+	std::atomic<bool> stop(false);
+	std::thread writer(
+		[&m, &e, &stop](void) -> void
+		{
+			auto wl = m.template raw_access_lock<c1&>();
+			for(std::size_t k=0; !stop.load(); ++k)
+			{
+				wl.lock();
+				m.template rw<c1>(e[k % e.size()]).i = 1;
+				wl.unlock();
+				std::this_thread::yield();
+			}
+		}
+	);
+
+	std::atomic<std::size_t> errors(0);
+	std::vector<std::thread> readers;
+	for(std::size_t t=0; t!=4; ++t)
+	{
+		readers.push_back(std::thread(
+			[&m, &errors](void) -> void
+			{
+				auto rl = m.template raw_access_lock<c1>();
+				for(std::size_t r=0; r!=100; ++r)
+				{
+					rl.lock();
+					int sum = 0;
+					m.template for_each<c1>(
+						[&sum](c1& c) -> bool
+						{
+							sum += c.i;
+							return true;
+						}
+					);
+					rl.unlock();
+					if(sum != 100) ++errors;
+				}
+			}
+		));
+	}
+	for(auto& r : readers) r.join();
+	stop.store(true);
+	writer.join();
+
+	BOOST_CHECK_EQUAL(errors.load(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE(Locking)
+
+BOOST_AUTO_TEST_CASE(Locking_read_mostly_mutex)
+{
+	exces::read_mostly_shared_mutex mutex;
+
+	mutex.lock_shared();
+	BOOST_CHECK(mutex.try_lock_shared());
+	BOOST_CHECK(!mutex.try_lock());
+	mutex.unlock_shared();
+	mutex.unlock_shared();
+
+	BOOST_CHECK(mutex.try_lock());
+	BOOST_CHECK(!mutex.try_lock_shared());
+	mutex.unlock();
+
+	// the reader counters are aligned to cache lines also on the heap
+	BOOST_CHECK_EQUAL(alignof(exces::read_mostly_shared_mutex), 64);
+	std::unique_ptr<exces::read_mostly_shared_mutex> heap_mutex(
+		new exces::read_mostly_shared_mutex()
+	);
+	BOOST_CHECK_EQUAL(std::uintptr_t(heap_mutex.get()) % 64, 0);
+	heap_mutex->lock_shared();
+	heap_mutex->unlock_shared();
+
+	exces::shared_mutex plain;
+	BOOST_CHECK(plain.try_lock_shared());
+	BOOST_CHECK(!plain.try_lock());
+	plain.unlock_shared();
+	BOOST_CHECK(plain.try_lock());
+	plain.unlock();
+}
+
+BOOST_AUTO_TEST_CASE(Locking_read_mostly_policy)
+{
+	test_concurrent_access<EXCES_GROUP_SEL(read_mostly)>();
+}
+
+BOOST_AUTO_TEST_CASE(Locking_instrumented_policy)
+{
+	exces::lock_stats::reset();
+	test_concurrent_access<EXCES_GROUP_SEL(instrumented)>();
+
+	bool found_entity_map = false;
+	bool found_component = false;
+	for(const exces::lock_stats_record& r : exces::lock_stats::snapshot())
+	{
+		if(r.name == "manager::entity_map")
+		{
+			found_entity_map = true;
+			BOOST_CHECK(r.exclusive_locks + r.shared_locks > 0);
+		}
+		if(r.name == "c1::storage_access")
+		{
+			found_component = true;
+			BOOST_CHECK(r.shared_locks >= 400);
+			BOOST_CHECK(r.exclusive_locks > 0);
+		}
+	}
+	BOOST_CHECK(found_entity_map);
+	BOOST_CHECK(found_component);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,148 @@
+/**
+ *  .file test/exces/query.cpp
+ *  .brief Test case for compile-time entity queries
+ *
+ *  .author Matus Chochlik
+ *
+ *  Copyright 2011-2014 Matus Chochlik. Distributed under the Boost
+ *  Software License, Version 1.0. (See accompanying file
+ *  LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE EXCES_Query
+#include <boost/test/unit_test.hpp>
+
+#include <exces/simple.hpp>
+
+#include <vector>
+
+struct a { int i; };
+EXCES_REG_COMPONENT(a)
+
+struct b { int i; };
+EXCES_REG_COMPONENT(b)
+
+struct c { int i; };
+EXCES_REG_COMPONENT(c)
+
+struct d { int i; };
+EXCES_REG_COMPONENT(d)
+
+#include <exces/implement.hpp>
+
+typedef exces::entity<>::type entity_t;
+
+// the entity i has a if bit 0 of i is set, b if bit 1 is set, etc.
+static void populate(exces::manager<>& m, const std::vector<entity_t>& e)
+{
+	for(std::size_t i=0; i!=e.size(); ++i)
+	{
+		if(i & 1) m.add(e[i], a());
+		if(i & 2) m.add(e[i], b());
+		if(i & 4) m.add(e[i], c());
+		if(i & 8) m.add(e[i], d());
+	}
+}
+
+template <typename Query>
+static std::size_t count_matches(exces::manager<>& m)
+{
+	std::size_t n = 0;
+	m.for_each(
+		Query(),
+		[&n](exces::manager<>&, exces::manager<>::entity_key) -> bool
+		{
+			++n;
+			return true;
+		}
+	);
+	return n;
+}
+
+BOOST_AUTO_TEST_SUITE(Query)
+
+BOOST_AUTO_TEST_CASE(Query_matches)
+{
+	using namespace exces;
+
+	std::vector<entity_t> e(16);
+	manager<> m;
+	populate(m, e);
+
+	typedef query<with<a, b>, without<c>> q1;
+	typedef query<any_of<c, d>> q2;
+	typedef query<with<a>, without<b>, any_of<c, d>, optional<b>> q3;
+	typedef query<without<a, b, c, d>> q4;
+
+	for(std::size_t i=1; i!=e.size(); ++i)
+	{
+		const bool ha = i & 1, hb = i & 2, hc = i & 4, hd = i & 8;
+		BOOST_CHECK_EQUAL(m.matches(e[i], q1()), ha && hb && !hc);
+		BOOST_CHECK_EQUAL(m.matches(e[i], q2()), hc || hd);
+		BOOST_CHECK_EQUAL(
+			m.matches(e[i], q3()),
+			ha && !hb && (hc || hd)
+		);
+		BOOST_CHECK(!m.matches(e[i], q4()));
+	}
+	// the entity without any components does not exist in the manager
+	BOOST_CHECK(!m.matches(e[0], q4()));
+
+	BOOST_CHECK_EQUAL(count_matches<q1>(m), 2);
+	BOOST_CHECK_EQUAL(count_matches<q2>(m), 12);
+	BOOST_CHECK_EQUAL(count_matches<q3>(m), 3);
+	BOOST_CHECK_EQUAL(count_matches<query<optional<a>>>(m), 15);
+}
+
+BOOST_AUTO_TEST_CASE(Query_select_and_collection)
+{
+	using namespace exces;
+	typedef query<with<b>, without<d>> q;
+
+	std::vector<entity_t> e(16);
+	manager<> m;
+	collection<> col(m, q());
+	populate(m, e);
+
+	std::size_t n = 0;
+	{
+		auto r = m.select(q());
+		while(!r.empty())
+		{
+			BOOST_CHECK(r.has<b>());
+			BOOST_CHECK(!r.has<d>());
+			++n;
+			r.next();
+		}
+	}
+	BOOST_CHECK_EQUAL(n, 4);
+
+	auto count = [&col](void) -> std::size_t
+	{
+		std::size_t k = 0;
+		col.for_each(
+			[&k](
+				const iter_info&,
+				manager<>&,
+				manager<>::entity_key
+			) -> bool
+			{
+				++k;
+				return true;
+			}
+		);
+		return k;
+	};
+	BOOST_CHECK_EQUAL(count(), 4);
+
+	m.add(e[2], d());
+	BOOST_CHECK_EQUAL(count(), 3);
+	m.remove<d>(e[10]);
+	BOOST_CHECK_EQUAL(count(), 4);
+
+	// the query can be used as an ordinary entity predicate
+	BOOST_CHECK(!q()(m, m.get_key(e[2])));
+	BOOST_CHECK(q()(m, m.get_key(e[3])));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
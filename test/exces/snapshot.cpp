@@ -0,0 +1,353 @@
+/**
+ *  .file test/exces/snapshot.cpp
+ *  .brief Test case for the manager snapshots
+ *
+ *  .author Matus Chochlik
+ *
+ *  Copyright 2011-2014 Matus Chochlik. Distributed under the Boost
+ *  Software License, Version 1.0. (See accompanying file
+ *  LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE EXCES_Snapshot
+#include <boost/test/unit_test.hpp>
+
+#include <exces/simple.hpp>
+#include <exces/snapshot_view.hpp>
+
+#include <sstream>
+#include <fstream>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+#include "test_components.hpp"
+
+struct velocity { float dx, dy; };
+EXCES_REG_MAPPED_COMPONENT(velocity)
+
+struct opaque { std::string str; };
+EXCES_REG_COMPONENT(opaque)
+
+// a group sharing only some of the components with the default group
+EXCES_REG_GROUP(other)
+EXCES_REG_COMPONENT_IN_GROUP(velocity, other)
+EXCES_REG_COMPONENT_IN_GROUP(label, other)
+
+#include <exces/implement.hpp>
+
+typedef exces::entity<>::type entity_t;
+
+// adds the shared components, a velocity to every other entity
+// and leaves some free slots in the position storage
+static void populate_with_free_slots(
+	exces::manager<>& m,
+	const std::vector<entity_t>& e
+)
+{
+	populate(m, e);
+	for(std::size_t i=0; i<e.size(); i += 2)
+	{
+		velocity v = { float(i), -float(i) };
+		m.add(e[i], v);
+	}
+	for(std::size_t i=0; i<e.size(); i += 7)
+	{
+		m.remove<position>(e[i]);
+	}
+}
+
+BOOST_AUTO_TEST_SUITE(Snapshot)
+
+BOOST_AUTO_TEST_CASE(Snapshot_round_trip)
+{
+	const std::size_t n = 1000;
+	std::vector<entity_t> e(n);
+	exces::manager<> m1;
+	populate_with_free_slots(m1, e);
+
+	std::stringstream buffer;
+	exces::save_snapshot(m1, buffer);
+
+	exces::manager<> m2;
+	exces::collection<> with_pv(
+		m2, exces::entity_with<position, velocity>()
+	);
+	exces::load_snapshot(m2, buffer);
+
+	std::size_t pv_count = 0;
+	for(std::size_t i=0; i!=n; ++i)
+	{
+		BOOST_CHECK_EQUAL(m1.has<position>(e[i]), m2.has<position>(e[i]));
+		BOOST_CHECK_EQUAL(m1.has<velocity>(e[i]), m2.has<velocity>(e[i]));
+		BOOST_CHECK_EQUAL(m1.has<color>(e[i]), m2.has<color>(e[i]));
+		BOOST_CHECK_EQUAL(m1.has<label>(e[i]), m2.has<label>(e[i]));
+
+		if(m2.has<position>(e[i]))
+		{
+			BOOST_CHECK_EQUAL(m2.rw<position>(e[i]).x, float(i));
+			BOOST_CHECK_EQUAL(m2.rw<position>(e[i]).y, float(2*i));
+			if(m2.has<velocity>(e[i])) ++pv_count;
+		}
+		if(m2.has<velocity>(e[i]))
+		{
+			BOOST_CHECK_EQUAL(m2.rw<velocity>(e[i]).dy, -float(i));
+		}
+		if(m2.has<color>(e[i]))
+		{
+			BOOST_CHECK_EQUAL(m2.rw<color>(e[i]).rgb, int(i % 4));
+		}
+		if(m2.has<label>(e[i]))
+		{
+			BOOST_CHECK_EQUAL(
+				m2.rw<label>(e[i]).str,
+				"entity #"+std::to_string(i)
+			);
+		}
+	}
+
+	std::size_t members = 0;
+	with_pv.for_each(
+		[&members](
+			const exces::iter_info&,
+			exces::manager<>&,
+			exces::manager<>::entity_key
+		) -> bool
+		{
+			++members;
+			return true;
+		}
+	);
+	BOOST_CHECK_EQUAL(members, pv_count);
+
+	// the loaded storages keep working, including the free slots
+	// and the flyweight index
+	const std::size_t live = m2.memory_stats().components[0].live_count;
+	for(std::size_t i=0; i!=n; ++i)
+	{
+		if(!m2.has<position>(e[i]))
+		{
+			m2.add(e[i], position());
+		}
+	}
+	BOOST_CHECK(m2.memory_stats().components[0].slot_count <= n);
+	BOOST_CHECK(m2.memory_stats().components[0].live_count > live);
+
+	color c = { 1 };
+	entity_t ne;
+	m2.add(ne, c);
+	BOOST_CHECK_EQUAL(m2.rw<color>(ne).rgb, 1);
+	m2.remove<color>(e[0]);
+	BOOST_CHECK_EQUAL(m2.rw<color>(e[3]).rgb, 3);
+}
+
+BOOST_AUTO_TEST_CASE(Snapshot_other_group)
+{
+	const std::size_t n = 100;
+	std::vector<entity_t> e(n);
+	exces::manager<> m1;
+	populate_with_free_slots(m1, e);
+
+	std::stringstream buffer;
+	exces::save_snapshot(m1, buffer);
+
+	// position, color and opaque are not in the group and are skipped
+	exces::manager<EXCES_GROUP_SEL(other)> m2;
+	exces::load_snapshot(m2, buffer);
+
+	for(std::size_t i=0; i!=n; ++i)
+	{
+		BOOST_CHECK_EQUAL(m1.has<velocity>(e[i]), m2.has<velocity>(e[i]));
+		BOOST_CHECK_EQUAL(m1.has<label>(e[i]), m2.has<label>(e[i]));
+		if(m2.has<velocity>(e[i]))
+		{
+			BOOST_CHECK_EQUAL(m2.rw<velocity>(e[i]).dx, float(i));
+		}
+		if(m2.has<label>(e[i]))
+		{
+			BOOST_CHECK_EQUAL(
+				m2.rw<label>(e[i]).str,
+				"entity #"+std::to_string(i)
+			);
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(Snapshot_view)
+{
+	const std::size_t n = 1000;
+	std::vector<entity_t> e(n);
+	exces::manager<> m;
+	populate_with_free_slots(m, e);
+
+	const char* path = "exces_test_snapshot_view.bin";
+	{
+		std::ofstream output(path, std::ios::binary);
+		exces::save_snapshot(m, output);
+	}
+	{
+		exces::snapshot_view<> v(path);
+		BOOST_CHECK_EQUAL(v.size(), n);
+
+		for(std::size_t i=0; i!=n; ++i)
+		{
+			BOOST_ASSERT(v.has_key(e[i]));
+			exces::snapshot_view<>::entity_key k = v.get_key(e[i]);
+			BOOST_CHECK(v.get_entity(k) == e[i]);
+
+			BOOST_CHECK_EQUAL(m.has<position>(e[i]), v.has<position>(k));
+			BOOST_CHECK_EQUAL(m.has<velocity>(e[i]), v.has<velocity>(k));
+			BOOST_CHECK_EQUAL(m.has<color>(e[i]), v.has<color>(e[i]));
+			BOOST_CHECK_EQUAL(m.has<label>(e[i]), v.has<label>(k));
+
+			if(v.has<position>(k))
+			{
+				BOOST_CHECK_EQUAL(v.cref<position>(k).y, float(2*i));
+			}
+			else
+			{
+				BOOST_CHECK_THROW(
+					v.cref<position>(k),
+					std::invalid_argument
+				);
+			}
+			if(v.has<velocity>(k))
+			{
+				BOOST_CHECK_EQUAL(v.read<velocity>(e[i]).dx, float(i));
+			}
+			if(v.has<color>(k))
+			{
+				BOOST_CHECK_EQUAL(v.cref<color>(k).rgb, int(i % 4));
+			}
+		}
+		BOOST_CHECK(!v.has_key(entity_t()));
+		BOOST_CHECK_THROW(v.get_key(entity_t()), std::invalid_argument);
+
+		std::size_t entities = 0, with_position = 0;
+		v.for_each(
+			[&entities, &with_position](
+				const exces::iter_info&,
+				const exces::snapshot_view<>& view,
+				exces::snapshot_view<>::entity_key k
+			) -> bool
+			{
+				++entities;
+				if(view.has<position>(k)) ++with_position;
+				return true;
+			}
+		);
+		BOOST_CHECK_EQUAL(entities, n);
+
+		std::size_t positions = 0;
+		float sum = 0;
+		v.for_each<position>(
+			[&positions, &sum](const position& p) -> bool
+			{
+				++positions;
+				sum += p.x;
+				return true;
+			}
+		);
+		BOOST_CHECK_EQUAL(positions, with_position);
+
+		float expected = 0;
+		m.for_each<position>(
+			[&expected](position& p) -> bool
+			{
+				expected += p.x;
+				return true;
+			}
+		);
+		BOOST_CHECK_EQUAL(sum, expected);
+	}
+	std::remove(path);
+
+	BOOST_CHECK_THROW(
+		exces::snapshot_view<>("exces_test_no_such_snapshot.bin"),
+		std::runtime_error
+	);
+}
+
+// checks that a manager is left empty by a failed load
+static void check_empty(exces::manager<>& m)
+{
+	const exces::manager_memory_stats stats = m.memory_stats();
+	BOOST_CHECK_EQUAL(stats.entity_count, 0);
+	for(const exces::component_memory_stats& c : stats.components)
+	{
+		BOOST_CHECK_EQUAL(c.slot_count, 0);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(Snapshot_errors)
+{
+	std::vector<entity_t> e(10);
+	exces::manager<> m1;
+	populate_with_free_slots(m1, e);
+
+	// opaque has no serializer
+	std::stringstream buffer;
+	opaque o = { "opaque" };
+	m1.add(e[1], o);
+	BOOST_CHECK_THROW(
+		exces::save_snapshot(m1, buffer),
+		std::invalid_argument
+	);
+	m1.remove<opaque>(e[1]);
+
+	buffer.str(std::string());
+	buffer.clear();
+	exces::save_snapshot(m1, buffer);
+	const std::string snapshot = buffer.str();
+
+	// the target manager must be empty
+	std::stringstream full(snapshot);
+	BOOST_CHECK_THROW(
+		exces::load_snapshot(m1, full),
+		std::invalid_argument
+	);
+
+	std::stringstream garbage("this is not a snapshot");
+	exces::manager<> m2;
+	BOOST_CHECK_THROW(
+		exces::load_snapshot(m2, garbage),
+		std::invalid_argument
+	);
+
+	// the component keys are saved last, followed by zero padding
+	std::size_t last = snapshot.size()-8;
+	while(snapshot.compare(last, 8, std::string(8, '\0')) == 0) last -= 8;
+
+	// truncated in the middle and inside the component keys
+	const std::size_t cuts[2] = { snapshot.size()/2, last+4 };
+	for(std::size_t cut : cuts)
+	{
+		std::stringstream truncated(snapshot.substr(0, cut));
+		exces::manager<> m3;
+		BOOST_CHECK_THROW(
+			exces::load_snapshot(m3, truncated),
+			std::runtime_error
+		);
+		check_empty(m3);
+	}
+
+	// the last non-zero key is made out of range
+	std::string corrupt = snapshot;
+	std::fill(corrupt.begin()+last, corrupt.begin()+last+8, char(0x7F));
+	std::stringstream bad_key(corrupt);
+	exces::manager<> m4;
+	BOOST_CHECK_THROW(
+		exces::load_snapshot(m4, bad_key),
+		std::invalid_argument
+	);
+	check_empty(m4);
+
+	// a valid snapshot can be loaded after a failed one
+	std::stringstream valid(snapshot);
+	BOOST_CHECK_NO_THROW(exces::load_snapshot(m4, valid));
+	check_equal(m1, m4, e);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,87 @@
+/**
+ *  .file test/exces/stats.cpp
+ *  .brief Test case for manager operation statistics
+ *
+ *  .author Matus Chochlik
+ *
+ *  Copyright 2011-2014 Matus Chochlik. Distributed under the Boost
+ *  Software License, Version 1.0. (See accompanying file
+ *  LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE EXCES_Stats
+#include <boost/test/unit_test.hpp>
+
+#define EXCES_MANAGER_STATS 1
+
+#include <exces/simple.hpp>
+
+#include <thread>
+#include <vector>
+#include <map>
+
+struct c1 { int i; };
+EXCES_REG_COMPONENT(c1)
+EXCES_REG_COMPONENT_NAME(c1)
+
+#include <exces/implement.hpp>
+
+static std::map<std::string, std::uint64_t> stats_counts(void)
+{
+	std::map<std::string, std::uint64_t> result;
+	for(const exces::manager_stats_record& r : exces::manager_stats::snapshot())
+	{
+		result[r.name] = r.count;
+	}
+	return result;
+}
+
+BOOST_AUTO_TEST_SUITE(Stats)
+
+BOOST_AUTO_TEST_CASE(Stats_manager_operations)
+{
+	exces::manager_stats::reset();
+
+	const std::size_t n = 10;
+	std::vector<exces::entity<>::type> e(n);
+	exces::manager<> m;
+	exces::collection<> with_c1(m, exces::entity_with<c1>());
+	with_c1.set_name("with_c1");
+
+	for(std::size_t i=0; i!=n; ++i)
+	{
+		m.add(e[i], c1());
+	}
+	// operations done in other threads are aggregated too
+	std::thread t(
+		[&m, &e](void) -> void
+		{
+			m.remove<c1>(e[0]);
+			m.remove<c1>(e[1]);
+		}
+	);
+	t.join();
+	m.replace(e[2], c1());
+	with_c1.for_each(
+		[](
+			const exces::iter_info&,
+			exces::manager<>&,
+			exces::manager<>::entity_key
+		) -> bool { return true; }
+	);
+
+	auto counts = stats_counts();
+	BOOST_CHECK_EQUAL(counts["manager::add"], n);
+	BOOST_CHECK_EQUAL(counts["manager::remove"], 2);
+	BOOST_CHECK_EQUAL(counts["manager::replace"], 1);
+	BOOST_CHECK_EQUAL(counts["c1::store"], n);
+	BOOST_CHECK_EQUAL(counts["c1::release"], 2);
+	BOOST_CHECK_EQUAL(counts["with_c1::begin_update"], n+3);
+	BOOST_CHECK_EQUAL(counts["with_c1::finish_update"], n+3);
+	BOOST_CHECK_EQUAL(counts["with_c1::for_each"], 1);
+
+	exces::manager_stats::reset();
+	BOOST_CHECK(exces::manager_stats::snapshot().empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,119 @@
+/**
+ *  .file test/exces/storage.cpp
+ *  .brief Test case for the component storage kinds
+ *
+ *  .author Matus Chochlik
+ *
+ *  Copyright 2011-2014 Matus Chochlik. Distributed under the Boost
+ *  Software License, Version 1.0. (See accompanying file
+ *  LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE EXCES_Storage
+#include <boost/test/unit_test.hpp>
+
+#include <exces/simple.hpp>
+
+#include <vector>
+#include <stdexcept>
+
+struct big { double x[4]; };
+EXCES_REG_MAPPED_COMPONENT(big)
+
+struct small { int i; };
+EXCES_REG_MAPPED_COMPONENT(small)
+
+namespace exces {
+
+// limit the storage of small to (a little over) 2MB
+template <>
+struct component_mapping<small>
+{
+	static std::size_t reserved_bytes(void)
+	{
+		return 1;
+	}
+
+	static bool huge_pages(void)
+	{
+		return false;
+	}
+};
+
+} // namespace exces
+
+#include <exces/implement.hpp>
+
+BOOST_AUTO_TEST_SUITE(Storage)
+
+BOOST_AUTO_TEST_CASE(Mapped_component)
+{
+	const std::size_t n = 100000;
+	std::vector<exces::entity<>::type> e(n);
+	exces::manager<> m;
+
+	big b0 = { { 0, 0, 0, 0 } };
+	m.add(e[0], b0);
+	const big* first = &m.rw<big>(e[0]);
+
+	for(std::size_t i=1; i!=n; ++i)
+	{
+		big b = { { double(i), 0, 0, 0 } };
+		m.add(e[i], b);
+	}
+	// growing the storage does not relocate the instances
+	BOOST_CHECK_EQUAL(first, &m.rw<big>(e[0]));
+
+	double sum = 0;
+	m.for_each<big>(
+		[&sum](big& b) -> bool
+		{
+			sum += b.x[0];
+			return true;
+		}
+	);
+	BOOST_CHECK_EQUAL(sum, double(n)*double(n-1)/2);
+
+	exces::manager_memory_stats before = m.memory_stats();
+	for(std::size_t i=n/2; i!=n; ++i)
+	{
+		m.remove<big>(e[i]);
+	}
+	BOOST_CHECK(m.shrink_to_fit() > 0);
+	exces::manager_memory_stats after = m.memory_stats();
+	BOOST_CHECK(after.total_bytes() < before.total_bytes());
+
+	BOOST_CHECK_EQUAL(first, &m.rw<big>(e[0]));
+	for(std::size_t i=0; i!=n/2; ++i)
+	{
+		BOOST_CHECK_EQUAL(m.rw<big>(e[i]).x[0], double(i));
+	}
+	for(std::size_t i=n/2; i!=n; ++i)
+	{
+		big b = { { double(i), 1, 0, 0 } };
+		m.add(e[i], b);
+	}
+	for(std::size_t i=n/2; i!=n; ++i)
+	{
+		BOOST_CHECK_EQUAL(m.rw<big>(e[i]).x[1], 1.0);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(Mapped_component_limit)
+{
+#if EXCES_USE_MMAP
+	const std::size_t n = (std::size_t(2) << 20)/sizeof(small);
+	std::vector<exces::entity<>::type> e(n+1);
+	exces::manager<> m;
+
+	for(std::size_t i=0; i!=n; ++i)
+	{
+		small s = { int(i) };
+		m.add(e[i], s);
+	}
+	small s = { 0 };
+	BOOST_CHECK_THROW(m.add(e[n], s), std::length_error);
+#endif
+}
+
+BOOST_AUTO_TEST_SUITE_END()
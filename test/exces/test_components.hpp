@@ -0,0 +1,147 @@
+/**
+ *  .file test/exces/test_components.hpp
+ *  .brief Components and helpers shared by the manager state test cases
+ *
+ *  .author Matus Chochlik
+ *
+ *  Copyright 2011-2014 Matus Chochlik. Distributed under the Boost
+ *  Software License, Version 1.0. (See accompanying file
+ *  LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+#ifndef EXCES_TEST_COMPONENTS_1406021140_HPP
+#define EXCES_TEST_COMPONENTS_1406021140_HPP
+
+#include <boost/test/unit_test.hpp>
+
+#include <exces/simple.hpp>
+#include <exces/snapshot.hpp>
+
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// the components are registered in the default group before
+// the components of the individual test cases, the helpers
+// are templates so that the manager is not instantiated before
+// all components are registered
+
+struct position { float x, y; };
+EXCES_REG_COMPONENT(position)
+
+struct color
+{
+	int rgb;
+
+	friend bool operator == (const color& a, const color& b)
+	{
+		return a.rgb == b.rgb;
+	}
+
+	friend bool operator < (const color& a, const color& b)
+	{
+		return a.rgb < b.rgb;
+	}
+};
+EXCES_REG_FLYWEIGHT_COMPONENT(color)
+
+struct label
+{
+	std::string str;
+
+	friend bool operator == (const label& a, const label& b)
+	{
+		return a.str == b.str;
+	}
+};
+EXCES_REG_COMPONENT(label)
+
+namespace exces {
+
+template <>
+struct snapshot_serializer<label>
+{
+	static void write(std::ostream& output, const label& l)
+	{
+		output << l.str.size() << ' ' << l.str;
+	}
+
+	static label read(std::istream& input)
+	{
+		std::size_t size = 0;
+		input >> size;
+		input.get();
+		label result;
+		result.str.resize(size);
+		input.read(&result.str[0], std::streamsize(size));
+		return result;
+	}
+};
+
+} // namespace exces
+
+// adds a position to all entities, a color to every third
+// and a label to every fifth entity
+template <typename Manager, typename Entity>
+void populate(Manager& m, const std::vector<Entity>& e)
+{
+	for(std::size_t i=0; i!=e.size(); ++i)
+	{
+		position p = { float(i), float(2*i) };
+		m.add(e[i], p);
+		if(i % 3 == 0)
+		{
+			color c = { int(i % 4) };
+			m.add(e[i], c);
+		}
+		if(i % 5 == 0)
+		{
+			label l = { "entity #"+std::to_string(i) };
+			m.add(e[i], l);
+		}
+	}
+}
+
+// checks that the entities have the same shared components in a and b
+template <typename Manager, typename Entity>
+void check_equal(Manager& a, Manager& b, const std::vector<Entity>& e)
+{
+	for(std::size_t i=0; i!=e.size(); ++i)
+	{
+		BOOST_CHECK_EQUAL(
+			a.template has<position>(e[i]),
+			b.template has<position>(e[i])
+		);
+		BOOST_CHECK_EQUAL(
+			a.template has<color>(e[i]),
+			b.template has<color>(e[i])
+		);
+		BOOST_CHECK_EQUAL(
+			a.template has<label>(e[i]),
+			b.template has<label>(e[i])
+		);
+		if(a.template has<position>(e[i]))
+		{
+			BOOST_CHECK_EQUAL(
+				a.template rw<position>(e[i]).x,
+				b.template rw<position>(e[i]).x
+			);
+		}
+		if(a.template has<color>(e[i]))
+		{
+			BOOST_CHECK_EQUAL(
+				a.template rw<color>(e[i]).rgb,
+				b.template rw<color>(e[i]).rgb
+			);
+		}
+		if(a.template has<label>(e[i]))
+		{
+			BOOST_CHECK_EQUAL(
+				a.template rw<label>(e[i]).str,
+				b.template rw<label>(e[i]).str
+			);
+		}
+	}
+}
+
+#endif //include guard